@@ -11,6 +11,7 @@
 
 #include "gazebo_rsv_balance/gazebo_rsv_balance.h"
 
+#include <fstream>
 #include <string>
 #include <map>
 
@@ -21,6 +22,18 @@
 #include <time.h>
 #include <cmath>
 #include <algorithm>
+#include <memory>
+
+#include <rl/q_table.hpp>
+#include <rl/q_value.hpp>
+#include <rl/random.hpp>
+#include <rl/action_selection.hpp>
+#include <rl/checkpoint.hpp>
+#include <rl/counted_q_table.hpp>
+#include <rl/discretize.hpp>
+#include <rl/trace.hpp>
+#include <rl/dyna_model.hpp>
+#include <rl/training.hpp>
 
 #define RL_DELTA 0.05
 #define FREQ 20
@@ -30,6 +43,28 @@
 
 // 2D state space
 #define STATE_NUM 9
+// Dyna-Q updates from the model of past transitions after every real one, 0 turns planning off
+#ifndef PLANNING_STEPS
+#define PLANNING_STEPS 10
+#endif
+// learning rate 1 / visits^RATE_EXPONENT of each state action pair, down to MIN_ALPHA. 0 keeps alpha
+// throughout, the default as on the robot: with epsilon greedy exploration the decaying rate learned slower
+// than the constant one (countGridWorld)
+#ifndef RATE_EXPONENT
+#define RATE_EXPONENT 0
+#endif
+// well below alpha, or the schedule is over after a handful of visits
+#ifndef MIN_ALPHA
+#define MIN_ALPHA 0.02
+#endif
+// weight of the UCB bonus when actions are picked by visit counts, 0 explores epsilon greedy
+#ifndef UCB_C
+#define UCB_C 0
+#endif
+// episodes between checkpoints, when the checkpointFile parameter is set
+#ifndef CHECKPOINT_EVERY
+#define CHECKPOINT_EVERY 10
+#endif
 char phi_states[STATE_NUM] = {-9, -6, -3, -1.5, 0, 1.5, 3, 6, 9};
 char phi_d_states[STATE_NUM] = {-30,-20, -10,-5, 0, 5, 10, 20,30};
 
@@ -50,26 +85,34 @@ class reinforcement_learning
     float pitch_dot;
     float prev_pitch;
     rsv_balance_msgs::State msg;
+    random_engine rng;
 
     char actions[ACTIONS] = {-80,-60,-40,-20,20,40,60, 80};
     int rewards[STATES] = {0,50,100,1000,1000,100,50,0};
     reinforcement_learning();
     ~reinforcement_learning();
 
-    std::vector<std::vector<float> > Q;
+    CountedQTable<(STATE_NUM+1)*(STATE_NUM+1), ACTIONS, q_value_t> Q;
+    dyna_model model;
+    // every real transition and its TD error, when the traceFile parameter is set
+    trace_writer trace;
 
     char virtual choose_action(char) = 0;
     void TD_update(char, char, char, int);
     char get_state(float, float);
     char get_next_state(float,float, char);
     int get_reward(char);
+    void save(checkpoint &) const;
+    bool load(const checkpoint &);
 };
 
 reinforcement_learning::reinforcement_learning()
-  :  Q((STATE_NUM+1)*(STATE_NUM+1), std::vector<float>(ACTIONS,0)), 
+  :  Q(0), 
      episode_num(0), time_steps(0), wins(0),
      loses(0), discount_factor(0.3), alpha(0.3),
-     epsilon(0.3), pitch_dot(0.0), prev_pitch(0.0)
+     epsilon(0.3), pitch_dot(0.0), prev_pitch(0.0),
+     rng(time(NULL)),
+     model((STATE_NUM+1)*(STATE_NUM+1), ACTIONS)
 {
 }
 
@@ -114,6 +157,50 @@ char reinforcement_learning::choose_action(char)
 {
 }
 
+/**
+  Fill snapshot with the table, the model, the engines and the counters, at the end of an episode
+*/
+void reinforcement_learning::save(checkpoint &snapshot) const
+{
+  run_state run = {(uint64_t)episode_num, 0, (uint32_t)wins, (uint32_t)loses, epsilon, alpha};
+  snapshot.clear();
+  snapshot.add(CHECKPOINT_RUN, &run, sizeof(run));
+  snapshot.addTable(CHECKPOINT_Q, Q);
+  snapshot.addVisits(CHECKPOINT_VISITS, Q);
+  snapshot.addEngine(CHECKPOINT_AGENT_RNG, rng);
+  model.save(snapshot);
+}
+
+/**
+  Go on from a snapshot filled by save. Returns false if it is not of this controller, which is then left
+  as it was: every section is restored into a copy first
+*/
+bool reinforcement_learning::load(const checkpoint &snapshot)
+{
+  run_state run;
+  CountedQTable<(STATE_NUM+1)*(STATE_NUM+1), ACTIONS, q_value_t> table(Q);
+  random_engine engine = rng;
+  dyna_model restored_model = model;
+  if (!snapshot.get(CHECKPOINT_RUN, &run, sizeof(run)) || !snapshot.getTable(CHECKPOINT_Q, table) ||
+      !snapshot.getVisits(CHECKPOINT_VISITS, table) || !snapshot.getEngine(CHECKPOINT_AGENT_RNG, engine) ||
+      !restored_model.load(snapshot))
+  {
+    return false;
+  }
+  Q = table;
+  rng = engine;
+  model = restored_model;
+  episode_num = run.episode;
+  wins = run.wins;
+  loses = run.loses;
+  epsilon = run.epsilon;
+  alpha = run.alpha;
+  msg.episodes = episode_num;
+  msg.wins = wins;
+  msg.loses = loses;
+  return true;
+}
+
 void reinforcement_learning::TD_update(char curr_state, char action, char next_state, int reward)
 {
   int max_action_idx;
@@ -121,39 +208,27 @@ void reinforcement_learning::TD_update(char curr_state, char action, char next_s
   float td_error;
 
   //next_state_idx = get_state_index(next_state);
-  max_action_idx = distance(Q[next_state].begin(), max_element(Q[next_state].begin(), Q[next_state].end()));
+  max_action_idx = Q.argmax(next_state);
   td_target = reward + discount_factor*Q[next_state][max_action_idx];
   td_error = td_target - Q[curr_state][action];
-  Q[curr_state][action]+= td_error*alpha;
+  unsigned int visits = Q.visit(curr_state, action);
+  float rate = RATE_EXPONENT > 0 ? visitRate(visits, RATE_EXPONENT, MIN_ALPHA) : alpha;
+  Q[curr_state][action]+= td_error*rate;
+  if (trace.isOpen())
+  {
+    trace.record(time_steps, curr_state, action, reward, next_state, td_error, false);
+  }
 
+  // remember the transition and replay past ones, simulated steps are cheaper than real ones. The replayed
+  // updates take the rate of this real one so planning does not outweigh the decaying real updates
+  td_parameters params = {rate, discount_factor};
+  model.observe(curr_state, action, next_state, reward, false);
+  model.plan(Q, PLANNING_STEPS, params);
 }
 
 char reinforcement_learning::get_state(float pitch, float pitch_dot)
 {
-  char i, j;
-  for (char phi_idx = 0; phi_idx < STATE_NUM; phi_idx++)
-  {
-    if (pitch <= phi_states[phi_idx])
-    {
-      i = phi_idx;
-      break;
-    }else if (pitch > phi_states[STATE_NUM])
-    {
-      i = STATE_NUM;
-    }
-   }
-  for (char phi_d_idx = 0; phi_d_idx < STATE_NUM; phi_d_idx++)
-  {
-    if (pitch_dot <= phi_d_states[phi_d_idx])
-    {
-      j = phi_d_idx;
-      break;
-    }else if (pitch_dot > phi_d_states[STATE_NUM])
-    {
-      j = STATE_NUM;
-    }
-  }
-  return( j + (STATE_NUM + 1) * i);
+  return pitchState(pitch, pitch_dot, phi_states, phi_d_states);
 }
 
 
@@ -205,16 +280,12 @@ class q_learning: public reinforcement_learning
   public:
     q_learning();
     ~q_learning();
-    std::vector<float> q_row;
-    std::vector<int> max_value_idxs;
-
     char choose_action(char);
     void take_action(int);
 };
 
 q_learning::q_learning()
 {
-    this->q_row.resize(6);
 }
 
 q_learning::~q_learning()
@@ -223,55 +294,32 @@ q_learning::~q_learning()
 
 char q_learning::choose_action(char curr_state)
 {
-  int random_choice;
   float random_num;
-  float max_q;
-  int action_choice;
+  float scratch[ACTIONS];
 
-  random_num = fabs((rand()/(float)(RAND_MAX)));	//random num between 0 and 1
+  if (UCB_C > 0)
+  {
+    //pick by value and how rarely each action was tried here
+    return ucbAction(allActions(ACTIONS), rowView(Q, curr_state, scratch), Q.visits(curr_state), UCB_C, rng);
+  }
 
+  random_num = rng.uniform();	//random num between 0 and 1
 
-  
   if (random_num < epsilon)
   {
     //pick randomly
-    random_choice = rand()%ACTIONS;
-    return random_choice;
-  }
-  else
-  {
-    //pick best
-    this->q_row = Q[curr_state];
-
-    max_q = *std::max_element(q_row.begin(), q_row.end());
-    for (int i = 0; i < q_row.size(); i++)
-      {
-        if (max_q == q_row[i])
-          {
-            max_value_idxs.push_back(i);     
-	  }
-      }
-    if (max_value_idxs.size() == 1)
-      {
-	action_choice = max_value_idxs[0];
-        max_value_idxs.clear();
-	return max_value_idxs[0];
-      }
-	else if (max_value_idxs.size() > 1)
-      { 
-//	ROS_INFO("random choice for repeated bests");
-//	ROS_INFO("size: %d", max_value_idxs.size());
-        action_choice = rand()%(max_value_idxs.size());
-	max_value_idxs.clear();
-//	ROS_INFO("rnadom choice is: %d", action_choice);
-        return action_choice;
-      }
+    return rng.below(ACTIONS);
   }
+  //pick best, randomly between repeated bests
+  return maskedArgmax(allActions(ACTIONS), rowView(Q, curr_state, scratch), rng);
 }
 
 
 
 q_learning controller;
+// saves the controller from a thread of its own, set up in Load when there is a checkpoint file
+checkpoint snapshot;
+std::unique_ptr<checkpoint_writer> checkpoints;
 
 namespace gazebo
 {
@@ -337,6 +385,53 @@ void GazeboRsvBalance::Load(physics::ModelPtr _parent, sdf::ElementPtr _sdf)
     ROS_WARN("RsvBalancePlugin - Update rate < 0. Update period set to: 0.1. ");
     this->update_period_ = 0.1;
   }
+
+  // Seed the RL controller, a fixed rlSeed replays the same exploration
+  int rl_seed;
+  this->gazebo_ros_->getParameter<int>(rl_seed, "rlSeed", (int)time(NULL));
+  controller.rng.seed(rl_seed);
+  controller.model.seed(rl_seed, 1);
+
+  // Go on from the last checkpoint, and keep writing them, when a checkpoint file is given
+  std::string checkpoint_file;
+  this->gazebo_ros_->getParameter<std::string>(checkpoint_file, "checkpointFile", "");
+  if (!checkpoint_file.empty())
+  {
+    if (snapshot.read(checkpoint_file) && controller.load(snapshot))
+    {
+      ROS_INFO("RsvBalancePlugin - resuming from %s after %d episodes", checkpoint_file.c_str(),
+               controller.episode_num);
+    }
+    else if (std::ifstream(checkpoint_file.c_str()))
+    {
+      ROS_WARN("RsvBalancePlugin - %s is not a checkpoint of this controller, starting a new run without "
+               "checkpoints so it is not overwritten", checkpoint_file.c_str());
+      checkpoint_file.clear();
+    }
+    else
+    {
+      ROS_INFO("RsvBalancePlugin - no checkpoint to resume in %s, starting a new run", checkpoint_file.c_str());
+    }
+    if (!checkpoint_file.empty())
+    {
+      checkpoints.reset(new checkpoint_writer(checkpoint_file));
+    }
+  }
+
+  // Trace every transition for offline analysis, a new trace every time the plugin is loaded
+  std::string trace_file;
+  this->gazebo_ros_->getParameter<std::string>(trace_file, "traceFile", "");
+  if (!trace_file.empty())
+  {
+    if (controller.trace.open(trace_file))
+    {
+      controller.trace.beginEpisode(controller.episode_num);
+    }
+    else
+    {
+      ROS_WARN("RsvBalancePlugin - cannot create trace %s", trace_file.c_str());
+    }
+  }
   this->last_update_time_ = this->parent_->GetWorld()->GetSimTime();
   // Variable that control RL algorithm updates
   //this->rl_update_time = this->parent_->GetWorld()->GetSimTime();
@@ -675,6 +770,12 @@ void GazeboRsvBalance::UpdateChild()
 	  controller.time_steps = 0;
 	  controller.prev_pitch = 0;
 	  controller.pitch_dot = 0;
+	  controller.trace.beginEpisode(controller.episode_num);
+	  if (checkpoints && controller.episode_num % CHECKPOINT_EVERY == 0)
+	  {
+	    controller.save(snapshot);
+	    checkpoints->submit(snapshot);
+	  }
 	}
 	this->restart_delta_prev = this->restart_delta;
 	
@@ -5,6 +5,7 @@
  *
  *  Modifications made by Alex Cornelio: 
  *  - control segway about pitch angle using a SARSA controller
+ *  - SARSA(lambda): TD errors are applied through eligibility traces
  *********************************************************************/
 
 #include "gazebo_rsv_balance/gazebo_rsv_balance.h"
@@ -20,6 +21,12 @@
 #include <cmath>
 #include <algorithm>
 
+#include <rl/q_table.hpp>
+#include <rl/q_value.hpp>
+#include <rl/random.hpp>
+#include <rl/discretize.hpp>
+#include <rl/eligibility_traces.hpp>
+
 #define REFERENCE_PITCH 0.0
 #define PITCH_THRESHOLD 5.5 
 #define RL_DELTA 0.04
@@ -29,6 +36,10 @@
 char actions[ACTIONS] = {-53, -26, -13, 0, 13, 26, 53};	
 #define WHEEL_RADIUS 0.19
 #define MAX_EPISODE 40
+// trace decay of SARSA(lambda), 0 is one step SARSA
+#ifndef LAMBDA
+#define LAMBDA 0.8
+#endif
 
 // 2D state space
 #define STATE_NUM_PHI 9
@@ -54,6 +65,7 @@ class reinforcement_learning
     char current_state;
     char next_state;
     rsv_balance_msgs::State msg;
+    random_engine rng;
     char action;
     char action_idx;
     float reward_per_ep;
@@ -61,7 +73,8 @@ class reinforcement_learning
     reinforcement_learning();
     ~reinforcement_learning();
 
-    std::vector<std::vector<float> > Q;
+    QTable<(STATE_NUM_PHI+1)*(STATE_NUM_PHI_D+1), ACTIONS, q_value_t> Q;
+    eligibility_traces traces;
 
     char virtual choose_action(char) = 0;
     void TD_update(char, char, char, char, float);
@@ -70,11 +83,12 @@ class reinforcement_learning
 };
 
 reinforcement_learning::reinforcement_learning()
-  :  Q((STATE_NUM_PHI+1)*(STATE_NUM_PHI_D+1), std::vector<float>(ACTIONS,0)), 
+  :  Q(0), 
      episode_num(0), time_steps(0), wins(0),
      loses(0), discount_factor(0.3), alpha(0.4),
      epsilon(0.6), pitch_dot(0.0), prev_pitch(0.0),
-     reward_per_ep(0.0)
+     reward_per_ep(0.0), rng(time(NULL)),
+     traces((STATE_NUM_PHI+1)*(STATE_NUM_PHI_D+1), ACTIONS)
 {
 }
 
@@ -106,10 +120,12 @@ void reinforcement_learning::TD_update(char curr_state, char action_current, cha
   float td_error;
   float Q_val;
   
-  // compute update and write to Q at current state
+  // compute update and write it to Q of every state action pair with a trace, so the
+  // reward of a fall reaches the steps that led to it at once
   td_target = reward + discount_factor*Q[next_state][action_next];
   td_error = td_target - Q[curr_state][action_current];
-  Q[curr_state][action_current]+= td_error*alpha;
+  traces.visit(curr_state, action_current);
+  traces.update(Q, td_error*alpha, discount_factor*LAMBDA);
  
   // add more data 
   msg.max_action_idx = max_action_idx;
@@ -122,37 +138,7 @@ void reinforcement_learning::TD_update(char curr_state, char action_current, cha
 
 char reinforcement_learning::get_state(float pitch, float pitch_dot)
 {
-  char i, j;
-  i = 0;
-  j = 0;
-
-  for (char phi_idx = 0; phi_idx < STATE_NUM_PHI; phi_idx++)
-  {
-    if (pitch <= phi_states[phi_idx])
-    {
-      i = phi_idx;
-      break;
-    }else if (pitch > phi_states[STATE_NUM_PHI - 1])
-    {
-      i = STATE_NUM_PHI;
-      break;
-     }
-   }
-
-  for (char phi_d_idx = 0; phi_d_idx < STATE_NUM_PHI_D; phi_d_idx++)
-  {
-    if (pitch_dot <= phi_d_states[phi_d_idx])
-    {
-      j = phi_d_idx;
-      break;
-    }else if (pitch_dot > phi_d_states[STATE_NUM_PHI_D - 1])
-    {
-      j = STATE_NUM_PHI_D;
-      break;
-    }
- }
- 
-  return( j + (STATE_NUM_PHI_D + 1) * i);
+  return pitchState(pitch, pitch_dot, phi_states, phi_d_states);
 }
 
 
@@ -188,14 +174,14 @@ char sarsa::choose_action(char curr_state)
   int action_choice;
 
   // generate random number to decide whether to explore or exploit
-  random_num = fabs((rand()/(float)(RAND_MAX)));	//random num between 0 and 1
+  random_num = rng.uniform();	//random num between 0 and 1
   ROS_INFO("random num: %f", random_num);
   msg.action_choice = random_num;
   
   if (random_num < epsilon)
   {
     //pick randomly
-    random_choice = rand()%ACTIONS;
+    random_choice = rng.below(ACTIONS);
     ROS_INFO("random action choice: %d", random_choice);
     msg.random_action = random_choice;
     return random_choice;
@@ -205,7 +191,7 @@ char sarsa::choose_action(char curr_state)
     //pick best
     msg.random_action = 50;
     ROS_INFO("picks best");
-    this->q_row = Q[curr_state];
+    this->q_row.assign(Q[curr_state], Q[curr_state] + ACTIONS);
 
     max_q = *std::max_element(q_row.begin(), q_row.end());
     ROS_INFO("max_q: %f", max_q);    
@@ -303,6 +289,11 @@ void GazeboRsvBalance::Load(physics::ModelPtr _parent, sdf::ElementPtr _sdf)
     ROS_WARN("RsvBalancePlugin - Update rate < 0. Update period set to: 0.1. ");
     this->update_period_ = 0.1;
   }
+
+  // Seed the RL controller, a fixed rlSeed replays the same exploration
+  int rl_seed;
+  this->gazebo_ros_->getParameter<int>(rl_seed, "rlSeed", (int)time(NULL));
+  controller.rng.seed(rl_seed);
   this->last_update_time_ = this->parent_->GetWorld()->GetSimTime();
   // Variable that control RL algorithm updates
   //this->rl_update_time = this->parent_->GetWorld()->GetSimTime();
@@ -648,6 +639,7 @@ void GazeboRsvBalance::UpdateChild()
 	  controller.prev_pitch = 0;
 	  controller.pitch_dot = 0;
 	  controller.reward_per_ep = 0;
+	  controller.traces.clear();
 
 	  //clear message
 	  controller.msg.pitch = 0;
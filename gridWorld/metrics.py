@@ -0,0 +1,58 @@
+# Reader of the binary metrics files the examples write (src/rl/metrics.hpp).
+# load(path) returns the records as one array per field, plus the sampling they were written with:
+#	metrics = load("sweep.bin")
+#	plt.plot(metrics["episode"], metrics["wins"])
+# The arrays are numpy arrays when numpy is installed, array.array otherwise.
+import struct
+import sys
+from array import array
+
+MAGIC = b"RLMETR01"
+HEADER = struct.Struct("=8sII")
+CHUNK = struct.Struct("=II")
+RECORD = struct.Struct("=IIIIIIff")
+FIELDS = ("group", "run", "episode", "steps", "wins", "loses", "epsilon", "episode_return")
+TYPES = "IIIIIIff"
+
+def load(path):
+	f = open(path, "rb")
+	data = f.read()
+	f.close()
+	magic, record_bytes, sample_every = HEADER.unpack_from(data, 0)
+	if magic != MAGIC or record_bytes != RECORD.size:
+		raise ValueError("%s is not a metrics file" % path)
+
+	# the records of every whole chunk, a last chunk cut short is left out
+	at = HEADER.size
+	records = []
+	while at + CHUNK.size <= len(data):
+		count = CHUNK.unpack_from(data, at)[0]
+		at += CHUNK.size
+		if at + count * RECORD.size > len(data):
+			break
+		records.append(data[at:at + count * RECORD.size])
+		at += count * RECORD.size
+	records = b"".join(records)
+
+	try:
+		import numpy
+		dtype = numpy.dtype([(name, "u4" if kind == "I" else "f4") for name, kind in zip(FIELDS, TYPES)])
+		table = numpy.frombuffer(records, dtype=dtype)
+		metrics = dict((name, table[name]) for name in FIELDS)
+	except ImportError:
+		metrics = dict((name, array("f" if kind == "f" else "I")) for name, kind in zip(FIELDS, TYPES))
+		for values in RECORD.iter_unpack(records):
+			for name, value in zip(FIELDS, values):
+				metrics[name].append(value)
+	metrics["sample_every"] = sample_every
+	return metrics
+
+def isMetrics(path):
+	f = open(path, "rb")
+	magic = f.read(len(MAGIC))
+	f.close()
+	return magic == MAGIC
+
+if __name__ == "__main__":
+	metrics = load(sys.argv[1])
+	print("%d episodes, every %d kept" % (len(metrics["episode"]), metrics["sample_every"]))
@@ -1,11 +1,82 @@
 import sys
 import matplotlib.pyplot as plt
-import numpy as np
+
+import metrics
+
+def sweepLabel(elements, column):
+	# legend of one grid point of a sweep, from its line of the sweep output
+	return "%s a=%s g=%s e=%s d=%s %s" % (elements[column['algorithm']], elements[column['alpha']],
+		elements[column['discount_factor']], elements[column['epsilon0']], elements[column['decay']],
+		elements[column['decay_rule']])
+
+def plotSweep(label, rows):
+	# plot the wins of every grid point averaged over its trials. rows are (point, episode, wins) of every
+	# episode of every trial, label the legend of each point
+	wins = {}
+	trials = {}
+	for point, episode, won in rows:
+		wins.setdefault(point, {}).setdefault(episode, 0.0)
+		wins[point][episode] += won
+		trials.setdefault(point, {}).setdefault(episode, 0)
+		trials[point][episode] += 1
+
+	for point in sorted(wins):
+		episode_list = sorted(wins[point])
+		plt.plot(episode_list, [wins[point][e] / trials[point][e] for e in episode_list], label=label[point])
+	plt.title("Cliff World sweep")
+	plt.xlabel("Episodes")
+	plt.ylabel("Mean wins")
+	plt.legend(fancybox=True, fontsize='small')
+	plt.show()
+
+if metrics.isMetrics(sys.argv[1]):
+	# binary metrics of sarsaGridWorld_example or gridWorld_example given a metrics file: plot as the CSV below
+	episodes = metrics.load(sys.argv[1])
+	plt.plot(episodes["episode"], episodes["wins"], 'r--', episodes["episode"], episodes["loses"], 'b--')
+	plt.title("Cliff World")
+	plt.xlabel("Episodes")
+	plt.ylabel("Performance")
+	plt.legend(('Wins', 'Loses'), fancybox=True)
+	plt.show()
+	sys.exit(0)
 
 # open file
 f = open(sys.argv[1], "r")
 contents = f.readlines()
 lines = [line.rstrip('\n') for line in contents]
+
+if lines and lines[0].startswith("point,") and len(sys.argv) > 2:
+	# sweep run with --metrics: the grid points here, the episodes in the metrics file given second
+	header = lines[0].split(',')
+	column = dict((name, k) for k, name in enumerate(header))
+	label = {}
+	for i in lines[1:]:
+		elements = i.split(',')
+		label[int(elements[column['point']])] = sweepLabel(elements, column)
+
+	episodes = metrics.load(sys.argv[2])
+	plotSweep(label, [(int(point), int(episode), float(won))
+		for point, episode, won in zip(episodes["group"], episodes["episode"], episodes["wins"])])
+	sys.exit(0)
+
+if lines and lines[0].startswith("point,"):
+	# sweep output of sweepGridWorld_example: one header line, then one line per episode of every trial
+	header = lines[0].split(',')
+	column = dict((name, k) for k, name in enumerate(header))
+	label = {}
+	rows = []
+	for i in lines[1:]:
+		elements = i.split(',')
+		point = int(elements[column['point']])
+		label[point] = sweepLabel(elements, column)
+		rows.append((point, int(elements[column['episode']]), float(elements[column['wins']])))
+
+	plotSweep(label, rows)
+	sys.exit(0)
+
+# output of a single run of sarsaGridWorld_example, or a metrics file converted by metricsToCsv
+if lines and lines[0].startswith("group,"):
+	lines = [",".join(i.split(',')[2:7]) for i in lines[1:]]
 episode_num = []
 time_step = []
 wins = []
@@ -20,15 +91,9 @@ for i in lines:
 	loses.append(float(elements[3]))
 	epsilon.append(elements[4])
 
-print type(episode_num)
-print  "yoo"
-
-x = np.linspace(0,len(wins))
-y = np.sin(x)
 plt.plot(episode_num,wins,'r--',  episode_num, loses,'b--')
 plt.title("Q-learning Cliff World")
 plt.xlabel("Episodes")
 plt.ylabel("Performance")
 plt.legend(('Wins', 'Loses'), fancybox=True)
 plt.show()
-
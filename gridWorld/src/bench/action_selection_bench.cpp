@@ -0,0 +1,138 @@
+/**
+    Allocation check and benchmark for action selection.
+    Counts every call to operator new while the q_learning and sarsa policies pick actions and the grid world
+    steps, and fails if a single allocation happens inside the step loop. Also fails if an illegal action
+    holding the row maximum hides a change of the greedy action from the convergence detector.
+
+    @author Alex Cornelio
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include <rl/convergence_detector.hpp>
+#include <rl/q_learning.hpp>
+#include <rl/sarsa.hpp>
+#include <examples/gridWorld.hpp>
+
+#define BENCH_STEPS 10000000
+
+typedef gridWorld<4, 3> grid_world;
+
+static long allocations = 0;
+
+void *operator new(std::size_t size)
+{
+    allocations++;
+    void *p = malloc(size);
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    free(p);
+}
+
+/**
+    Run the inner loop of the grid world drivers with the given policy. Returns allocations per step
+*/
+static double runPolicy(const char *name, RL &controller, grid_world &env, float epsilon)
+{
+    state_t state = grid_world::START_STATE;
+    long checksum = 0;
+
+    long allocations_before = allocations;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (long i = 0; i < BENCH_STEPS; i++)
+    {
+        action_mask_t available_actions = env.availableActions(state);
+        state_t state_idx = env.getStateIndex(state);
+        char action = controller.chooseAction(epsilon, available_actions, q_row_view(env.Q[state_idx], ACTIONS));
+        state_t next_state = env.nextState(action, state, available_actions);
+        signed short int reward = env.getReward(next_state);
+        state = (reward == REWARD || reward == PUNISHMENT) ? grid_world::START_STATE : next_state;
+        checksum += action;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    long step_allocations = allocations - allocations_before;
+
+    printf("%-12s epsilon %.1f  %6.2f ns/step  %ld allocations  (checksum %ld)\n",
+           name, epsilon, seconds * 1e9 / BENCH_STEPS, step_allocations, checksum);
+    return (double)step_allocations / BENCH_STEPS;
+}
+
+/**
+    Raise an illegal action of the start state above the rest of its row, then move the greedy action among
+    the legal ones. Returns true if greedyAction and the convergence detector both see only the legal ones
+*/
+static bool checkIllegalMaximum(grid_world &env)
+{
+    state_t s = env.getStateIndex(grid_world::START_STATE);
+    action_mask_t legal = env.availableActions(grid_world::START_STATE);
+    char illegal = (char)__builtin_ctz(~legal & allActions(ACTIONS));
+    char last = (char)(31 - __builtin_clz(legal));
+
+    for (int a = 0; a < ACTIONS; a++)
+    {
+        env.Q[s][a] = 0.0f;
+    }
+    env.Q[s][(int)illegal] = 10.0f;
+
+    convergence_detector detector(1, 0.0f);
+    detector.update(env.Q, s, legal, last, 1.0f);
+    detector.endEpisode();
+
+    bool passed = greedyAction(legal, q_row_view(env.Q[s], ACTIONS)) == last && detector.windowPolicyChanges() == 1;
+    printf("illegal maximum: greedy action %d, %u greedy changes\n",
+           (int)greedyAction(legal, q_row_view(env.Q[s], ACTIONS)), detector.windowPolicyChanges());
+    return passed;
+}
+
+int main()
+{
+    q_learning q_controller;
+    sarsa sarsa_controller;
+    grid_world env;
+    double allocations_per_step = 0;
+
+    q_controller.seed(1, 0);
+    sarsa_controller.seed(1, 1);
+    env.seed(1, 2);
+
+    // give the greedy branch some ties and some clear winners to chew on
+    for (int s = 0; s < grid_world::STATES; s++)
+    {
+        env.Q[s][s % ACTIONS] = 1.0f;
+    }
+
+    allocations_per_step += runPolicy("q_learning", q_controller, env, 0.0f);
+    allocations_per_step += runPolicy("q_learning", q_controller, env, 0.5f);
+    allocations_per_step += runPolicy("sarsa", sarsa_controller, env, 0.0f);
+    allocations_per_step += runPolicy("sarsa", sarsa_controller, env, 0.5f);
+
+    if (allocations_per_step != 0)
+    {
+        printf("FAIL: action selection allocated on the heap\n");
+        return 1;
+    }
+    printf("PASS: zero allocations per step\n");
+
+    if (!checkIllegalMaximum(env))
+    {
+        printf("FAIL: an illegal action hid a greedy change\n");
+        return 1;
+    }
+    printf("PASS: illegal actions never count as greedy\n");
+    return 0;
+}
@@ -0,0 +1,95 @@
+/**
+    bench_reporter methods
+    @author Alex Cornelio
+*/
+
+#include "bench.hpp"
+
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+
+/**
+    Constructor
+*/
+bench_reporter::bench_reporter()
+    : repetitions(5), scale(1.0)
+{
+}
+
+/**
+    Record a result measured outside run()
+*/
+void bench_reporter::add(const std::string &name, long iterations, double seconds)
+{
+    bench_result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.repetitions = 1;
+    result.median_ns_per_op = seconds * 1e9 / iterations;
+    result.min_ns_per_op = result.median_ns_per_op;
+    result.ops_per_second = 1e9 / result.median_ns_per_op;
+    result.cache_misses_per_op = -1;
+    results_.push_back(result);
+}
+
+/**
+    Return true if the benchmark passes the name filter
+*/
+bool bench_reporter::enabled(const std::string &name) const
+{
+    return filter.empty() || name.find(filter) != std::string::npos;
+}
+
+/**
+    Return all results as a JSON document
+*/
+std::string bench_reporter::json() const
+{
+    std::ostringstream out;
+    char timestamp[32];
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    out << "{\n";
+    out << "  \"suite\": \"rl_bench\",\n";
+    out << "  \"timestamp\": \"" << timestamp << "\",\n";
+    out << "  \"build_type\": \"" << RL_BENCH_BUILD_TYPE << "\",\n";
+    out << "  \"compiler\": \"" << __VERSION__ << "\",\n";
+    out << "  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results_.size(); i++)
+    {
+        const bench_result &r = results_[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"name\": \"" << r.name << "\""
+            << ", \"iterations\": " << r.iterations
+            << ", \"repetitions\": " << r.repetitions
+            << ", \"median_ns_per_op\": " << r.median_ns_per_op
+            << ", \"min_ns_per_op\": " << r.min_ns_per_op
+            << ", \"ops_per_second\": " << r.ops_per_second;
+        if (r.cache_misses_per_op >= 0)
+        {
+            out << ", \"cache_misses_per_op\": " << r.cache_misses_per_op;
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+    return out.str();
+}
+
+/**
+    Print a human readable table to stderr
+*/
+void bench_reporter::printTable() const
+{
+    for (std::size_t i = 0; i < results_.size(); i++)
+    {
+        const bench_result &r = results_[i];
+        fprintf(stderr, "%-40s %10.2f ns/op  %10.2f M ops/s", r.name.c_str(), r.median_ns_per_op, r.ops_per_second / 1e6);
+        if (r.cache_misses_per_op >= 0)
+        {
+            fprintf(stderr, "  %8.3f misses/op", r.cache_misses_per_op);
+        }
+        fputc('\n', stderr);
+    }
+}
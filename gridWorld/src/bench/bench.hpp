@@ -0,0 +1,127 @@
+/**
+    Minimal micro benchmark harness used by rl_bench.
+    Every kernel is run for a fixed number of iterations several times and the median and fastest repetition
+    are recorded. Results are written as JSON so runs from different releases can be diffed by a script.
+
+    @author Alex Cornelio
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "perf_counter.hpp"
+
+#ifndef RL_BENCH_BUILD_TYPE
+#define RL_BENCH_BUILD_TYPE "unknown"
+#endif
+
+/**
+    Stops the compiler from throwing away a value computed by a kernel
+*/
+template <typename T>
+inline void doNotOptimize(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+    One benchmark result
+*/
+struct bench_result
+{
+    std::string name;
+    long iterations;
+    int repetitions;
+    double median_ns_per_op;
+    double min_ns_per_op;
+    double ops_per_second;
+    double cache_misses_per_op;     // -1 when misses could not be counted
+};
+
+/**
+    Runs kernels and collects their results
+*/
+class bench_reporter
+{
+public:
+    bench_reporter();
+
+    int repetitions;
+    double scale;           // multiplies every kernel's iteration count
+    std::string filter;     // only run benchmarks whose name contains this
+
+    /**
+        Time kernel(i) for i in [0, iterations). The kernel should return something that depends on its work
+    */
+    template <typename Kernel>
+    void run(const std::string &name, long iterations, Kernel kernel);
+
+    /**
+        Record a result measured outside run(), e.g. a whole training loop
+    */
+    void add(const std::string &name, long iterations, double seconds);
+
+    bool enabled(const std::string &name) const;
+    std::string json() const;
+    void printTable() const;
+
+private:
+    std::vector<bench_result> results_;
+};
+
+template <typename Kernel>
+void bench_reporter::run(const std::string &name, long iterations, Kernel kernel)
+{
+    if (!enabled(name))
+    {
+        return;
+    }
+    iterations = std::max(1L, (long)(iterations * scale));
+
+    // one untimed pass to warm caches and branch predictors
+    for (long i = 0; i < iterations / 10; i++)
+    {
+        doNotOptimize(kernel(i));
+    }
+
+    std::vector<double> ns_per_op;
+    cache_miss_counter counter;
+    long long misses = 0;
+    for (int r = 0; r < repetitions; r++)
+    {
+        counter.start();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (long i = 0; i < iterations; i++)
+        {
+            doNotOptimize(kernel(i));
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        long long repetition_misses = counter.stop();
+        misses = (misses < 0 || repetition_misses < 0) ? -1 : misses + repetition_misses;
+        ns_per_op.push_back(seconds * 1e9 / iterations);
+    }
+    std::sort(ns_per_op.begin(), ns_per_op.end());
+
+    bench_result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.repetitions = repetitions;
+    result.median_ns_per_op = ns_per_op[ns_per_op.size() / 2];
+    result.min_ns_per_op = ns_per_op[0];
+    result.ops_per_second = 1e9 / result.median_ns_per_op;
+    result.cache_misses_per_op = misses < 0 ? -1 : (double)misses / ((double)iterations * repetitions);
+    results_.push_back(result);
+}
+
+// benchmark groups, one per source file
+void registerKernelBenchmarks(bench_reporter &reporter);
+void registerQTableBenchmarks(bench_reporter &reporter);
+void registerDispatchBenchmarks(bench_reporter &reporter);
+void registerLayoutBenchmarks(bench_reporter &reporter);
+
+#endif // BENCH_H
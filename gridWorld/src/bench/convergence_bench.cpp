@@ -0,0 +1,497 @@
+/**
+    convergence_bench: how long each learning algorithm takes to converge, over many seeds, to catch
+    regressions of the learners as a whole where rl_bench times single kernels.
+    Every case is one algorithm on one environment, run once per seed on a thread pool:
+    - gridWorld: the cliff world of the examples. A run has converged once the greedy policy is optimal in
+      every state, the planner's Q* being the ground truth. Exploration decays so SARSA gets there too.
+    - pendulum: the host model of the balancing robot (examples/pendulum.hpp). A run has converged once the
+      last PENDULUM_WINDOW episodes lasted PENDULUM_GOAL of the step limit on average.
+    For every case it reports the fraction of runs that converged and the median and interquartile range of
+    the episodes and environment steps they took, the wall time spent in the training loop and the steps
+    per second. Runs that never converge count as slower than all the others, and a figure that needs them is
+    -1. New variants are one line in CASES.
+
+    Usage: convergence_bench [--seeds 32] [--seed 1] [--threads n] [--filter name] [--json out.json]
+                             [--baseline old.json] [--tolerance 0.1] [--speed-tolerance 0.25]
+    The JSON document goes to stdout unless --json is given, a readable table goes to stderr. With a
+    baseline, written by an earlier run with the same seeds, every case is compared with it and the exit
+    status is 1 if a median of episodes or steps grew by more than the tolerance, or steps per second fell
+    by more than the speed tolerance. Episodes and steps only depend on the seeds, times on the machine.
+
+    @author Alex Cornelio
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rl/dyna_model.hpp>
+#include <rl/planner.hpp>
+#include <rl/q_learning.hpp>
+#include <rl/sarsa.hpp>
+#include <rl/thread_pool.hpp>
+#include <rl/training.hpp>
+#include <examples/gridWorld.hpp>
+#include <examples/pendulum.hpp>
+
+#ifndef RL_BENCH_BUILD_TYPE
+#define RL_BENCH_BUILD_TYPE "unknown"
+#endif
+
+// grid size, override with -DGRID_WIDTH=.. -DGRID_HEIGHT=..
+#ifndef GRID_WIDTH
+#define GRID_WIDTH 4
+#endif
+#ifndef GRID_HEIGHT
+#define GRID_HEIGHT 3
+#endif
+
+// grid world agents, the parameters of qLearningGridWorld
+#define GRID_MAX_EPISODES 1000
+#define GRID_DISCOUNT_FACTOR 0.5
+#define GRID_ALPHA 0.5
+#define GRID_EPSILON 0.5
+#define GRID_EPSILON_DECAY 0.998
+#define GRID_PLANNING_STEPS 5
+
+// pendulum agents, the parameters of precisionStudy
+#define PENDULUM_MAX_EPISODES 2000
+#define PENDULUM_MAX_STEPS 500
+#define PENDULUM_DISCOUNT_FACTOR 0.9
+#define PENDULUM_ALPHA 0.3
+#define PENDULUM_EPSILON 0.2
+#define PENDULUM_EPSILON_DECAY 0.998
+#define PENDULUM_WINDOW 100
+#define PENDULUM_GOAL 0.9
+
+// algorithms
+#define ALGORITHM_Q_LEARNING 0
+#define ALGORITHM_SARSA 1
+#define ALGORITHM_DYNA_Q 2
+
+typedef gridWorld<GRID_WIDTH, GRID_HEIGHT> grid_world;
+typedef std::chrono::steady_clock bench_clock;
+
+/**
+    Where one run got to
+*/
+struct run_outcome
+{
+    double episodes;    // until it converged, -1 if it never did
+    double steps;       // environment steps until then, or in every episode if it never converged
+    double seconds;     // in the training loop
+};
+
+/**
+    Median and quartiles of one figure over the runs, -1 where too few runs got there
+*/
+struct spread
+{
+    double median;
+    double q1;
+    double q3;
+};
+
+/**
+    Result of one case over every seed
+*/
+struct case_result
+{
+    std::string name;
+    double converged;   // fraction of the runs
+    spread episodes;
+    spread steps;
+    spread wall_ms;
+    spread steps_per_second;
+};
+
+// ground truth of the grid world cases, built once before any run
+static planner *grid_optimal = NULL;
+
+/**
+    One grid world run of Algorithm with Policy choosing the actions
+*/
+template <class Policy, int Algorithm>
+static run_outcome gridRun(unsigned long long seed)
+{
+    std::unique_ptr<grid_world> env(new grid_world);
+    Policy controller;
+    controller.seed(seed, 0);
+    env->seed(seed, 1);
+    dyna_model model(Algorithm == ALGORITHM_DYNA_Q ? grid_world::STATES : 0, ACTIONS);
+    model.seed(seed, 2);
+    td_parameters params = {GRID_ALPHA, GRID_DISCOUNT_FACTOR};
+    float epsilon = GRID_EPSILON;
+    run_outcome outcome = {-1, 0, 0};
+
+    for (int episode = 0; episode < GRID_MAX_EPISODES; episode++)
+    {
+        bench_clock::time_point start = bench_clock::now();
+        episode_result result;
+        if (Algorithm == ALGORITHM_SARSA)
+        {
+            result = sarsaEpisode(*env, env->Q, controller, grid_world::START_STATE, epsilon, params);
+        }
+        else if (Algorithm == ALGORITHM_DYNA_Q)
+        {
+            result = dynaQEpisode(*env, env->Q, controller, model, grid_world::START_STATE, epsilon, params,
+                                  GRID_PLANNING_STEPS);
+        }
+        else
+        {
+            result = qLearningEpisode(*env, env->Q, controller, grid_world::START_STATE, epsilon, params);
+        }
+        outcome.seconds += std::chrono::duration<double>(bench_clock::now() - start).count();
+        outcome.steps += result.steps;
+        epsilon *= GRID_EPSILON_DECAY;
+
+        if (grid_optimal->policyAgreement(env->Q) >= 1.0f)
+        {
+            outcome.episodes = episode + 1;
+            break;
+        }
+    }
+    return outcome;
+}
+
+/**
+    One pendulum run of Algorithm with Policy choosing the actions
+*/
+template <class Policy, int Algorithm>
+static run_outcome pendulumRun(unsigned long long seed)
+{
+    pendulum env;
+    Policy controller;
+    controller.seed(seed, 0);
+    env.seed(seed, 1);
+    td_parameters params = {PENDULUM_ALPHA, PENDULUM_DISCOUNT_FACTOR};
+    float epsilon = PENDULUM_EPSILON;
+    std::vector<unsigned int> lengths;
+    unsigned long window_sum = 0;
+    run_outcome outcome = {-1, 0, 0};
+
+    for (int episode = 0; episode < PENDULUM_MAX_EPISODES; episode++)
+    {
+        bench_clock::time_point start = bench_clock::now();
+        episode_result result;
+        if (Algorithm == ALGORITHM_SARSA)
+        {
+            result = sarsaEpisode(env, env.Q, controller, env.reset(), epsilon, params, PENDULUM_MAX_STEPS);
+        }
+        else
+        {
+            result = qLearningEpisode(env, env.Q, controller, env.reset(), epsilon, params, PENDULUM_MAX_STEPS);
+        }
+        outcome.seconds += std::chrono::duration<double>(bench_clock::now() - start).count();
+        outcome.steps += result.steps;
+        epsilon *= PENDULUM_EPSILON_DECAY;
+
+        lengths.push_back(result.steps);
+        window_sum += result.steps;
+        if (lengths.size() > PENDULUM_WINDOW)
+        {
+            window_sum -= lengths[lengths.size() - 1 - PENDULUM_WINDOW];
+        }
+        if (lengths.size() >= PENDULUM_WINDOW &&
+            window_sum >= PENDULUM_GOAL * PENDULUM_MAX_STEPS * PENDULUM_WINDOW)
+        {
+            outcome.episodes = episode + 1;
+            break;
+        }
+    }
+    return outcome;
+}
+
+/**
+    One algorithm on one environment
+*/
+struct convergence_case
+{
+    const char *name;
+    run_outcome (*run)(unsigned long long seed);
+};
+
+static const convergence_case CASES[] = {
+    {"gridWorld/q_learning", gridRun<q_learning, ALGORITHM_Q_LEARNING>},
+    {"gridWorld/sarsa", gridRun<sarsa, ALGORITHM_SARSA>},
+    {"gridWorld/dyna_q", gridRun<q_learning, ALGORITHM_DYNA_Q>},
+    {"pendulum/q_learning", pendulumRun<q_learning, ALGORITHM_Q_LEARNING>},
+    {"pendulum/sarsa", pendulumRun<sarsa, ALGORITHM_SARSA>},
+};
+
+/**
+    Median and quartiles of values, where negative values are runs that never got there and sort last
+*/
+static spread spreadOf(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    std::size_t missing = std::count_if(values.begin(), values.end(), [](double v) { return v < 0; });
+    std::rotate(values.begin(), values.begin() + missing, values.end());
+    std::size_t reached = values.size() - missing;
+    std::size_t n = values.size();
+    // lower median, and the quartiles the same way, so every figure is a value some run had
+    std::size_t at[3] = {(n - 1) / 4, (n - 1) / 2, 3 * (n - 1) / 4};
+    double figures[3];
+    for (int k = 0; k < 3; k++)
+    {
+        figures[k] = (n > 0 && at[k] < reached) ? values[at[k]] : -1;
+    }
+    spread s = {figures[1], figures[0], figures[2]};
+    return s;
+}
+
+/**
+    Run every seed of one case on pool
+*/
+static case_result runCase(const convergence_case &c, thread_pool &pool, unsigned int seeds,
+                           unsigned long long first_seed)
+{
+    std::vector<run_outcome> outcomes(seeds);
+    for (unsigned int k = 0; k < seeds; k++)
+    {
+        pool.submit([&outcomes, &c, k, first_seed] { outcomes[k] = c.run(first_seed + k); });
+    }
+    pool.wait();
+
+    std::vector<double> episodes, steps, wall_ms, speeds;
+    unsigned int converged = 0;
+    for (unsigned int k = 0; k < seeds; k++)
+    {
+        const run_outcome &o = outcomes[k];
+        bool done = o.episodes >= 0;
+        converged += done;
+        episodes.push_back(o.episodes);
+        steps.push_back(done ? o.steps : -1);
+        wall_ms.push_back(done ? o.seconds * 1e3 : -1);
+        // the speed of every run counts, converged or not
+        speeds.push_back(o.seconds > 0 ? o.steps / o.seconds : 0);
+    }
+    case_result result;
+    result.name = c.name;
+    result.converged = seeds > 0 ? (double)converged / seeds : 0;
+    result.episodes = spreadOf(episodes);
+    result.steps = spreadOf(steps);
+    result.wall_ms = spreadOf(wall_ms);
+    result.steps_per_second = spreadOf(speeds);
+    return result;
+}
+
+static void writeSpread(std::ostringstream &out, const char *name, const spread &s)
+{
+    out << ", \"" << name << "\": {\"median\": " << s.median << ", \"q1\": " << s.q1 << ", \"q3\": " << s.q3
+        << ", \"iqr\": " << ((s.q1 >= 0 && s.q3 >= 0) ? s.q3 - s.q1 : -1) << "}";
+}
+
+/**
+    Return the results as a JSON document, one case per line
+*/
+static std::string json(const std::vector<case_result> &results, unsigned int seeds, unsigned long long first_seed)
+{
+    std::ostringstream out;
+    char timestamp[32];
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    out << "{\n";
+    out << "  \"suite\": \"convergence_bench\",\n";
+    out << "  \"timestamp\": \"" << timestamp << "\",\n";
+    out << "  \"build_type\": \"" << RL_BENCH_BUILD_TYPE << "\",\n";
+    out << "  \"compiler\": \"" << __VERSION__ << "\",\n";
+    out << "  \"seeds\": " << seeds << ",\n";
+    out << "  \"first_seed\": " << first_seed << ",\n";
+    out << "  \"cases\": [";
+    for (std::size_t i = 0; i < results.size(); i++)
+    {
+        const case_result &r = results[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"name\": \"" << r.name << "\", \"converged\": " << r.converged;
+        writeSpread(out, "episodes", r.episodes);
+        writeSpread(out, "steps", r.steps);
+        writeSpread(out, "wall_ms", r.wall_ms);
+        writeSpread(out, "steps_per_second", r.steps_per_second);
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+    return out.str();
+}
+
+/**
+    Median of figure in the line of a case in a document written by json(), -1 if it is not there
+*/
+static double baselineMedian(const std::string &line, const char *figure)
+{
+    std::string key = std::string("\"") + figure + "\": {\"median\": ";
+    std::size_t at = line.find(key);
+    return at == std::string::npos ? -1 : strtod(line.c_str() + at + key.size(), NULL);
+}
+
+/**
+    Compare results with the baseline document at path, print the changes to stderr and return the number
+    of regressions, -1 if the baseline cannot be read. Cases the baseline does not have are skipped
+*/
+static int compareBaseline(const std::vector<case_result> &results, const std::string &path, double tolerance,
+                           double speed_tolerance)
+{
+    std::ifstream file(path.c_str());
+    if (!file)
+    {
+        return -1;
+    }
+    std::vector<std::string> lines;
+    std::string line;
+    while (getline(file, line))
+    {
+        lines.push_back(line);
+    }
+
+    int regressions = 0;
+    fprintf(stderr, "\nagainst %s (regression: episodes or steps +%.0f%%, steps/s -%.0f%%)\n", path.c_str(),
+            tolerance * 100, speed_tolerance * 100);
+    for (std::size_t i = 0; i < results.size(); i++)
+    {
+        const case_result &r = results[i];
+        std::string key = "{\"name\": \"" + r.name + "\"";
+        std::vector<std::string>::const_iterator found = lines.begin();
+        while (found != lines.end() && found->find(key) == std::string::npos)
+        {
+            ++found;
+        }
+        if (found == lines.end())
+        {
+            fprintf(stderr, "%-24s not in the baseline\n", r.name.c_str());
+            continue;
+        }
+
+        double old_episodes = baselineMedian(*found, "episodes");
+        double old_steps = baselineMedian(*found, "steps");
+        double old_speed = baselineMedian(*found, "steps_per_second");
+        // a run that stops converging is a regression, one that starts is not
+        bool worse = (old_episodes >= 0 &&
+                      (r.episodes.median < 0 || r.episodes.median > old_episodes * (1 + tolerance))) ||
+                     (old_steps >= 0 && (r.steps.median < 0 || r.steps.median > old_steps * (1 + tolerance))) ||
+                     (old_speed > 0 && r.steps_per_second.median < old_speed * (1 - speed_tolerance));
+        regressions += worse;
+        fprintf(stderr, "%-24s episodes %8.0f -> %8.0f  steps %10.0f -> %10.0f  steps/s %10.3g -> %10.3g  %s\n",
+                r.name.c_str(), old_episodes, r.episodes.median, old_steps, r.steps.median, old_speed,
+                r.steps_per_second.median, worse ? "REGRESSION" : "ok");
+    }
+    return regressions;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int seeds = 32;
+    unsigned long long first_seed = 1;
+    unsigned int threads = 0;
+    std::string filter;
+    std::string json_path;
+    std::string baseline_path;
+    double tolerance = 0.1;
+    double speed_tolerance = 0.25;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seeds") == 0 && i + 1 < argc)
+        {
+            seeds = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            first_seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            json_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+        {
+            baseline_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+        {
+            tolerance = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--speed-tolerance") == 0 && i + 1 < argc)
+        {
+            speed_tolerance = atof(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--seeds n] [--seed first] [--threads n] [--filter name] [--json out.json] "
+                    "[--baseline old.json] [--tolerance x] [--speed-tolerance x]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    static grid_world env;
+    planner optimal(grid_world::STATES, ACTIONS);
+    buildModel(optimal, env);
+    optimal.valueIteration(GRID_DISCOUNT_FACTOR, 1e-3);
+    grid_optimal = &optimal;
+
+    thread_pool pool(threads > 0 ? threads : std::thread::hardware_concurrency());
+    std::vector<case_result> results;
+    fprintf(stderr, "%u seeds from %llu on %u threads. median [q1, q3], -1: too few runs converged\n", seeds,
+            first_seed, pool.size());
+    fprintf(stderr, "%-24s %9s %22s %26s %22s %26s\n", "case", "converged", "episodes", "steps", "wall ms",
+            "steps/s");
+    for (std::size_t c = 0; c < sizeof(CASES) / sizeof(CASES[0]); c++)
+    {
+        if (!filter.empty() && std::string(CASES[c].name).find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        case_result r = runCase(CASES[c], pool, seeds, first_seed);
+        results.push_back(r);
+        fprintf(stderr, "%-24s %9.2f %8.0f [%5.0f, %5.0f] %10.0f [%6.0f, %6.0f] %8.2f [%5.2f, %5.2f] "
+                "%10.3g [%6.3g, %6.3g]\n", r.name.c_str(), r.converged, r.episodes.median, r.episodes.q1, r.episodes.q3, r.steps.median,
+                r.steps.q1, r.steps.q3, r.wall_ms.median, r.wall_ms.q1, r.wall_ms.q3, r.steps_per_second.median,
+                r.steps_per_second.q1, r.steps_per_second.q3);
+    }
+
+    int regressions = 0;
+    if (!baseline_path.empty())
+    {
+        regressions = compareBaseline(results, baseline_path, tolerance, speed_tolerance);
+        if (regressions < 0)
+        {
+            fprintf(stderr, "cannot read baseline %s\n", baseline_path.c_str());
+            return 1;
+        }
+    }
+
+    std::string document = json(results, seeds, first_seed);
+    if (json_path.empty())
+    {
+        fputs(document.c_str(), stdout);
+    }
+    else
+    {
+        FILE *f = fopen(json_path.c_str(), "w");
+        if (f == NULL)
+        {
+            perror(json_path.c_str());
+            return 1;
+        }
+        fputs(document.c_str(), f);
+        fclose(f);
+    }
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+/**
+    Virtual versus static dispatch of the environment in the q-learning step.
+    The virtual path reaches the grid world and the agent only through environment& and RL&, as generic code
+    would. The static path is the step of qLearningEpisode in rl/training.hpp, where everything is inlined.
+
+    @author Alex Cornelio
+*/
+
+#include <rl/q_learning.hpp>
+#include <rl/training.hpp>
+#include <examples/gridWorld.hpp>
+
+#include "bench.hpp"
+
+#define DISPATCH_STEPS 5000000
+#define DISCOUNT_FACTOR 0.5
+#define ALPHA 0.5
+
+/**
+    Hide what p points to, so the compiler cannot devirtualize calls through it
+*/
+template <typename T>
+static T *opaque(T *p)
+{
+    asm volatile("" : "+r"(p));
+    return p;
+}
+
+template <int WIDTH, int HEIGHT>
+static void registerDispatchPair(bench_reporter &reporter, const std::string &grid)
+{
+    typedef gridWorld<WIDTH, HEIGHT> grid_world;
+    static grid_world env;
+    static q_learning controller;
+    static state_t state;
+
+    environment *virtual_env = opaque<environment>(&env);
+    RL *virtual_agent = opaque<RL>(&controller);
+    env.Q.fill(0);
+    env.seed(5, 0);
+    controller.seed(5, 1);
+    state = env.START_STATE;
+    reporter.run("dispatch/virtual/" + grid, DISPATCH_STEPS, [&](long) {
+        action_mask_t available_actions = virtual_env->availableActions(state);
+        char action = virtual_agent->chooseAction(0.5f, available_actions, q_row_view(env.Q[state], ACTIONS));
+        state_t next_state = virtual_env->nextState(action, state, available_actions);
+        signed short int reward = virtual_env->getReward(next_state);
+        float td_target = reward + DISCOUNT_FACTOR * env.Q.max(next_state);
+        float td_error = td_target - env.Q[state][(int)action];
+        env.Q[state][(int)action] += td_error * ALPHA;
+        state = (reward == REWARD || reward == PUNISHMENT) ? env.START_STATE : next_state;
+        return td_error;
+    });
+
+    env.Q.fill(0);
+    env.seed(5, 0);
+    controller.seed(5, 1);
+    state = env.START_STATE;
+    reporter.run("dispatch/static/" + grid, DISPATCH_STEPS, [&](long) {
+        char action = controller.chooseAction(0.5f, env.mask(state), q_row_view(env.Q[state], ACTIONS));
+        step_result step = env.step(state, action);
+        float td_target = step.reward + DISCOUNT_FACTOR * env.Q.max(step.next_state);
+        float td_error = td_target - env.Q[state][(int)action];
+        env.Q[state][(int)action] += td_error * ALPHA;
+        state = step.done ? env.START_STATE : step.next_state;
+        return td_error;
+    });
+
+    // whole episodes through the training loop, ns per op is per episode
+    env.Q.fill(0);
+    env.seed(5, 0);
+    controller.seed(5, 1);
+    td_parameters params = {ALPHA, DISCOUNT_FACTOR};
+    reporter.run("dispatch/static_episode/" + grid, DISPATCH_STEPS / (WIDTH * HEIGHT), [&](long) {
+        return qLearningEpisode(env, env.Q, controller, env.START_STATE, 0.5f, params).steps;
+    });
+}
+
+void registerDispatchBenchmarks(bench_reporter &reporter)
+{
+    registerDispatchPair<4, 3>(reporter, "4x3");
+    registerDispatchPair<100, 100>(reporter, "100x100");
+}
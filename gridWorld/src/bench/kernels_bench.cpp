@@ -0,0 +1,219 @@
+/**
+    Benchmarks of the kernels that run every step of a training loop: action selection, the TD update,
+    the grid world model, the pitch discretisation and the speed controller's fixed point helpers.
+
+    @author Alex Cornelio
+*/
+
+#include <vector>
+
+#include <rl/discretize.hpp>
+#include <rl/planner.hpp>
+#include <rl/q_learning.hpp>
+#include <rl/random.hpp>
+#include <examples/gridWorld.hpp>
+#include <examples/batchedGridWorld.hpp>
+#include <speedController/fixedpoint.hpp>
+
+#include "bench.hpp"
+
+#define KERNEL_STEPS 5000000
+#define SAMPLES (1 << 12)
+#define DISCOUNT_FACTOR 0.5
+#define ALPHA 0.5
+
+typedef gridWorld<4, 3> grid_world;
+
+// bins used by the robot controller
+#define STATE_NUM_PHI 11
+#define STATE_NUM_PHI_D 11
+static const float phi_states[STATE_NUM_PHI] = {-5, -3, -2, -1, -0.5, 0, 0.5, 1, 2, 3, 5};
+static const float phi_d_states[STATE_NUM_PHI_D] = {-2, -1.5, -1, -0.6, -0.2, 0, 0.2, 0.6, 1, 1.5, 2};
+
+/**
+    get_state as written in the robot controller, kept as the reference for the rl_lib version
+*/
+static int getStateReference(float pitch_, float pitch_dot_)
+{
+    int i = 0, j = 0;
+    for (int phi_idx = 0; phi_idx < STATE_NUM_PHI; phi_idx++)
+    {
+        if (pitch_ <= phi_states[phi_idx])
+        {
+            i = phi_idx;
+            break;
+        }
+        else if (pitch_ > phi_states[STATE_NUM_PHI - 1])
+        {
+            i = STATE_NUM_PHI;
+            break;
+        }
+    }
+    for (int phi_d_idx = 0; phi_d_idx < STATE_NUM_PHI_D; phi_d_idx++)
+    {
+        if (pitch_dot_ <= phi_d_states[phi_d_idx])
+        {
+            j = phi_d_idx;
+            break;
+        }
+        else if (pitch_dot_ > phi_d_states[STATE_NUM_PHI_D - 1])
+        {
+            j = STATE_NUM_PHI_D;
+            break;
+        }
+    }
+    return j + (STATE_NUM_PHI_D + 1) * i;
+}
+
+/**
+    One step of the qLearningGridWorld loop on a WIDTH x HEIGHT grid, restarting at the start state whenever an
+    episode ends. Shows how the step cost grows with the number of states
+*/
+template <int WIDTH, int HEIGHT>
+static void registerGridScaling(bench_reporter &reporter, const char *name)
+{
+    static gridWorld<WIDTH, HEIGHT> env;
+    static q_learning controller;
+    static state_t state = env.START_STATE;
+    env.seed(11, 0);
+    controller.seed(11, 1);
+
+    reporter.run(name, KERNEL_STEPS, [&](long) {
+        action_mask_t available_actions = env.availableActions(state);
+        char action = controller.chooseAction(0.5f, available_actions, q_row_view(env.Q[state], ACTIONS));
+        state_t next_state = env.nextState(action, state, available_actions);
+        signed short int reward = env.getReward(next_state);
+        float td_target = reward + DISCOUNT_FACTOR * env.Q.max(next_state);
+        float td_error = td_target - env.Q[state][(int)action];
+        env.Q[state][(int)action] += td_error * ALPHA;
+        state = (reward == REWARD || reward == PUNISHMENT) ? env.START_STATE : next_state;
+        return td_error;
+    });
+}
+
+void registerKernelBenchmarks(bench_reporter &reporter)
+{
+    random_engine rng(7);
+    static grid_world env;
+    static q_learning controller;
+    env.seed(7, 0);
+    controller.seed(7, 1);
+
+    // a spread of Q values with some ties
+    for (int s = 0; s < grid_world::STATES; s++)
+    {
+        for (int a = 0; a < ACTIONS; a++)
+        {
+            env.Q[s][a] = (float)rng.below(4);
+        }
+    }
+
+    // valid grid world states and legal actions to cycle through
+    static std::vector<state_t> states(SAMPLES), next_states(SAMPLES);
+    static std::vector<char> actions(SAMPLES);
+    static std::vector<action_mask_t> masks(SAMPLES);
+    static std::vector<float> pitches(SAMPLES), pitch_dots(SAMPLES);
+    for (int i = 0; i < SAMPLES; i++)
+    {
+        states[i] = rng.below(grid_world::STATES);
+        masks[i] = env.availableActions(states[i]);
+        actions[i] = randomAction(masks[i], rng);
+        next_states[i] = env.takeAction(actions[i], states[i]);
+        pitches[i] = rng.uniform() * 14.0f - 7.0f;
+        pitch_dots[i] = rng.uniform() * 5.0f - 2.5f;
+    }
+
+    // action selection
+    RL &policy = controller;
+    reporter.run("action_selection/q_learning/greedy", KERNEL_STEPS, [&](long i) {
+        int k = i & (SAMPLES - 1);
+        return policy.chooseAction(0.0f, masks[k], q_row_view(env.Q[env.getStateIndex(states[k])], ACTIONS));
+    });
+    reporter.run("action_selection/q_learning/epsilon_0.5", KERNEL_STEPS, [&](long i) {
+        int k = i & (SAMPLES - 1);
+        return policy.chooseAction(0.5f, masks[k], q_row_view(env.Q[env.getStateIndex(states[k])], ACTIONS));
+    });
+    reporter.run("action_selection/masked_argmax", KERNEL_STEPS, [&](long i) {
+        int k = i & (SAMPLES - 1);
+        return maskedArgmax(masks[k], q_row_view(env.Q[env.getStateIndex(states[k])], ACTIONS), rng);
+    });
+
+    // TD update exactly as in qLearningGridWorld.cpp
+    reporter.run("td_update/q_learning", KERNEL_STEPS, [&](long i) {
+        int k = i & (SAMPLES - 1);
+        state_t current_state_idx = env.getStateIndex(states[k]);
+        state_t next_state_idx = env.getStateIndex(next_states[k]);
+        signed short int reward = env.getReward(next_states[k]);
+        char max_action_idx = env.Q.argmax(next_state_idx);
+        float td_target = reward + DISCOUNT_FACTOR * env.Q[next_state_idx][(int)max_action_idx];
+        float td_error = td_target - env.Q[current_state_idx][(int)actions[k]];
+        env.Q[current_state_idx][(int)actions[k]] += td_error * ALPHA;
+        return td_error;
+    });
+
+    // grid world model
+    reporter.run("grid_world/getStateIndex", KERNEL_STEPS, [&](long i) {
+        return env.getStateIndex(states[i & (SAMPLES - 1)]);
+    });
+    reporter.run("grid_world/availableActions", KERNEL_STEPS, [&](long i) {
+        return env.availableActions(states[i & (SAMPLES - 1)]);
+    });
+    reporter.run("grid_world/nextState", KERNEL_STEPS, [&](long i) {
+        int k = i & (SAMPLES - 1);
+        return env.nextState(actions[k], states[k], masks[k]);
+    });
+
+    // the same step on bigger grids
+    registerGridScaling<4, 3>(reporter, "grid_world/q_learning_step/4x3");
+    registerGridScaling<100, 100>(reporter, "grid_world/q_learning_step/100x100");
+    registerGridScaling<1000, 1000>(reporter, "grid_world/q_learning_step/1000x1000");
+
+    // the same step for 1024 agents at once, ns per op is per agent step
+    if (reporter.enabled("grid_world/batched_step/4x3x1024"))
+    {
+        static batchedGridWorld<4, 3> batch(1024);
+        batch.seed(11);
+        long lock_steps = std::max(1L, (long)(KERNEL_STEPS / 1024 * reporter.scale));
+        for (long t = 0; t < lock_steps / 10; t++)
+        {
+            batch.step();
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (long t = 0; t < lock_steps; t++)
+        {
+            batch.step();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        reporter.add("grid_world/batched_step/4x3x1024", lock_steps * 1024, seconds);
+    }
+
+    // ground truth Q* of a 100x100 world, one op is a whole value iteration
+    if (reporter.enabled("planner/value_iteration/100x100"))
+    {
+        static gridWorld<100, 100> big_env;
+        reporter.run("planner/value_iteration/100x100", 5, [&](long) {
+            planner optimal(big_env.STATES, ACTIONS);
+            buildModel(optimal, big_env);
+            return optimal.valueIteration(0.9f, 1e-3f);
+        });
+    }
+
+    // pitch, pitch rate discretisation done in get_state
+    reporter.run("discretize/get_state_reference", KERNEL_STEPS, [&](long i) {
+        int k = i & (SAMPLES - 1);
+        return getStateReference(pitches[k], pitch_dots[k]);
+    });
+    reporter.run("discretize/pitchState", KERNEL_STEPS, [&](long i) {
+        int k = i & (SAMPLES - 1);
+        return pitchState(pitches[k], pitch_dots[k], phi_states, phi_d_states);
+    });
+
+    // speed controller fixed point helpers
+    reporter.run("fixedpoint/fp_mul", KERNEL_STEPS, [&](long i) {
+        int k = i & (SAMPLES - 1);
+        return fp_mul((fixed_point_t)(pitches[k] * 256), (fixed_point_t)(pitch_dots[k] * 256));
+    });
+    reporter.run("fixedpoint/int16_fp", KERNEL_STEPS, [&](long i) {
+        return int16_fp((int)(i & 0xffff) - 0x8000);
+    });
+}
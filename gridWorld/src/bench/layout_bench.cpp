@@ -0,0 +1,149 @@
+/**
+    Q table layout on a large grid: the default column major state numbering against Z-order (mortonIndexer).
+    With the column major numbering the east and west neighbours of a cell are a whole column of Q rows away,
+    with Z-order most neighbours are in the same cache line or page.
+    layout/td_update replays random walks of LAYOUT_WALKERS walkers, interleaved as the agents of a batch
+    would be, through the q-learning TD update alone, so the time is the time of the Q table accesses. The
+    walks are the same cells for both layouts. layout/q_learning_step is the whole step of a single walker,
+    action selection and noisy transition included. Cache misses per update are reported when the CPU
+    counters can be read.
+
+    @author Alex Cornelio
+*/
+
+#include <vector>
+
+#include <rl/action_selection.hpp>
+#include <rl/random.hpp>
+#include <examples/gridWorld.hpp>
+
+#include "bench.hpp"
+
+#define LAYOUT_STEPS 5000000
+#define LAYOUT_WIDTH 1000
+#define LAYOUT_HEIGHT 1000
+// a walker restarts at a random cell after this many steps, so the walks cover the grid
+#define WALK_STEPS 1000
+#define LAYOUT_WALKERS 64
+// transitions recorded for the replay, used round robin
+#define REPLAY_TRANSITIONS (1 << 20)
+#define DISCOUNT_FACTOR 0.5
+#define ALPHA 0.5
+
+/**
+    A walker on the grid and the number of steps until it restarts
+*/
+struct layout_walker
+{
+    int x, y;
+    int steps_left;
+};
+
+/**
+    One recorded transition, in the states of one layout
+*/
+struct layout_transition
+{
+    state_t state;
+    state_t next_state;
+    signed short int reward;
+    char action;
+    bool done;
+};
+
+/**
+    Move w to a random cell off the cliff row
+*/
+static void restart(layout_walker &w, random_engine &rng)
+{
+    w.x = rng.below(LAYOUT_WIDTH);
+    w.y = 1 + rng.below(LAYOUT_HEIGHT - 1);
+    w.steps_left = WALK_STEPS;
+}
+
+/**
+    Record the interleaved random walks of LAYOUT_WALKERS walkers. The walks depend only on the seed, so
+    every layout replays the same cells in the same order
+*/
+template <class Env>
+static void recordWalks(std::vector<layout_transition> &transitions, uint64_t seed)
+{
+    random_engine rng(seed);
+    std::vector<layout_walker> walkers(LAYOUT_WALKERS);
+    for (int i = 0; i < LAYOUT_WALKERS; i++)
+    {
+        restart(walkers[i], rng);
+    }
+    transitions.resize(REPLAY_TRANSITIONS);
+    for (int i = 0; i < REPLAY_TRANSITIONS; i++)
+    {
+        layout_walker &w = walkers[i % LAYOUT_WALKERS];
+        state_t s = Env::stateOf(w.x, w.y);
+        char action = randomAction(Env::actionMask(s), rng);
+        w.x += action == EAST ? 1 : action == WEST ? -1 : 0;
+        w.y += action == NORTH ? 1 : action == SOUTH ? -1 : 0;
+
+        layout_transition &t = transitions[i];
+        t.state = s;
+        t.action = action;
+        t.next_state = Env::stateOf(w.x, w.y);
+        t.reward = Env::rewardOf(t.next_state);
+        t.done = Env::isTerminal(t.next_state);
+        if (t.done || --w.steps_left == 0)
+        {
+            restart(w, rng);
+        }
+    }
+}
+
+template <class Indexer>
+static void registerLayout(bench_reporter &reporter, const std::string &layout)
+{
+    typedef gridWorld<LAYOUT_WIDTH, LAYOUT_HEIGHT, cliffLayout, Indexer> grid_world;
+    static grid_world env;
+    static std::vector<layout_transition> transitions;
+    std::string grid = std::to_string(LAYOUT_WIDTH) + "x" + std::to_string(LAYOUT_HEIGHT);
+
+    if (reporter.enabled("layout/td_update/" + layout + "/" + grid))
+    {
+        recordWalks<grid_world>(transitions, 13);
+        env.Q.fill(0);
+        reporter.run("layout/td_update/" + layout + "/" + grid, LAYOUT_STEPS, [&](long i) {
+            const layout_transition &t = transitions[i & (REPLAY_TRANSITIONS - 1)];
+            float td_target = t.reward + (t.done ? 0 : DISCOUNT_FACTOR * env.Q.max(t.next_state));
+            float td_error = td_target - env.Q[t.state][(int)t.action];
+            env.Q[t.state][(int)t.action] += td_error * ALPHA;
+            return td_error;
+        });
+        std::vector<layout_transition>().swap(transitions);
+    }
+
+    static random_engine rng;
+    static layout_walker walker;
+    static state_t state;
+    env.Q.fill(0);
+    env.seed(13, 0);
+    rng.seed(13, 1);
+    restart(walker, rng);
+    state = grid_world::stateOf(walker.x, walker.y);
+    reporter.run("layout/q_learning_step/" + layout + "/" + grid, LAYOUT_STEPS, [&](long) {
+        char action = randomAction(env.mask(state), rng);
+        step_result step = env.step(state, action);
+        float td_target = step.reward + (step.done ? 0 : DISCOUNT_FACTOR * env.Q.max(step.next_state));
+        float td_error = td_target - env.Q[state][(int)action];
+        env.Q[state][(int)action] += td_error * ALPHA;
+        state = step.next_state;
+        if (step.done || --walker.steps_left == 0)
+        {
+            restart(walker, rng);
+            state = grid_world::stateOf(walker.x, walker.y);
+        }
+        return td_error;
+    });
+}
+
+void registerLayoutBenchmarks(bench_reporter &reporter)
+{
+    registerLayout<columnMajorIndexer<LAYOUT_WIDTH, LAYOUT_HEIGHT> >(reporter, "column_major");
+    registerLayout<mortonIndexer<LAYOUT_WIDTH, LAYOUT_HEIGHT> >(reporter, "morton");
+}
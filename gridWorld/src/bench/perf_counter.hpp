@@ -0,0 +1,93 @@
+/**
+    Hardware cache miss counter for the benchmarks, read through perf_event_open.
+    Counting is best effort: without a PMU (most virtual machines) or with perf events disabled by
+    kernel.perf_event_paranoid the counter stays closed and the benchmarks report no miss figures.
+
+    @author Alex Cornelio
+*/
+
+#ifndef PERF_COUNTER_H
+#define PERF_COUNTER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+/**
+    Counts last level cache misses of the calling thread in user space
+*/
+class cache_miss_counter
+{
+public:
+    cache_miss_counter()
+        : fd_(-1)
+    {
+#ifdef __linux__
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    ~cache_miss_counter()
+    {
+        if (fd_ >= 0)
+        {
+            close(fd_);
+        }
+    }
+
+    /**
+        Return true if misses are being counted
+    */
+    bool available() const { return fd_ >= 0; }
+
+    /**
+        Zero the count and start counting
+    */
+    void start()
+    {
+#ifdef __linux__
+        if (fd_ >= 0)
+        {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    /**
+        Stop counting and return the misses since start, or -1 if they are not counted
+    */
+    long long stop()
+    {
+#ifdef __linux__
+        uint64_t count;
+        if (fd_ >= 0 && ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0) == 0 && read(fd_, &count, sizeof(count)) == sizeof(count))
+        {
+            return (long long)count;
+        }
+#endif
+        return -1;
+    }
+
+private:
+    int fd_;
+
+    cache_miss_counter(const cache_miss_counter &);
+    cache_miss_counter &operator=(const cache_miss_counter &);
+};
+
+#endif // PERF_COUNTER_H
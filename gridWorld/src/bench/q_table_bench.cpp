@@ -0,0 +1,176 @@
+/**
+    Benchmark of the Q table layouts.
+    Runs the same TD update and argmax kernels against the old vector of vectors Q matrix, the flat QTable, the
+    flat QTable with 16 bit values and the sparse SparseQTable. q_table/td_update/sparse_6d walks a state space with six measurements of 12 bins,
+    which is too large to allocate densely, and prints how much of it the sparse table needed.
+
+    @author Alex Cornelio
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include <rl/q_table.hpp>
+#include <rl/q_value.hpp>
+#include <rl/sparse_q_table.hpp>
+#include <rl/random.hpp>
+
+#include "bench.hpp"
+
+#define BENCH_STATES 4096
+#define BENCH_ACTIONS 7
+#define BENCH_STEPS 5000000
+#define WALK_LENGTH (1 << 16)
+#define DISCOUNT_FACTOR 0.5f
+#define ALPHA 0.5f
+// bins per measurement and measurements of the large state space
+#define BINS 12
+#define DIMENSIONS 6
+
+typedef std::vector<std::vector<float> > nested_table;
+typedef QTable<BENCH_STATES, BENCH_ACTIONS> flat_table;
+typedef SparseQTable<BENCH_ACTIONS> sparse_table;
+typedef QTable<BENCH_STATES, BENCH_ACTIONS, half_float> half_table;
+typedef QTable<BENCH_STATES, BENCH_ACTIONS, fixed16<Q_FIXED16_FRACTION_BITS> > fixed16_table;
+
+/**
+    Precomputed random walk of (state, action, next state, reward) so both layouts see the same accesses
+*/
+struct transition
+{
+    int state;
+    int action;
+    int next_state;
+    float reward;
+};
+
+static std::vector<transition> makeTransitions(int count)
+{
+    random_engine rng(1);
+    std::vector<transition> transitions(count);
+    int state = 0;
+    for (int i = 0; i < count; i++)
+    {
+        transitions[i].state = state;
+        transitions[i].action = rng.below(BENCH_ACTIONS);
+        transitions[i].next_state = rng.below(BENCH_STATES);
+        transitions[i].reward = (float)rng.below(3) - 1.0f;
+        state = transitions[i].next_state;
+    }
+    return transitions;
+}
+
+/**
+    Random walk through DIMENSIONS measurements of BINS bins, every step moves one measurement by one bin, as a
+    slowly changing robot state would. The state number is the mixed radix number of the bins
+*/
+static std::vector<transition> makeWalk(int count)
+{
+    random_engine rng(2);
+    std::vector<transition> transitions(count);
+    int bins[DIMENSIONS];
+    for (int d = 0; d < DIMENSIONS; d++)
+    {
+        bins[d] = BINS / 2;
+    }
+    int state = 0;
+    for (int d = 0; d < DIMENSIONS; d++)
+    {
+        state = state * BINS + bins[d];
+    }
+    for (int i = 0; i < count; i++)
+    {
+        int d = rng.below(DIMENSIONS);
+        bins[d] = std::min(BINS - 1, std::max(0, bins[d] + (rng.below(2) ? 1 : -1)));
+        transitions[i].state = state;
+        transitions[i].action = rng.below(BENCH_ACTIONS);
+        transitions[i].next_state = 0;
+        for (int k = 0; k < DIMENSIONS; k++)
+        {
+            transitions[i].next_state = transitions[i].next_state * BINS + bins[k];
+        }
+        transitions[i].reward = (float)rng.below(3) - 1.0f;
+        state = transitions[i].next_state;
+    }
+    return transitions;
+}
+
+void registerQTableBenchmarks(bench_reporter &reporter)
+{
+    static const std::vector<transition> transitions = makeTransitions(WALK_LENGTH);
+    static nested_table nested(BENCH_STATES, std::vector<float>(BENCH_ACTIONS, 0));
+    static flat_table flat(0);
+    static sparse_table sparse(0);
+    static half_table half(0);
+    static fixed16_table fixed(0);
+
+    // same update as the TD step in qLearningGridWorld.cpp
+    reporter.run("q_table/td_update/nested", BENCH_STEPS, [&](long i) {
+        const transition &t = transitions[i & (WALK_LENGTH - 1)];
+        int max_action_idx = std::distance(nested[t.next_state].begin(), std::max_element(nested[t.next_state].begin(), nested[t.next_state].end()));
+        float td_target = t.reward + DISCOUNT_FACTOR * nested[t.next_state][max_action_idx];
+        float td_error = td_target - nested[t.state][t.action];
+        nested[t.state][t.action] += td_error * ALPHA;
+        return td_error;
+    });
+    reporter.run("q_table/td_update/flat", BENCH_STEPS, [&](long i) {
+        const transition &t = transitions[i & (WALK_LENGTH - 1)];
+        float td_target = t.reward + DISCOUNT_FACTOR * flat.max(t.next_state);
+        float td_error = td_target - flat[t.state][t.action];
+        flat[t.state][t.action] += td_error * ALPHA;
+        return td_error;
+    });
+    reporter.run("q_table/td_update/half", BENCH_STEPS, [&](long i) {
+        const transition &t = transitions[i & (WALK_LENGTH - 1)];
+        float td_target = t.reward + DISCOUNT_FACTOR * half.max(t.next_state);
+        float td_error = td_target - half[t.state][t.action];
+        half[t.state][t.action] += td_error * ALPHA;
+        return td_error;
+    });
+    reporter.run("q_table/td_update/fixed16", BENCH_STEPS, [&](long i) {
+        const transition &t = transitions[i & (WALK_LENGTH - 1)];
+        float td_target = t.reward + DISCOUNT_FACTOR * fixed.max(t.next_state);
+        float td_error = td_target - fixed[t.state][t.action];
+        fixed[t.state][t.action] += td_error * ALPHA;
+        return td_error;
+    });
+    reporter.run("q_table/td_update/sparse", BENCH_STEPS, [&](long i) {
+        const transition &t = transitions[i & (WALK_LENGTH - 1)];
+        float td_target = t.reward + DISCOUNT_FACTOR * sparse.max(t.next_state);
+        float td_error = td_target - sparse[t.state][t.action];
+        sparse[t.state][t.action] += td_error * ALPHA;
+        return td_error;
+    });
+
+    reporter.run("q_table/argmax/nested", BENCH_STEPS, [&](long i) {
+        const std::vector<float> &row = nested[transitions[i & (WALK_LENGTH - 1)].next_state];
+        return std::distance(row.begin(), std::max_element(row.begin(), row.end()));
+    });
+    reporter.run("q_table/argmax/flat", BENCH_STEPS, [&](long i) {
+        return flat.argmax(transitions[i & (WALK_LENGTH - 1)].next_state);
+    });
+    reporter.run("q_table/argmax/sparse", BENCH_STEPS, [&](long i) {
+        return sparse.argmax(transitions[i & (WALK_LENGTH - 1)].next_state);
+    });
+
+    if (reporter.enabled("q_table/td_update/sparse_6d"))
+    {
+        static const std::vector<transition> walk = makeWalk(WALK_LENGTH);
+        static sparse_table large(0);
+        reporter.run("q_table/td_update/sparse_6d", BENCH_STEPS, [&](long i) {
+            const transition &t = walk[i & (WALK_LENGTH - 1)];
+            float td_target = t.reward + DISCOUNT_FACTOR * large.max(t.next_state);
+            float td_error = td_target - large[t.state][t.action];
+            large[t.state][t.action] += td_error * ALPHA;
+            return td_error;
+        });
+        double dense_bytes = 1.0 * sparse_table::STRIDE * sizeof(float);
+        for (int d = 0; d < DIMENSIONS; d++)
+        {
+            dense_bytes *= BINS;
+        }
+        fprintf(stderr, "q_table/td_update/sparse_6d: %zu of %.0f states stored, %.2f MB sparse against %.2f MB dense\n",
+                large.states(), dense_bytes / (sparse_table::STRIDE * sizeof(float)), large.memoryBytes() / 1e6, dense_bytes / 1e6);
+    }
+}
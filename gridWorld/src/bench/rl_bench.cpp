@@ -0,0 +1,69 @@
+/**
+    rl_bench: micro benchmarks of the hot kernels in the training loops.
+
+    Usage: rl_bench [--json out.json] [--filter name] [--repetitions n] [--scale x]
+    The JSON document goes to stdout unless --json is given, a readable table goes to stderr.
+
+    @author Alex Cornelio
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "bench.hpp"
+
+int main(int argc, char **argv)
+{
+    bench_reporter reporter;
+    std::string json_path;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            json_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            reporter.filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+        {
+            reporter.repetitions = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+        {
+            reporter.scale = atof(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--json out.json] [--filter name] [--repetitions n] [--scale x]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    registerKernelBenchmarks(reporter);
+    registerQTableBenchmarks(reporter);
+    registerDispatchBenchmarks(reporter);
+    registerLayoutBenchmarks(reporter);
+
+    reporter.printTable();
+    if (json_path.empty())
+    {
+        fputs(reporter.json().c_str(), stdout);
+    }
+    else
+    {
+        FILE *f = fopen(json_path.c_str(), "w");
+        if (f == NULL)
+        {
+            perror(json_path.c_str());
+            return 1;
+        }
+        fputs(reporter.json().c_str(), f);
+        fclose(f);
+    }
+    return 0;
+}
@@ -0,0 +1,234 @@
+/**
+    This script runs asynchronous one-step Q-learning actors (rl/async_q_learning.hpp) in the gridworld
+    environment and compares exploration schedules: actors that each draw their own epsilon from a mixed
+    distribution against actors that all use the same epsilon, once for every value of the distribution.
+    A run ends when the greedy policy of the shared table is optimal in every state (planner Q* as the
+    ground truth), checked every --check-period episodes counted over all actors. For every schedule it
+    prints the median wall clock time and episodes to convergence over --repeats seeds.
+    The moves are deterministic by default, see hogwildGridWorld.
+
+    Usage: asyncGridWorld_example [options]
+        --actors 4               actor threads, all cores by default
+        --epsilons 0.5,0.1,0.01  exploration rates the actors draw from
+        --weights 0.3,0.4,0.3    probability of each rate
+        --push-interval 50       steps between pushes to the shared table
+        --initial-epsilon 1      exploration rate every actor starts from
+        --anneal 0               episodes over which an actor moves from the initial rate to its own
+        --repeats 5              runs per schedule, each with its own seed
+        --seed 1                 seed of the first run
+        --check-period 10        episodes between convergence checks
+        --max-episodes 100000    episodes over all actors before a run gives up
+        --noise 0                percent chance that a move goes in a random direction
+
+    @author Alex Cornelio
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "gridWorld.hpp"
+
+#include <rl/async_q_learning.hpp>
+#include <rl/planner.hpp>
+
+// grid size, override with -DGRID_WIDTH=.. -DGRID_HEIGHT=..
+#ifndef GRID_WIDTH
+#define GRID_WIDTH 4
+#endif
+#ifndef GRID_HEIGHT
+#define GRID_HEIGHT 3
+#endif
+// agent parameters, as in qLearningGridWorld
+#define DISCOUNT_FACTOR 0.5
+#define ALPHA 0.5
+// steps before an episode is cut off, so an actor notices the end of the run
+#define MAX_STEPS 100000
+
+using namespace std;
+
+typedef gridWorld<GRID_WIDTH, GRID_HEIGHT> grid_world;
+typedef QTable<grid_world::STATES, ACTIONS, relaxed_float> shared_table;
+
+/**
+    Settings shared by every run
+*/
+struct run_settings
+{
+    unsigned int actors;
+    async_parameters params;
+    unsigned int check_period;
+    unsigned long max_episodes;
+    float noise;
+};
+
+/**
+    How long one run took
+*/
+struct run_result
+{
+    double seconds;
+    unsigned long episodes;
+    bool converged;
+};
+
+/**
+    Split a comma separated list of numbers
+*/
+static vector<float> floatList(const string &list)
+{
+    vector<float> values;
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, ','))
+    {
+        if (!item.empty())
+        {
+            values.push_back(strtof(item.c_str(), NULL));
+        }
+    }
+    return values;
+}
+
+/**
+    One run of the actors, drawing their exploration rates from epsilons
+*/
+static run_result actorRun(const planner &optimal, const run_settings &settings, const epsilon_distribution &epsilons,
+                           unsigned long long seed)
+{
+    static shared_table Q(0);
+    Q.fill(0);
+
+    // every actor's world is built before the clock starts, actor k's world draws from stream 2 * actors + k
+    vector<grid_world *> envs(settings.actors);
+    for (unsigned int k = 0; k < settings.actors; k++)
+    {
+        envs[k] = new grid_world();
+        envs[k]->setUniformNoise(settings.noise / 100.0f);
+        envs[k]->seed(seed, 2 * settings.actors + k);
+    }
+
+    run_result result = {0, 0, false};
+    atomic<bool> stopped(false);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    runAsyncActors(envs, Q, seed, settings.params, epsilons,
+                   [](grid_world &env) { return env.START_STATE; },
+                   [&](unsigned long episodes) {
+                       if (episodes % settings.check_period != 0)
+                       {
+                           return false;
+                       }
+                       bool converged = optimal.policyAgreement(Q) >= 1.0f;
+                       if (converged || episodes >= settings.max_episodes)
+                       {
+                           // the actors finish their episodes after this, only the first stop counts
+                           if (!stopped.exchange(true))
+                           {
+                               result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                               result.episodes = episodes;
+                               result.converged = converged;
+                           }
+                           return true;
+                       }
+                       return false;
+                   });
+
+    for (unsigned int k = 0; k < settings.actors; k++)
+    {
+        delete envs[k];
+    }
+    return result;
+}
+
+/**
+    Run every seed with epsilons and print the medians
+*/
+static void study(const char *schedule, const planner &optimal, const run_settings &settings,
+                  const epsilon_distribution &epsilons, unsigned int repeats, unsigned long long seed)
+{
+    vector<double> times;
+    vector<unsigned long> episodes;
+    unsigned int converged = 0;
+    for (unsigned int r = 0; r < repeats; r++)
+    {
+        run_result result = actorRun(optimal, settings, epsilons, seed + r);
+        // runs that did not converge count as the slowest
+        times.push_back(result.converged ? result.seconds : 1e30);
+        episodes.push_back(result.converged ? result.episodes : ULONG_MAX);
+        converged += result.converged;
+    }
+    sort(times.begin(), times.end());
+    sort(episodes.begin(), episodes.end());
+    if (converged * 2 < repeats)
+    {
+        printf("%-16s %12s %10s %10u\n", schedule, "-", "-", converged);
+        return;
+    }
+    printf("%-16s %12.6f %10lu %10u\n", schedule, times[(repeats - 1) / 2], episodes[(repeats - 1) / 2], converged);
+}
+
+int main(int argc, char **argv)
+{
+    run_settings settings = {thread::hardware_concurrency(), {{ALPHA, DISCOUNT_FACTOR}, 50, MAX_STEPS, 1, 0}, 10, 100000, 0};
+    epsilon_distribution mixed = {floatList("0.5,0.1,0.01"), floatList("0.3,0.4,0.3")};
+    unsigned int repeats = 5;
+    unsigned long long seed = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        string option = argv[i];
+        string value = argv[i + 1];
+        if (option == "--actors") settings.actors = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--epsilons") mixed.values = floatList(value);
+        else if (option == "--weights") mixed.weights = floatList(value);
+        else if (option == "--push-interval") settings.params.push_interval = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--initial-epsilon") settings.params.initial_epsilon = strtof(value.c_str(), NULL);
+        else if (option == "--anneal") settings.params.anneal_episodes = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--repeats") repeats = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--seed") seed = strtoull(value.c_str(), NULL, 10);
+        else if (option == "--check-period") settings.check_period = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--max-episodes") settings.max_episodes = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--noise") settings.noise = strtof(value.c_str(), NULL);
+        else
+        {
+            cerr<<"unknown option "<<option<<endl;
+            return 1;
+        }
+    }
+    if (settings.actors == 0 || repeats == 0 || settings.check_period == 0 || settings.params.push_interval == 0)
+    {
+        cerr<<"actors, repeats, check period and push interval must be at least 1"<<endl;
+        return 1;
+    }
+    if (mixed.values.empty() || mixed.values.size() != mixed.weights.size())
+    {
+        cerr<<"give one weight for every epsilon"<<endl;
+        return 1;
+    }
+
+    static grid_world env;
+    env.setUniformNoise(settings.noise / 100.0f);
+    planner optimal(grid_world::STATES, ACTIONS);
+    buildModel(optimal, env);
+    optimal.valueIteration(DISCOUNT_FACTOR, 1e-3);
+
+    printf("%dx%d grid, %u actors, push every %u steps, %u runs per row from seed %llu, medians\n", GRID_WIDTH,
+           GRID_HEIGHT, settings.actors, settings.params.push_interval, repeats, seed);
+    printf("%-16s %12s %10s %10s\n", "epsilon", "seconds", "episodes", "converged");
+    study("mixed", optimal, settings, mixed, repeats, seed);
+    for (size_t i = 0; i < mixed.values.size(); i++)
+    {
+        epsilon_distribution single = {vector<float>(1, mixed.values[i]), vector<float>(1, 1.0f)};
+        char schedule[32];
+        snprintf(schedule, sizeof(schedule), "%g", mixed.values[i]);
+        study(schedule, optimal, settings, single, repeats, seed);
+    }
+    return 0;
+}
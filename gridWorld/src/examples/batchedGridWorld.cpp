@@ -0,0 +1,79 @@
+/**
+    This script trains many independent q-learning agents in the gridworld at once, for hyperparameter studies.
+    Every agent has its own Q table, random stream and learning rate; they are all stepped in lockstep by
+    batchedGridWorld. Prints the aggregate throughput in environment steps per second and, for every learning
+    rate, the mean number of episodes and wins.
+
+    Usage: batchedGridWorld_example [agents] [steps] [seed]
+
+    @author Alex Cornelio
+*/
+
+#include <chrono>
+#include <iostream>
+#include <stdlib.h>
+#include <time.h>
+
+#include "batchedGridWorld.hpp"
+
+// grid size, override with -DGRID_WIDTH=.. -DGRID_HEIGHT=..
+#ifndef GRID_WIDTH
+#define GRID_WIDTH 4
+#endif
+#ifndef GRID_HEIGHT
+#define GRID_HEIGHT 3
+#endif
+
+#define DEFAULT_AGENTS 1024
+#define DEFAULT_STEPS 10000
+
+// agent parameters, the learning rate is swept over ALPHA_LEVELS values
+#define DISCOUNT_FACTOR 0.5
+#define EPSILON 0.1
+#define ALPHA_LEVELS 10
+
+using namespace std;
+
+int main(int argc, char **argv)
+{
+    unsigned int agents = (argc > 1) ? strtoul(argv[1], NULL, 10) : DEFAULT_AGENTS;
+    unsigned long steps = (argc > 2) ? strtoul(argv[2], NULL, 10) : DEFAULT_STEPS;
+    unsigned long long seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : (unsigned long long)time(NULL);
+
+    batchedGridWorld<GRID_WIDTH, GRID_HEIGHT> batch(agents);
+    batch.seed(seed);
+    for (unsigned int i = 0; i < agents; i++)
+    {
+        batch.alpha[i] = (float)(i % ALPHA_LEVELS + 1) / ALPHA_LEVELS;
+        batch.discount_factor[i] = DISCOUNT_FACTOR;
+        batch.epsilon[i] = EPSILON;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned long t = 0; t < steps; t++)
+    {
+        batch.step();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    //print stats per learning rate
+    cout<<"alpha,agents,mean_episodes,mean_wins,mean_loses"<<endl;
+    for (int level = 0; level < ALPHA_LEVELS; level++)
+    {
+        unsigned int count = 0;
+        double episodes = 0, wins = 0, loses = 0;
+        for (unsigned int i = level; i < agents; i += ALPHA_LEVELS)
+        {
+            count++;
+            episodes += batch.episodes[i];
+            wins += batch.wins[i];
+            loses += batch.loses[i];
+        }
+        if (count > 0)
+        {
+            cout<<batch.alpha[level]<<","<<count<<","<<episodes/count<<","<<wins/count<<","<<loses/count<<endl;
+        }
+    }
+    cerr<<batch.steps_taken<<" environment steps in "<<seconds<<" s, "
+        <<batch.steps_taken/seconds<<" steps/s"<<endl;
+}
@@ -0,0 +1,321 @@
+/**
+    Many independent grid world agents stepped in lockstep.
+    Agent states, random engines and hyperparameters are kept as structure of arrays, one entry per agent, and
+    every step runs as a handful of flat loops over all agents: draw random numbers, choose actions, move,
+    TD update. Each agent has its own Q table, and the tables are stored back to back in one buffer.
+    The world itself (masks, rewards, terminal cells, noise model) is the same as gridWorld's.
+
+    @author Alex Cornelio
+*/
+
+#ifndef BATCHED_GRID_WORLD_H
+#define BATCHED_GRID_WORLD_H
+
+#include <array>
+#include <limits>
+#include <vector>
+#include <stdint.h>
+
+#include "gridWorld.hpp"
+
+template <int WIDTH, int HEIGHT, class Layout = cliffLayout>
+class batchedGridWorld
+{
+public:
+    typedef gridWorld<WIDTH, HEIGHT, Layout> world;
+
+    static constexpr int STATES = world::STATES;
+    static constexpr state_t START_STATE = world::START_STATE;
+    static constexpr std::size_t STRIDE = QTable<STATES, ACTIONS>::STRIDE;
+    static constexpr std::size_t TABLE_SIZE = STATES * STRIDE;
+
+    explicit batchedGridWorld(unsigned int agents);
+
+    void seed(uint64_t seed_value);
+    void setNoise(float probability);
+    void step();
+
+    unsigned int agents() const { return agents_; }
+    float *table(unsigned int agent) { return &q_[agent * TABLE_SIZE]; }
+
+    // per agent state and hyperparameters
+    std::vector<state_t> state;
+    std::vector<float> alpha;
+    std::vector<float> discount_factor;
+    std::vector<float> epsilon;
+
+    // per agent counters
+    std::vector<unsigned int> episodes;
+    std::vector<unsigned int> wins;
+    std::vector<unsigned int> loses;
+
+    // environment steps taken by all agents together
+    uint64_t steps_taken;
+
+private:
+    unsigned int agents_;
+    uint32_t noise_threshold_;     // noise probability in 1/65536
+
+    // xoshiro256** state, one word of every agent's engine per array
+    std::vector<uint64_t> s0_, s1_, s2_, s3_;
+
+    // results of the current step
+    std::vector<uint64_t> draw_;
+    std::vector<unsigned char> action_;
+    std::vector<state_t> next_state_;
+    std::vector<signed short int> reward_;
+
+    std::vector<float> q_;
+    std::vector<signed short int> reward_table_;
+    std::vector<unsigned char> terminal_table_;
+
+    void drawAll();
+    void chooseAll();
+    void moveAll();
+    void updateAll();
+
+    static constexpr std::array<std::array<unsigned char, ACTIONS>, 1 << ACTIONS> nthTable();
+
+    /**
+        Number of legal actions. Plain shifts and adds, __builtin_popcount is a library call without -mpopcnt
+    */
+    static int legalCount(action_mask_t mask)
+    {
+        int n = 0;
+        for (int a = 0; a < ACTIONS; a++)
+        {
+            n += (mask >> a) & 1;
+        }
+        return n;
+    }
+
+    static constexpr state_t DELTA_STATE[ACTIONS] = {1, HEIGHT, -1, -HEIGHT};
+    // NTH_ACTION[mask][n] is nthAction(mask, n) without the loop
+    static constexpr std::array<std::array<unsigned char, ACTIONS>, 1 << ACTIONS> NTH_ACTION = nthTable();
+};
+
+/**
+    Constructor. Every agent starts in the start state with gridWorld's default noise
+*/
+template <int WIDTH, int HEIGHT, class Layout>
+batchedGridWorld<WIDTH, HEIGHT, Layout>::batchedGridWorld(unsigned int agents)
+    :state(agents, START_STATE),
+     alpha(agents, 0.5f),
+     discount_factor(agents, 0.5f),
+     epsilon(agents, 0.1f),
+     episodes(agents, 0),
+     wins(agents, 0),
+     loses(agents, 0),
+     steps_taken(0),
+     agents_(agents),
+     s0_(agents), s1_(agents), s2_(agents), s3_(agents),
+     draw_(agents),
+     action_(agents),
+     next_state_(agents),
+     reward_(agents),
+     q_(agents * TABLE_SIZE, 0.0f),
+     reward_table_(STATES),
+     terminal_table_(STATES)
+{
+    // padding columns never win a max
+    for (unsigned int i = 0; i < agents * STATES; i++)
+    {
+        for (std::size_t a = ACTIONS; a < STRIDE; a++)
+        {
+            q_[i * STRIDE + a] = std::numeric_limits<float>::lowest();
+        }
+    }
+    // rewards and terminal cells are looked up instead of recomputed from (x, y)
+    for (state_t s = 0; s < STATES; s++)
+    {
+        reward_table_[s] = world::rewardOf(s);
+        terminal_table_[s] = world::isTerminal(s);
+    }
+    setNoise(NOISEY_TRANS_PROB / 100.0f);
+    seed(0);
+}
+
+/**
+    Build the n-th legal action table
+*/
+template <int WIDTH, int HEIGHT, class Layout>
+constexpr std::array<std::array<unsigned char, ACTIONS>, 1 << ACTIONS> batchedGridWorld<WIDTH, HEIGHT, Layout>::nthTable()
+{
+    std::array<std::array<unsigned char, ACTIONS>, 1 << ACTIONS> table{};
+    for (unsigned int mask = 0; mask < (1u << ACTIONS); mask++)
+    {
+        int n = 0;
+        for (int a = 0; a < ACTIONS; a++)
+        {
+            if ((mask >> a) & 1)
+            {
+                table[mask][n++] = (unsigned char)a;
+            }
+        }
+    }
+    return table;
+}
+
+/**
+    Seed every agent. Agent i uses stream i of the seed, so agents never share a sequence
+*/
+template <int WIDTH, int HEIGHT, class Layout>
+void batchedGridWorld<WIDTH, HEIGHT, Layout>::seed(uint64_t seed_value)
+{
+    uint64_t lane[4];
+    for (unsigned int i = 0; i < agents_; i++)
+    {
+        random_engine(seed_value, i).getState(lane);
+        s0_[i] = lane[0];
+        s1_[i] = lane[1];
+        s2_[i] = lane[2];
+        s3_[i] = lane[3];
+    }
+}
+
+/**
+    Set the probability that an action is replaced by a random available action, for every agent
+*/
+template <int WIDTH, int HEIGHT, class Layout>
+void batchedGridWorld<WIDTH, HEIGHT, Layout>::setNoise(float probability)
+{
+    noise_threshold_ = (uint32_t)(probability * 65536.0f);
+}
+
+/**
+    Advance every agent by one step. Agents whose episode ended go back to the start state
+*/
+template <int WIDTH, int HEIGHT, class Layout>
+void batchedGridWorld<WIDTH, HEIGHT, Layout>::step()
+{
+    drawAll();
+    chooseAll();
+    moveAll();
+    updateAll();
+    steps_taken += agents_;
+}
+
+/**
+    One xoshiro256** draw per agent. Straight line code over the four state arrays, so it vectorizes
+*/
+template <int WIDTH, int HEIGHT, class Layout>
+void batchedGridWorld<WIDTH, HEIGHT, Layout>::drawAll()
+{
+    uint64_t *__restrict s0 = s0_.data();
+    uint64_t *__restrict s1 = s1_.data();
+    uint64_t *__restrict s2 = s2_.data();
+    uint64_t *__restrict s3 = s3_.data();
+    uint64_t *__restrict draw = draw_.data();
+
+    for (unsigned int i = 0; i < agents_; i++)
+    {
+        uint64_t x = s1[i] * 5;
+        draw[i] = ((x << 7) | (x >> 57)) * 9;
+        uint64_t t = s1[i] << 17;
+        s2[i] ^= s0[i];
+        s3[i] ^= s1[i];
+        s1[i] ^= s2[i];
+        s0[i] ^= s3[i];
+        s2[i] ^= t;
+        s3[i] = (s3[i] << 45) | (s3[i] >> 19);
+    }
+}
+
+/**
+    Epsilon greedy action of every agent. The high 32 bits of the agent's draw are used: 16 to decide whether
+    to explore and 16 to pick the action. Greedy ties are broken at random with the bits exploration would have
+    used
+*/
+template <int WIDTH, int HEIGHT, class Layout>
+void batchedGridWorld<WIDTH, HEIGHT, Layout>::chooseAll()
+{
+    for (unsigned int i = 0; i < agents_; i++)
+    {
+        uint64_t r = draw_[i];
+        state_t s = state[i];
+        action_mask_t legal = world::actionMask(s);
+        const float *row = &q_[i * TABLE_SIZE + s * STRIDE];
+
+#if defined(__SSE2__)
+        // the four actions fit one register. Illegal lanes drop to the lowest float, then the maximum and the
+        // lanes equal to it are found without a branch; the legal masks are random across agents and branches
+        // on them mispredict
+        const __m128i lane_bits = _mm_set_epi32(8, 4, 2, 1);
+        __m128 is_legal = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_and_si128(_mm_set1_epi32(legal), lane_bits), _mm_setzero_si128()));
+        __m128 values = _mm_or_ps(_mm_and_ps(is_legal, _mm_loadu_ps(row)),
+                                  _mm_andnot_ps(is_legal, _mm_set1_ps(std::numeric_limits<float>::lowest())));
+        __m128 best = _mm_max_ps(values, _mm_shuffle_ps(values, values, _MM_SHUFFLE(2, 3, 0, 1)));
+        best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(1, 0, 3, 2)));
+        action_mask_t ties = _mm_movemask_ps(_mm_cmpeq_ps(values, best)) & legal;
+#else
+        float best = std::numeric_limits<float>::lowest();
+        for (int a = 0; a < ACTIONS; a++)
+        {
+            best = ((legal >> a) & 1) && row[a] > best ? row[a] : best;
+        }
+        action_mask_t ties = 0;
+        for (int a = 0; a < ACTIONS; a++)
+        {
+            ties |= (((legal >> a) & 1) && row[a] == best) ? (1u << a) : 0u;
+        }
+#endif
+
+        bool explore = (uint32_t)(r >> 48) < (uint32_t)(epsilon[i] * 65536.0f);
+        action_mask_t candidates = explore ? legal : ties;
+        action_[i] = NTH_ACTION[candidates][(((r >> 32) & 0xffff) * legalCount(candidates)) >> 16];
+    }
+}
+
+/**
+    Noisy transition and reward of every agent. The low 32 bits of the draw decide whether the action is
+    replaced and by which available action, the same distribution gridWorld's alias tables sample
+*/
+template <int WIDTH, int HEIGHT, class Layout>
+void batchedGridWorld<WIDTH, HEIGHT, Layout>::moveAll()
+{
+    for (unsigned int i = 0; i < agents_; i++)
+    {
+        uint64_t r = draw_[i];
+        state_t s = state[i];
+        action_mask_t legal = world::actionMask(s);
+
+        bool noisy = (uint32_t)((r >> 16) & 0xffff) < noise_threshold_;
+        char outcome = noisy ? NTH_ACTION[legal][((r & 0xffff) * legalCount(legal)) >> 16] : action_[i];
+        state_t next = s + DELTA_STATE[(int)outcome];
+
+        signed short int reward = reward_table_[next];
+        next_state_[i] = next;
+        reward_[i] = reward;
+        wins[i] += reward == REWARD;
+        loses[i] += reward == PUNISHMENT;
+        episodes[i] += terminal_table_[next];
+    }
+}
+
+/**
+    Q-learning update of every agent's own table, then restart agents whose episode ended
+*/
+template <int WIDTH, int HEIGHT, class Layout>
+void batchedGridWorld<WIDTH, HEIGHT, Layout>::updateAll()
+{
+    for (unsigned int i = 0; i < agents_; i++)
+    {
+        float *q = &q_[i * TABLE_SIZE];
+        state_t s = state[i];
+        state_t next = next_state_[i];
+        const float *next_row = q + next * STRIDE;
+
+        float max_q = next_row[0];
+        for (int a = 1; a < ACTIONS; a++)
+        {
+            max_q = next_row[a] > max_q ? next_row[a] : max_q;
+        }
+        float &value = q[s * STRIDE + action_[i]];
+        float td_target = reward_[i] + discount_factor[i] * max_q;
+        value += (td_target - value) * alpha[i];
+
+        state[i] = terminal_table_[next] ? START_STATE : next;
+    }
+}
+
+#endif // BATCHED_GRID_WORLD_H
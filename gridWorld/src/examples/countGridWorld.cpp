@@ -0,0 +1,165 @@
+/**
+    This script compares learning rates and exploration driven by visit counts (rl/counted_q_table.hpp) with
+    the constant alpha and epsilon of qLearningGridWorld, in the noisy gridworld environment. Three agents
+    learn on a Q table that keeps a visit count next to every value:
+        constant      alpha ALPHA, epsilon greedy
+        1/n rate      alpha 1 / visits^rate_exponent of the pair, epsilon greedy
+        1/n rate, UCB the same rates, actions by upper confidence bound on the counts, no epsilon
+    The planner's Q* is the ground truth. A run ends once the greedy policy is optimal in every state or
+    after --episodes episodes. Prints, as medians over --seeds seeds, the episodes it took, how many of them
+    ended in the cliff (the falls of the robot), and the fraction of optimal greedy actions and the distance
+    to Q* at the end.
+
+    Usage: countGridWorld_example [options]
+        --seeds 20                   runs per agent, each with its own seed
+        --seed 1                     seed of the first run
+        --episodes 500               most episodes per run
+        --epsilon 0.5                exploration of the epsilon greedy agents
+        --rate-exponent 0.8          learning rate 1 / visits^x of the counted agents
+        --min-alpha 0.01             lowest learning rate of the counted agents
+        --ucb-c 1000                 weight of the UCB bonus, in units of reward
+
+    @author Alex Cornelio
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "gridWorld.hpp"
+#include "medians.hpp"
+
+#include <rl/counted_q_table.hpp>
+#include <rl/planner.hpp>
+#include <rl/q_learning.hpp>
+#include <rl/training.hpp>
+
+// grid size, override with -DGRID_WIDTH=.. -DGRID_HEIGHT=..
+#ifndef GRID_WIDTH
+#define GRID_WIDTH 4
+#endif
+#ifndef GRID_HEIGHT
+#define GRID_HEIGHT 3
+#endif
+// agent parameters, as in qLearningGridWorld
+#define DISCOUNT_FACTOR 0.5
+#define ALPHA 0.5
+
+using namespace std;
+
+typedef gridWorld<GRID_WIDTH, GRID_HEIGHT> grid_world;
+typedef CountedQTable<grid_world::STATES, ACTIONS> counted_table;
+
+/**
+    Where one run got to
+*/
+struct run_result
+{
+    float episodes;     // episodes until the greedy policy was optimal everywhere, -1 if it never was
+    float falls;        // episodes that ended in the cliff until then
+    float agreement;
+    float distance;
+};
+
+/**
+    Run one agent until its greedy policy is optimal or for max_episodes
+*/
+static run_result run(grid_world &env, counted_table &Q, const planner &optimal, float epsilon,
+                      const count_parameters &counts, unsigned long long seed, unsigned int max_episodes)
+{
+    Q.fill(0);
+    Q.clearVisits();
+    q_learning controller;
+    controller.seed(seed, 0);
+    env.seed(seed, 1);
+    td_parameters params = {ALPHA, DISCOUNT_FACTOR};
+    run_result result = {-1, 0, 0, 0};
+
+    for (unsigned int episode = 0; episode < max_episodes; episode++)
+    {
+        episode_result outcome = countedQLearningEpisode(env, Q, controller, env.START_STATE, epsilon, params, counts);
+        result.falls += outcome.reward == PUNISHMENT;
+        if (optimal.policyAgreement(Q) >= 1.0f)
+        {
+            result.episodes = episode + 1;
+            break;
+        }
+    }
+    result.agreement = optimal.policyAgreement(Q);
+    result.distance = optimal.distance(Q);
+    return result;
+}
+
+/**
+    Run every seed with one agent and print the medians
+*/
+static void study(const char *agent, grid_world &env, counted_table &Q, const planner &optimal, float epsilon,
+                  const count_parameters &counts, unsigned int seeds, unsigned long long first_seed,
+                  unsigned int max_episodes)
+{
+    vector<float> episodes, falls, agreements, distances;
+    for (unsigned int k = 0; k < seeds; k++)
+    {
+        run_result result = run(env, Q, optimal, epsilon, counts, first_seed + k, max_episodes);
+        episodes.push_back(result.episodes);
+        falls.push_back(result.falls);
+        agreements.push_back(result.agreement);
+        distances.push_back(result.distance);
+    }
+    printf("%-16s %10.0f %10.0f %10.3f %10.1f\n", agent, median(episodes), median(falls), median(agreements),
+           median(distances));
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int seeds = 20;
+    unsigned long long first_seed = 1;
+    unsigned int max_episodes = 500;
+    float epsilon = 0.5;
+    count_parameters counted = {0.8f, 0.01f, 0.0f};
+    float ucb_c = 1000;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        string option = argv[i];
+        string value = argv[i + 1];
+        if (option == "--seeds") seeds = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--seed") first_seed = strtoull(value.c_str(), NULL, 10);
+        else if (option == "--episodes") max_episodes = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--epsilon") epsilon = strtof(value.c_str(), NULL);
+        else if (option == "--rate-exponent") counted.rate_exponent = strtof(value.c_str(), NULL);
+        else if (option == "--min-alpha") counted.min_alpha = strtof(value.c_str(), NULL);
+        else if (option == "--ucb-c") ucb_c = strtof(value.c_str(), NULL);
+        else
+        {
+            cerr<<"unknown option "<<option<<endl;
+            return 1;
+        }
+    }
+    if (seeds == 0 || max_episodes == 0)
+    {
+        cerr<<"give at least one seed and one episode"<<endl;
+        return 1;
+    }
+
+    static grid_world env;
+    static counted_table Q;
+    planner optimal(grid_world::STATES, ACTIONS);
+    buildModel(optimal, env);
+    optimal.valueIteration(DISCOUNT_FACTOR, 1e-3);
+
+    count_parameters constant = {0.0f, ALPHA, 0.0f};
+    count_parameters ucb = counted;
+    ucb.ucb_c = ucb_c;
+
+    printf("%dx%d grid, %u seeds from %llu, at most %u episodes, medians. -1: fewer than half of the runs got there\n",
+           GRID_WIDTH, GRID_HEIGHT, seeds, first_seed, max_episodes);
+    printf("%-16s %10s %10s %10s %10s\n", "agent", "episodes", "falls", "optimal", "distance");
+    study("constant", env, Q, optimal, epsilon, constant, seeds, first_seed, max_episodes);
+    study("1/n rate", env, Q, optimal, epsilon, counted, seeds, first_seed, max_episodes);
+    study("1/n rate, UCB", env, Q, optimal, 0.0f, ucb, seeds, first_seed, max_episodes);
+    return 0;
+}
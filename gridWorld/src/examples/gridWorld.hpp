@@ -2,43 +2,444 @@
 #define gridWorld_H
 
 #include <rl/environment.hpp>
+#include <rl/static_environment.hpp>
+#include <rl/q_table.hpp>
+#include <rl/alias_table.hpp>
+#include <array>
+#include <map>
+#include <utility>
 #include <vector>
+#include <stdint.h>
 #include <stdlib.h>
 #include <time.h>
 #include <iostream>
 #include <algorithm>
 
-#define STATES 12
 #define ACTIONS 4
 
 #define REWARD 1000
 #define PUNISHMENT -1000
 #define STATE_TRANSITION_COST 0
-#define GOAL_STATE 30
-#define OBSTACLE_1_STATE 10
-#define OBSTACLE_2_STATE 20
 
+// default percentage chance that an action is replaced by a random available one
 #define NOISEY_TRANS_PROB 20
 
+// action numbers, N, E, S, W
+#define NORTH 0
+#define EAST 1
+#define SOUTH 2
+#define WEST 3
+
+/**
+    Default layout: a cliff along the bottom row. The agent starts bottom left, the goal is bottom right and
+    every cell between them is an obstacle. On a 4x3 grid this is the original world with obstacles at (1,0)
+    and (2,0) and the goal at (3,0).
+*/
+struct cliffLayout
+{
+    static constexpr bool isGoal(int x, int y, int width, int /* height */)
+    {
+        return x == width - 1 && y == 0;
+    }
+    static constexpr bool isObstacle(int x, int y, int width, int /* height */)
+    {
+        return y == 0 && x > 0 && x < width - 1;
+    }
+};
+
+/**
+    Default state numbering: cell (x, y) is state x*HEIGHT + y, one column after the other. North and south
+    neighbours are next to each other in the Q table but east and west neighbours are HEIGHT rows apart.
+*/
+template <int WIDTH, int HEIGHT>
+struct columnMajorIndexer
+{
+    // every state is a cell
+    static constexpr bool DENSE = true;
+    static constexpr int STATES = WIDTH * HEIGHT;
+
+    static constexpr state_t stateOf(int x, int y) { return x * HEIGHT + y; }
+    static constexpr int xOf(state_t s) { return s / HEIGHT; }
+    static constexpr int yOf(state_t s) { return s % HEIGHT; }
+
+    /**
+        Return the state of the neighbour of s in direction action (N, E, S, W)
+    */
+    static constexpr state_t move(char action, state_t s)
+    {
+        return s + (action == NORTH ? 1 : action == EAST ? HEIGHT : action == SOUTH ? -1 : -HEIGHT);
+    }
+};
+
 /**
-    Derive cliff word from environment class
+    Bits needed to number side cells
 */
-class gridWorld : public environment
+constexpr int bitsFor(int side)
+{
+    int bits = 0;
+    while ((1 << bits) < side)
+    {
+        bits++;
+    }
+    return bits;
+}
+
+/**
+    Put bit i of the low 16 bits of v at bit 2i
+*/
+constexpr uint32_t spreadBits(uint32_t v)
+{
+    v &= 0x0000ffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    return (v | (v << 1)) & 0x55555555;
+}
+
+/**
+    Gather the even bits of v into the low 16 bits, the inverse of spreadBits
+*/
+constexpr uint32_t compactBits(uint32_t v)
+{
+    v &= 0x55555555;
+    v = (v | (v >> 1)) & 0x33333333;
+    v = (v | (v >> 2)) & 0x0f0f0f0f;
+    v = (v | (v >> 4)) & 0x00ff00ff;
+    return (v | (v >> 8)) & 0x0000ffff;
+}
+
+/**
+    Z-order (Morton) state numbering: the low bits of x and y are interleaved, x in the even bits and y in the
+    odd bits, so the cells of every aligned 2^k x 2^k square are consecutive states and most neighbours share a
+    cache line or a page of the Q table. On large grids this makes the Q[next_state] read of a TD update hit
+    the cache far more often than with columnMajorIndexer.
+    Only as many bits as the shorter side needs are interleaved, the remaining high bits of the longer side
+    go on top, so a long thin grid is not padded to a square. Sides that are not powers of two still leave
+    states that are not cells; gridWorld gives them no actions and makes them terminal, they are never reached.
+*/
+template <int WIDTH, int HEIGHT>
+struct mortonIndexer
+{
+    // bits of each coordinate that are interleaved
+    static constexpr int BITS = bitsFor(WIDTH < HEIGHT ? WIDTH : HEIGHT);
+    static constexpr bool X_LONGER = WIDTH >= HEIGHT;
+    static constexpr uint32_t LOW_MASK = BITS == 16 ? 0xffffffffu : (1u << (2 * BITS)) - 1;
+
+    static constexpr int STATES = ((((X_LONGER ? WIDTH : HEIGHT) - 1) >> BITS) + 1) << (2 * BITS);
+    static constexpr bool DENSE = STATES == WIDTH * HEIGHT;
+
+    // bits of a state that belong to x and to y
+    static constexpr uint32_t X_MASK = (0x55555555u & LOW_MASK) | (X_LONGER ? ~LOW_MASK : 0);
+    static constexpr uint32_t Y_MASK = (0xaaaaaaaau & LOW_MASK) | (X_LONGER ? 0 : ~LOW_MASK);
+
+    static constexpr state_t stateOf(int x, int y)
+    {
+        uint32_t low = spreadBits((uint32_t)x & ((1u << BITS) - 1)) | spreadBits((uint32_t)y & ((1u << BITS) - 1)) << 1;
+        uint32_t high = (uint32_t)(X_LONGER ? x : y) >> BITS << (2 * BITS);
+        return (state_t)(low | high);
+    }
+    static constexpr int xOf(state_t s)
+    {
+        return (int)(compactBits((uint32_t)s & LOW_MASK) | (X_LONGER ? (uint32_t)s >> (2 * BITS) << BITS : 0));
+    }
+    static constexpr int yOf(state_t s)
+    {
+        return (int)(compactBits((uint32_t)s >> 1 & LOW_MASK) | (X_LONGER ? 0 : (uint32_t)s >> (2 * BITS) << BITS));
+    }
+
+    /**
+        Return the state of the neighbour of s in direction action (N, E, S, W). A coordinate is stepped in
+        place: filling the other coordinate's bits with ones carries an increment across them, clearing them
+        carries a decrement
+    */
+    static constexpr state_t move(char action, state_t s)
+    {
+        uint32_t u = (uint32_t)s;
+        switch (action)
+        {
+        case NORTH:
+            return (state_t)((((u | ~Y_MASK) + 1) & Y_MASK) | (u & X_MASK));
+        case EAST:
+            return (state_t)((((u | ~X_MASK) + 1) & X_MASK) | (u & Y_MASK));
+        case SOUTH:
+            return (state_t)((((u & Y_MASK) - 1) & Y_MASK) | (u & X_MASK));
+        default:
+            return (state_t)((((u & X_MASK) - 1) & X_MASK) | (u & Y_MASK));
+        }
+    }
+};
+
+/**
+    Derive grid world from environment class.
+    The grid is WIDTH x HEIGHT cells and (0, 0) is the bottom left. Indexer numbers the cells, the state of a
+    cell is also its row of the Q table. By default the state of cell (x, y) is x*HEIGHT + y; mortonIndexer
+    keeps neighbouring cells close together in the table, which pays off on large grids.
+    The world can be driven through the virtual environment interface or, without indirect calls, through
+    static_environment::step from the loops in rl/training.hpp.
+*/
+template <int WIDTH, int HEIGHT, class Layout = cliffLayout, class Indexer = columnMajorIndexer<WIDTH, HEIGHT> >
+class gridWorld : public environment, public static_environment<gridWorld<WIDTH, HEIGHT, Layout, Indexer> >
 {
 public:
+    static constexpr int STATES = Indexer::STATES;
+    static constexpr state_t START_STATE = 0;
 
     // Q table
-    std::vector<std::vector<float> > Q;
+    QTable<STATES, ACTIONS> Q;
 
     gridWorld();
     ~gridWorld();
 
-    std::vector<bool> availableActions(char s);
-    char takeAction(char action, char current_state);
-    char nextState(char action, char current_state, std::vector<bool> availiable_actions);
-    signed short int getReward(char next_state);
-    char getStateIndex(char current_state);
+    action_mask_t availableActions(state_t s) final { return actionMask(s); }
+    state_t takeAction(char action, state_t current_state);
+    state_t nextState(char action, state_t current_state, action_mask_t) final { return sampleNext(action, current_state); }
+    signed short int getReward(state_t next_state) final { return rewardOf(next_state); }
+    state_t getStateIndex(state_t current_state) { return current_state; }
+
+    // static interface
+    static constexpr action_mask_t actionMask(state_t s);
+    state_t sampleNext(char action, state_t current_state);
+    static constexpr signed short int rewardOf(state_t next_state);
+    static constexpr bool isTerminal(state_t next_state);
+
+    void setNoise(state_t s, float probability);
+    void setUniformNoise(float probability);
+    float getNoise(state_t s) const;
+    const float *outcomeProbabilities(state_t s, char action) const;
+
+    static constexpr state_t stateOf(int x, int y) { return Indexer::stateOf(x, y); }
+    static constexpr int xOf(state_t s) { return Indexer::xOf(s); }
+    static constexpr int yOf(state_t s) { return Indexer::yOf(s); }
+    static constexpr bool isCell(state_t s) { return Indexer::DENSE || (xOf(s) < WIDTH && yOf(s) < HEIGHT); }
+
+private:
+    /**
+        Outcome distributions for every action in cells with the same noise and available actions
+    */
+    struct transition_class
+    {
+        float noise;
+        action_mask_t available_actions;
+        float probability[ACTIONS][ACTIONS];
+        alias_table<ACTIONS> outcome[ACTIONS];
+    };
+
+    std::vector<transition_class> classes_;
+    std::vector<unsigned int> cell_class_;
+    std::map<std::pair<float, action_mask_t>, unsigned int> class_index_;
 
+    unsigned int classFor(float noise, action_mask_t available_actions);
+
+    static constexpr std::array<unsigned char, WIDTH> columnMasks();
+    static constexpr std::array<unsigned char, HEIGHT> rowMasks();
+
+    // legal east/west moves for each column and legal north/south moves for each row
+    static constexpr std::array<unsigned char, WIDTH> COLUMN_MASKS = columnMasks();
+    static constexpr std::array<unsigned char, HEIGHT> ROW_MASKS = rowMasks();
 };
 
+/**
+    Constructor
+*/
+template <int WIDTH, int HEIGHT, class Layout, class Indexer>
+gridWorld<WIDTH, HEIGHT, Layout, Indexer>::gridWorld()
+    :Q(0), //create states rows and actions columns
+     cell_class_(STATES)
+{
+    // every cell starts with the default noise, states that are not cells are never visited
+    for (int x = 0; x < WIDTH; x++)
+    {
+        for (int y = 0; y < HEIGHT; y++)
+        {
+            state_t s = stateOf(x, y);
+            cell_class_[s] = classFor(NOISEY_TRANS_PROB / 100.0f, availableActions(s));
+        }
+    }
+}
+
+/**
+    Destructor
+*/
+template <int WIDTH, int HEIGHT, class Layout, class Indexer>
+gridWorld<WIDTH, HEIGHT, Layout, Indexer>::~gridWorld()
+{
+
+}
+
+/**
+    Build the east/west part of the boundary masks
+*/
+template <int WIDTH, int HEIGHT, class Layout, class Indexer>
+constexpr std::array<unsigned char, WIDTH> gridWorld<WIDTH, HEIGHT, Layout, Indexer>::columnMasks()
+{
+    std::array<unsigned char, WIDTH> masks{};
+    for (int x = 0; x < WIDTH; x++)
+    {
+        masks[x] = (x != WIDTH - 1 ? 1 << EAST : 0) | (x != 0 ? 1 << WEST : 0);
+    }
+    return masks;
+}
+
+/**
+    Build the north/south part of the boundary masks
+*/
+template <int WIDTH, int HEIGHT, class Layout, class Indexer>
+constexpr std::array<unsigned char, HEIGHT> gridWorld<WIDTH, HEIGHT, Layout, Indexer>::rowMasks()
+{
+    std::array<unsigned char, HEIGHT> masks{};
+    for (int y = 0; y < HEIGHT; y++)
+    {
+        masks[y] = (y != HEIGHT - 1 ? 1 << NORTH : 0) | (y != 0 ? 1 << SOUTH : 0);
+    }
+    return masks;
+}
+
+/**
+    Return a bitmask of the actions available for the agent to take. Bit a is set when action a is legal.
+    The agent cannot go beyond the grid's boards. States that are not cells have no actions.
+    N, E, S, W is the order of actions
+*/
+template <int WIDTH, int HEIGHT, class Layout, class Indexer>
+constexpr action_mask_t gridWorld<WIDTH, HEIGHT, Layout, Indexer>::actionMask(state_t s)
+{
+    return isCell(s) ? COLUMN_MASKS[xOf(s)] | ROW_MASKS[yOf(s)] : 0;
+}
+
+/**
+    Returns the state from taking the action
+*/
+template <int WIDTH, int HEIGHT, class Layout, class Indexer>
+state_t gridWorld<WIDTH, HEIGHT, Layout, Indexer>::takeAction(char action, state_t current_state)
+{
+    return Indexer::move(action, current_state);
+}
+
+/**
+    Return the next state from taking an action in the current state.
+    This method takes into account noisy state transistions. With the cell's noise probability the action is
+    replaced by one of the available actions picked at random. The outcome distribution of every (cell, action)
+    is precomputed as an alias table, so this is one table lookup and one random draw. The available actions
+    are already part of the cell's table, which is why nextState ignores them.
+*/
+template <int WIDTH, int HEIGHT, class Layout, class Indexer>
+state_t gridWorld<WIDTH, HEIGHT, Layout, Indexer>::sampleNext(char action, state_t current_state)
+{
+    const transition_class &transitions = classes_[cell_class_[current_state]];
+    return takeAction(transitions.outcome[(int)action].sample(rng), current_state);
+}
+
+/**
+    Set the probability that an action taken in state s is replaced by a random available action
+*/
+template <int WIDTH, int HEIGHT, class Layout, class Indexer>
+void gridWorld<WIDTH, HEIGHT, Layout, Indexer>::setNoise(state_t s, float probability)
+{
+    cell_class_[s] = classFor(probability, availableActions(s));
+}
+
+/**
+    Give every cell the same noise probability
+*/
+template <int WIDTH, int HEIGHT, class Layout, class Indexer>
+void gridWorld<WIDTH, HEIGHT, Layout, Indexer>::setUniformNoise(float probability)
+{
+    for (int x = 0; x < WIDTH; x++)
+    {
+        for (int y = 0; y < HEIGHT; y++)
+        {
+            setNoise(stateOf(x, y), probability);
+        }
+    }
+}
+
+/**
+    Return the noise probability of state s
+*/
+template <int WIDTH, int HEIGHT, class Layout, class Indexer>
+float gridWorld<WIDTH, HEIGHT, Layout, Indexer>::getNoise(state_t s) const
+{
+    return classes_[cell_class_[s]].noise;
+}
+
+/**
+    Return the probability of each action actually being carried out when action is taken in state s.
+    The next state for outcome k is takeAction(k, s)
+*/
+template <int WIDTH, int HEIGHT, class Layout, class Indexer>
+const float *gridWorld<WIDTH, HEIGHT, Layout, Indexer>::outcomeProbabilities(state_t s, char action) const
+{
+    return classes_[cell_class_[s]].probability[(int)action];
+}
+
+/**
+    Return the transition class for cells with this noise and these available actions, building it the first
+    time it is needed. Cells that share noise and boundary share their tables
+*/
+template <int WIDTH, int HEIGHT, class Layout, class Indexer>
+unsigned int gridWorld<WIDTH, HEIGHT, Layout, Indexer>::classFor(float noise, action_mask_t available_actions)
+{
+    std::pair<float, action_mask_t> key(noise, available_actions);
+    typename std::map<std::pair<float, action_mask_t>, unsigned int>::iterator found = class_index_.find(key);
+    if (found != class_index_.end())
+    {
+        return found->second;
+    }
+
+    transition_class transitions;
+    int legal = countActions(available_actions);
+    transitions.noise = noise;
+    transitions.available_actions = available_actions;
+    for (int a = 0; a < ACTIONS; a++)
+    {
+        for (int k = 0; k < ACTIONS; k++)
+        {
+            float p = (k == a) ? 1.0f - noise : 0.0f;
+            if ((available_actions >> k) & 1)
+            {
+                p += noise / legal;
+            }
+            transitions.probability[a][k] = p;
+        }
+        transitions.outcome[a].build(transitions.probability[a], ACTIONS);
+    }
+
+    classes_.push_back(transitions);
+    class_index_[key] = classes_.size() - 1;
+    return classes_.size() - 1;
+}
+
+/**
+    Return the reward for the agents state transitions
+*/
+template <int WIDTH, int HEIGHT, class Layout, class Indexer>
+constexpr signed short int gridWorld<WIDTH, HEIGHT, Layout, Indexer>::rewardOf(state_t next_state)
+{
+    int x = xOf(next_state);
+    int y = yOf(next_state);
+
+    //punish for moving into obstacles
+    if (Layout::isObstacle(x, y, WIDTH, HEIGHT))
+    {
+        return PUNISHMENT;
+    }
+    //reward for moving into goal
+    else if (Layout::isGoal(x, y, WIDTH, HEIGHT))
+    {
+        return REWARD;
+    }
+    // slightly punish for state transition
+    return STATE_TRANSITION_COST;
+}
+
+/**
+    Return true when next_state ends the episode: the goal or an obstacle. States that are not cells are
+    terminal too, so the planner gives them no value
+*/
+template <int WIDTH, int HEIGHT, class Layout, class Indexer>
+constexpr bool gridWorld<WIDTH, HEIGHT, Layout, Indexer>::isTerminal(state_t next_state)
+{
+    return !isCell(next_state) || Layout::isObstacle(xOf(next_state), yOf(next_state), WIDTH, HEIGHT) ||
+           Layout::isGoal(xOf(next_state), yOf(next_state), WIDTH, HEIGHT);
+}
+
 #endif // gridWorld_H
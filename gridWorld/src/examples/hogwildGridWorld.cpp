@@ -0,0 +1,281 @@
+/**
+    This script runs Hogwild q-learning in the gridworld environment: K threads each run their own episodes,
+    with their own world and random streams, and all of them update one shared Q table (rl/relaxed_float.hpp)
+    without locks.
+    A run ends when the greedy policy of the table is optimal in every state (planner Q* as the ground truth)
+    and, with --tolerance, no Q value is further than that from Q*. The table is checked every
+    --check-period episodes counted over all threads, so the checks cost the same for any K.
+    For every K from 1 to --threads it prints the median wall clock time to convergence over --repeats
+    seeds, the episodes it took, the speedup over the single threaded loop of qLearningGridWorld (plain
+    float table, no atomics) and the scaling efficiency, speedup / K.
+    The parameters are those of qLearningGridWorld except epsilon, which stays at EPSILON so every state
+    keeps being visited until the run converges. The moves are deterministic by default: with the noise of
+    the examples and a constant learning rate the Q values keep moving with every slip, so the greedy policy
+    flickers and a run has no point at which it is done.
+
+    Usage: hogwildGridWorld_example [options]
+        --threads 4           largest number of threads, all cores by default
+        --repeats 5           runs per thread count, each with its own seed
+        --seed 1              seed of the first run
+        --check-period 10     episodes between convergence checks
+        --tolerance 0         largest distance to Q* of a converged table, 0 only checks the policy
+        --max-episodes 100000 episodes over all threads before a run gives up
+        --noise 0             percent chance that a move goes in a random direction
+
+    @author Alex Cornelio
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "gridWorld.hpp"
+
+#include <rl/planner.hpp>
+#include <rl/q_learning.hpp>
+#include <rl/relaxed_float.hpp>
+#include <rl/training.hpp>
+
+// grid size, override with -DGRID_WIDTH=.. -DGRID_HEIGHT=..
+#ifndef GRID_WIDTH
+#define GRID_WIDTH 4
+#endif
+#ifndef GRID_HEIGHT
+#define GRID_HEIGHT 3
+#endif
+// agent parameters, as in qLearningGridWorld
+#define DISCOUNT_FACTOR 0.5
+#define ALPHA 0.5
+#define EPSILON 0.5
+// steps before an episode is cut off, so a thread notices the end of the run
+#define MAX_STEPS 100000
+
+using namespace std;
+
+typedef gridWorld<GRID_WIDTH, GRID_HEIGHT> grid_world;
+typedef QTable<grid_world::STATES, ACTIONS, relaxed_float> shared_table;
+
+/**
+    How long one run took
+*/
+struct run_result
+{
+    double seconds;
+    unsigned long episodes;
+    bool converged;
+};
+
+/**
+    Settings shared by every run
+*/
+struct run_settings
+{
+    unsigned int check_period;
+    float tolerance;
+    unsigned long max_episodes;
+    float noise;
+};
+
+/**
+    Return whether Q has converged to the planner's Q*
+*/
+template <class Table>
+static bool converged(const planner &optimal, Table &Q, float tolerance)
+{
+    return optimal.policyAgreement(Q) >= 1.0f && (tolerance <= 0 || optimal.distance(Q) < tolerance);
+}
+
+static double secondsSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+    The single threaded loop of qLearningGridWorld on a plain float table
+*/
+static run_result serialRun(const planner &optimal, const run_settings &settings, unsigned long long seed)
+{
+    static grid_world env;
+    env.Q.fill(0);
+    env.setUniformNoise(settings.noise / 100.0f);
+    q_learning controller;
+    controller.seed(seed, 0);
+    env.seed(seed, 1);
+    td_parameters params = {ALPHA, DISCOUNT_FACTOR};
+    run_result result = {0, 0, false};
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    while (result.episodes < settings.max_episodes && !result.converged)
+    {
+        qLearningEpisode(env, env.Q, controller, env.START_STATE, EPSILON, params, MAX_STEPS);
+        result.episodes++;
+        result.converged = result.episodes % settings.check_period == 0 && converged(optimal, env.Q, settings.tolerance);
+    }
+    result.seconds = secondsSince(start);
+    return result;
+}
+
+/**
+    K threads training one shared table. Thread k draws from streams 2k and 2k + 1 of seed
+*/
+static run_result hogwildRun(const planner &optimal, const run_settings &settings, unsigned int threads,
+                             unsigned long long seed)
+{
+    static shared_table Q(0);
+    Q.fill(0);
+    atomic<unsigned long> episodes(0);
+    atomic<bool> done(false);
+    atomic<bool> success(false);
+    double seconds = 0;
+
+    // every thread builds its world before the clock starts
+    vector<grid_world *> envs(threads);
+    for (unsigned int k = 0; k < threads; k++)
+    {
+        envs[k] = new grid_world();
+        envs[k]->setUniformNoise(settings.noise / 100.0f);
+        envs[k]->seed(seed, 2 * k + 1);
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (unsigned int k = 0; k < threads; k++)
+    {
+        workers.push_back(thread([&, k] {
+            grid_world &env = *envs[k];
+            q_learning controller;
+            controller.seed(seed, 2 * k);
+            td_parameters params = {ALPHA, DISCOUNT_FACTOR};
+
+            while (!done.load(memory_order_relaxed))
+            {
+                qLearningEpisode(env, Q, controller, env.START_STATE, EPSILON, params, MAX_STEPS);
+                unsigned long count = episodes.fetch_add(1, memory_order_relaxed) + 1;
+                if (count % settings.check_period != 0)
+                {
+                    continue;
+                }
+                bool reached = converged(optimal, Q, settings.tolerance);
+                if ((reached || count >= settings.max_episodes) && !done.exchange(true))
+                {
+                    // only the first thread to get here stops the clock
+                    seconds = secondsSince(start);
+                    success = reached;
+                }
+            }
+        }));
+    }
+    for (unsigned int k = 0; k < threads; k++)
+    {
+        workers[k].join();
+        delete envs[k];
+    }
+
+    run_result result = {seconds, episodes.load(), success.load()};
+    return result;
+}
+
+/**
+    Median of the times of the runs that converged, -1 when fewer than half of them did
+*/
+static double medianSeconds(vector<run_result> runs)
+{
+    vector<double> times;
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        if (runs[i].converged)
+        {
+            times.push_back(runs[i].seconds);
+        }
+    }
+    if (times.size() * 2 < runs.size())
+    {
+        return -1;
+    }
+    // runs that did not converge count as the slowest
+    times.resize(runs.size(), 1e30);
+    sort(times.begin(), times.end());
+    return times[(times.size() - 1) / 2];
+}
+
+static unsigned long medianEpisodes(vector<run_result> runs)
+{
+    vector<unsigned long> counts;
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        counts.push_back(runs[i].episodes);
+    }
+    sort(counts.begin(), counts.end());
+    return counts[counts.size() / 2];
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int max_threads = thread::hardware_concurrency();
+    unsigned int repeats = 5;
+    unsigned long long seed = 1;
+    run_settings settings = {10, 0, 100000, 0};
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        string option = argv[i];
+        string value = argv[i + 1];
+        if (option == "--threads") max_threads = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--repeats") repeats = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--seed") seed = strtoull(value.c_str(), NULL, 10);
+        else if (option == "--check-period") settings.check_period = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--tolerance") settings.tolerance = strtof(value.c_str(), NULL);
+        else if (option == "--max-episodes") settings.max_episodes = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--noise") settings.noise = strtof(value.c_str(), NULL);
+        else
+        {
+            cerr<<"unknown option "<<option<<endl;
+            return 1;
+        }
+    }
+    if (max_threads == 0 || repeats == 0 || settings.check_period == 0)
+    {
+        cerr<<"threads, repeats and check period must be at least 1"<<endl;
+        return 1;
+    }
+
+    static grid_world env;
+    env.setUniformNoise(settings.noise / 100.0f);
+    planner optimal(grid_world::STATES, ACTIONS);
+    buildModel(optimal, env);
+    optimal.valueIteration(DISCOUNT_FACTOR, 1e-3);
+
+    vector<run_result> serial;
+    for (unsigned int r = 0; r < repeats; r++)
+    {
+        serial.push_back(serialRun(optimal, settings, seed + r));
+    }
+    double serial_seconds = medianSeconds(serial);
+
+    printf("%dx%d grid, %u runs per row from seed %llu, medians\n", GRID_WIDTH, GRID_HEIGHT, repeats, seed);
+    printf("%-8s %8s %12s %10s %8s %10s\n", "mode", "threads", "seconds", "episodes", "speedup", "efficiency");
+    printf("%-8s %8u %12.6f %10lu %8s %10s\n", "serial", 1u, serial_seconds, medianEpisodes(serial), "1.00", "1.00");
+    for (unsigned int k = 1; k <= max_threads; k++)
+    {
+        vector<run_result> runs;
+        for (unsigned int r = 0; r < repeats; r++)
+        {
+            runs.push_back(hogwildRun(optimal, settings, k, seed + r));
+        }
+        double seconds = medianSeconds(runs);
+        if (seconds < 0 || serial_seconds < 0)
+        {
+            printf("%-8s %8u %12s %10lu %8s %10s\n", "hogwild", k, "-", medianEpisodes(runs), "-", "-");
+            continue;
+        }
+        double speedup = serial_seconds / seconds;
+        printf("%-8s %8u %12.6f %10lu %8.2f %10.2f\n", "hogwild", k, seconds, medianEpisodes(runs), speedup, speedup / k);
+    }
+    return 0;
+}
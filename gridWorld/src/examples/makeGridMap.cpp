@@ -0,0 +1,87 @@
+/**
+    Writes a map file for mapGridWorld.
+    The map is the cliff world of gridWorld (start bottom left, goal bottom right, obstacles between them) with
+    an optional share of extra obstacles scattered over the rest of the grid.
+
+    Usage: makeGridMap <file> <width> <height> [obstacle percent] [seed]
+
+    @author Alex Cornelio
+*/
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <rl/random.hpp>
+
+#include "mapGridWorld.hpp"
+
+using namespace std;
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        cerr<<"usage: "<<argv[0]<<" <file> <width> <height> [obstacle percent] [seed]"<<endl;
+        return 1;
+    }
+    uint32_t width = strtoul(argv[2], NULL, 10);
+    uint32_t height = strtoul(argv[3], NULL, 10);
+    float obstacle_percent = (argc > 4) ? strtof(argv[4], NULL) : 0;
+    random_engine rng((argc > 5) ? strtoull(argv[5], NULL, 10) : 0);
+
+    uint64_t cells = (uint64_t)width * height;
+    if (width < 2 || height < 1 || cells > 0x7fffffff)
+    {
+        cerr<<"map must be at least 2x1 and have fewer than 2^31 cells"<<endl;
+        return 1;
+    }
+
+    grid_map_header header;
+    memcpy(header.magic, GRID_MAP_MAGIC, sizeof(header.magic));
+    header.width = width;
+    header.height = height;
+    header.start_state = 0;
+    header.reserved = 0;
+
+    // cells in state order, state = x*height + y
+    vector<unsigned char> packed((cells + 3) / 4, 0);
+    uint32_t threshold = (uint32_t)(obstacle_percent / 100.0f * 4294967296.0f);
+    for (uint64_t s = 0; s < cells; s++)
+    {
+        uint32_t x = s / height;
+        uint32_t y = s % height;
+        int cell = MAP_FREE;
+        if (cliffLayout::isGoal(x, y, width, height))
+        {
+            cell = MAP_GOAL;
+        }
+        else if (cliffLayout::isObstacle(x, y, width, height))
+        {
+            cell = MAP_OBSTACLE;
+        }
+        else if (s != header.start_state && (uint32_t)(rng.next() >> 32) < threshold)
+        {
+            cell = MAP_OBSTACLE;
+        }
+        packed[s >> 2] |= cell << ((s & 3) * 2);
+    }
+
+    FILE *file = fopen(argv[1], "wb");
+    if (file == NULL ||
+        fwrite(&header, sizeof(header), 1, file) != 1 ||
+        fwrite(packed.data(), 1, packed.size(), file) != packed.size())
+    {
+        cerr<<"cannot write "<<argv[1]<<endl;
+        if (file != NULL)
+        {
+            fclose(file);
+        }
+        return 1;
+    }
+    fclose(file);
+    cerr<<"wrote "<<width<<"x"<<height<<" map to "<<argv[1]<<endl;
+    return 0;
+}
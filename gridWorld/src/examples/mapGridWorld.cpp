@@ -0,0 +1,139 @@
+/**
+    Map grid world methods that are not on the step path: opening, hashing and closing the map
+    @author Alex Cornelio
+*/
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapGridWorld.hpp"
+
+/**
+    Constructor. The world is empty until a map is opened
+*/
+mapGridWorld::mapGridWorld()
+    :STATES(0),
+     START_STATE(0),
+     mapping_(NULL),
+     mapped_size_(0),
+     cells_(NULL),
+     width_(0),
+     height_(0),
+     height_reciprocal_(0)
+{
+    // outcome distributions for every set of available actions, as in gridWorld::classFor
+    float noise = NOISEY_TRANS_PROB / 100.0f;
+    for (action_mask_t available_actions = 1; available_actions < (1 << ACTIONS); available_actions++)
+    {
+        int legal = countActions(available_actions);
+        for (int a = 0; a < ACTIONS; a++)
+        {
+            for (int k = 0; k < ACTIONS; k++)
+            {
+                float p = (k == a) ? 1.0f - noise : 0.0f;
+                if ((available_actions >> k) & 1)
+                {
+                    p += noise / legal;
+                }
+                probability_[available_actions][a][k] = p;
+            }
+            outcome_[available_actions][a].build(probability_[available_actions][a], ACTIONS);
+        }
+    }
+}
+
+/**
+    Destructor
+*/
+mapGridWorld::~mapGridWorld()
+{
+    close();
+}
+
+/**
+    Map the file at path and size the Q table for it. Returns false if the file cannot be read or is not a
+    map, the world is then left empty
+*/
+bool mapGridWorld::open(const char *path)
+{
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(grid_map_header))
+    {
+        ::close(fd);
+        return false;
+    }
+    void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    const grid_map_header *header = static_cast<const grid_map_header *>(mapping);
+    uint64_t cells = (uint64_t)header->width * header->height;
+    if (memcmp(header->magic, GRID_MAP_MAGIC, sizeof(header->magic)) != 0 || header->width == 0 ||
+        header->height == 0 || cells > 0x7fffffff || header->start_state >= cells ||
+        (size_t)info.st_size < sizeof(grid_map_header) + (cells + 3) / 4)
+    {
+        munmap(mapping, info.st_size);
+        return false;
+    }
+
+    mapping_ = mapping;
+    mapped_size_ = info.st_size;
+    cells_ = static_cast<const unsigned char *>(mapping) + sizeof(grid_map_header);
+    width_ = header->width;
+    height_ = header->height;
+    height_reciprocal_ = UINT64_MAX / height_ + 1;
+    delta_state_[NORTH] = 1;
+    delta_state_[EAST] = height_;
+    delta_state_[SOUTH] = -1;
+    delta_state_[WEST] = -(state_t)height_;
+
+    STATES = (int)cells;
+    START_STATE = header->start_state;
+    Q = QTable<Q_TABLE_DYNAMIC_STATES, ACTIONS>(cells, 0);
+    return true;
+}
+
+/**
+    FNV-1a over the size, the start cell and every cell of the map, so copies of one map hash alike. Reads the
+    whole map
+*/
+uint64_t mapGridWorld::hash() const
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const unsigned char *data = static_cast<const unsigned char *>(mapping_) + offsetof(grid_map_header, width);
+    std::size_t bytes = sizeof(grid_map_header) - offsetof(grid_map_header, width) + ((std::size_t)STATES + 3) / 4;
+    for (std::size_t i = 0; mapping_ != NULL && i < bytes; i++)
+    {
+        hash = (hash ^ data[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+    Unmap the current map
+*/
+void mapGridWorld::close()
+{
+    if (mapping_ != NULL)
+    {
+        munmap(mapping_, mapped_size_);
+    }
+    mapping_ = NULL;
+    cells_ = NULL;
+    mapped_size_ = 0;
+    STATES = 0;
+}
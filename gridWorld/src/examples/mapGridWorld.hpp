@@ -0,0 +1,133 @@
+/**
+    Grid world loaded from a map file.
+    The file is a small header followed by two bits per cell (free, obstacle or goal) in state order, so cell s
+    is bits 2s and 2s+1. The file is memory mapped and read in place: opening a map with millions of cells
+    costs the same as opening a 4x3 one, and only the pages the agent visits are ever read from disk.
+    States, actions, rewards and noise are the same as gridWorld's, so the drivers run on either.
+    Maps are written by makeGridMap.
+
+    @author Alex Cornelio
+*/
+
+#ifndef MAP_GRID_WORLD_H
+#define MAP_GRID_WORLD_H
+
+#include <stdint.h>
+
+#include "gridWorld.hpp"
+
+#define GRID_MAP_MAGIC "GRIDMAP1"
+
+// cell classes, two bits per cell
+#define MAP_FREE 0
+#define MAP_OBSTACLE 1
+#define MAP_GOAL 2
+
+/**
+    Start of a map file. Followed by (width*height + 3)/4 bytes of cells
+*/
+struct grid_map_header
+{
+    char magic[8];
+    uint32_t width;
+    uint32_t height;
+    uint32_t start_state;
+    uint32_t reserved;
+};
+
+class mapGridWorld : public environment, public static_environment<mapGridWorld>
+{
+public:
+    // number of cells and the start cell, set by open()
+    int STATES;
+    state_t START_STATE;
+
+    // Q table, one row per cell
+    QTable<Q_TABLE_DYNAMIC_STATES, ACTIONS> Q;
+
+    mapGridWorld();
+    ~mapGridWorld();
+
+    bool open(const char *path);
+    void close();
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    uint64_t hash() const;
+
+    action_mask_t availableActions(state_t s) final { return actionMask(s); }
+    state_t takeAction(char action, state_t current_state) { return current_state + delta_state_[(int)action]; }
+    state_t nextState(char action, state_t current_state, action_mask_t) final { return sampleNext(action, current_state); }
+    signed short int getReward(state_t next_state) final { return rewardOf(next_state); }
+    state_t getStateIndex(state_t current_state) { return current_state; }
+
+    // static interface
+    action_mask_t actionMask(state_t s) const;
+    state_t sampleNext(char action, state_t current_state);
+    signed short int rewardOf(state_t next_state) const;
+    bool isTerminal(state_t next_state) const { return cellOf(next_state) != MAP_FREE; }
+
+    const float *outcomeProbabilities(state_t s, char action) const;
+    int cellOf(state_t s) const { return (cells_[s >> 2] >> ((s & 3) * 2)) & 3; }
+
+private:
+    void *mapping_;
+    size_t mapped_size_;
+    const unsigned char *cells_;
+
+    uint32_t width_;
+    uint32_t height_;
+    // 2^64 / height rounded up, turns s / height into a multiply (Lemire's fast division)
+    uint64_t height_reciprocal_;
+    state_t delta_state_[ACTIONS];
+
+    // outcome distributions, the noise is the same everywhere so they only depend on the available actions
+    float probability_[1 << ACTIONS][ACTIONS][ACTIONS];
+    alias_table<ACTIONS> outcome_[1 << ACTIONS][ACTIONS];
+};
+
+/**
+    Return a bitmask of the actions available in cell s. The agent cannot go beyond the grid's boards
+*/
+inline action_mask_t mapGridWorld::actionMask(state_t s) const
+{
+    // one row maps have no reciprocal that fits, their branch is always predicted the same way
+    uint32_t x = height_ == 1 ? (uint32_t)s : (uint32_t)(((unsigned __int128)height_reciprocal_ * (uint32_t)s) >> 64);
+    uint32_t y = (uint32_t)s - x * height_;
+    return (x != width_ - 1 ? 1 << EAST : 0) | (x != 0 ? 1 << WEST : 0) |
+           (y != height_ - 1 ? 1 << NORTH : 0) | (y != 0 ? 1 << SOUTH : 0);
+}
+
+/**
+    Return the next state from taking an action in the current state, with gridWorld's noise
+*/
+inline state_t mapGridWorld::sampleNext(char action, state_t current_state)
+{
+    return takeAction(outcome_[actionMask(current_state)][(int)action].sample(rng), current_state);
+}
+
+/**
+    Return the reward for arriving in next_state
+*/
+inline signed short int mapGridWorld::rewardOf(state_t next_state) const
+{
+    switch (cellOf(next_state))
+    {
+    case MAP_OBSTACLE:
+        return PUNISHMENT;
+    case MAP_GOAL:
+        return REWARD;
+    default:
+        return STATE_TRANSITION_COST;
+    }
+}
+
+/**
+    Return the probability of each action actually being carried out when action is taken in state s
+*/
+inline const float *mapGridWorld::outcomeProbabilities(state_t s, char action) const
+{
+    return probability_[actionMask(s)][(int)action];
+}
+
+#endif // MAP_GRID_WORLD_H
@@ -0,0 +1,30 @@
+/**
+    Medians the multi-seed examples report. A run that never got there is stored as a negative value and
+    counts as slower than every run that did.
+
+    @author Alex Cornelio
+*/
+
+#ifndef MEDIANS_H
+#define MEDIANS_H
+
+#include <algorithm>
+#include <vector>
+
+/**
+    Median of values, -1 when fewer than half of them are set (not negative)
+*/
+inline float median(std::vector<float> values)
+{
+    std::sort(values.begin(), values.end());
+    std::size_t missing = std::count_if(values.begin(), values.end(), [](float v) { return v < 0; });
+    if (missing * 2 > values.size())
+    {
+        return -1;
+    }
+    // missing runs count as never getting there, so they sort last
+    std::rotate(values.begin(), values.begin() + missing, values.end());
+    return values[(values.size() - 1) / 2];
+}
+
+#endif // MEDIANS_H
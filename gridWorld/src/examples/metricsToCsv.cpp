@@ -0,0 +1,54 @@
+/**
+    This script converts a metrics file written by the examples (rl/metrics.hpp) to CSV, one line per
+    episode with a header line, for spreadsheets and plot_results.py.
+
+    Usage: metricsToCsv in.bin [out.csv]. Without out.csv the lines go to stdout.
+
+    @author Alex Cornelio
+*/
+
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+
+#include <rl/metrics.hpp>
+
+using namespace std;
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        cerr<<"usage: metricsToCsv in.bin [out.csv]"<<endl;
+        return 1;
+    }
+
+    vector<metrics_record> records;
+    unsigned int sample_every;
+    if (!readMetrics(argv[1], records, &sample_every))
+    {
+        cerr<<"cannot read metrics from "<<argv[1]<<endl;
+        return 1;
+    }
+    FILE *out = (argc > 2) ? fopen(argv[2], "w") : stdout;
+    if (!out)
+    {
+        cerr<<"cannot create "<<argv[2]<<endl;
+        return 1;
+    }
+
+    fprintf(out, "group,run,episode,time_step,wins,loses,epsilon,return\n");
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        const metrics_record &r = records[i];
+        fprintf(out, "%u,%u,%u,%u,%u,%u,%g,%g\n", r.group, r.run, r.episode, r.steps, r.wins, r.loses, r.epsilon,
+                r.episode_return);
+    }
+    bool ok = fflush(out) == 0;
+    if (out != stdout)
+    {
+        ok = fclose(out) == 0 && ok;
+    }
+    cerr<<records.size()<<" episodes, every "<<sample_every<<" kept"<<endl;
+    return ok ? 0 : 1;
+}
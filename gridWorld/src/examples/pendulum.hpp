@@ -0,0 +1,131 @@
+/**
+    Host model of the balancing robot: an inverted pendulum on wheels, so the learners can be tried against
+    the robot's problem without Gazebo.
+    The pendulum leans by pitch degrees and the agent picks one of PENDULUM_ACTIONS wheel accelerations every
+    PENDULUM_DT seconds, the control period of the robot. The state is the pitch / pitch rate bin pair the
+    controllers use (rl/discretize.hpp) plus one state for having fallen over. Every step upright earns
+    PENDULUM_UPRIGHT_REWARD, falling past PENDULUM_FALL_ANGLE costs PENDULUM_FALL_PUNISHMENT and ends the
+    episode, so an episode is as long as the agent keeps it up or the step limit the driver gives.
+    A small random disturbance acts every step, the environment's random engine draws it and the start angle.
+
+    @author Alex Cornelio
+*/
+
+#ifndef PENDULUM_H
+#define PENDULUM_H
+
+#include <cmath>
+
+#include <rl/discretize.hpp>
+#include <rl/environment.hpp>
+#include <rl/q_table.hpp>
+#include <rl/random.hpp>
+#include <rl/static_environment.hpp>
+
+#define PENDULUM_ACTIONS 7
+#define PENDULUM_BINS_PHI 11
+#define PENDULUM_BINS_PHI_D 11
+
+// control period, seconds
+#define PENDULUM_DT 0.02f
+// integration steps per control period
+#define PENDULUM_SUBSTEPS 4
+// wheel axle to centre of mass, metres
+#define PENDULUM_LENGTH 0.2f
+#define PENDULUM_GRAVITY 9.81f
+// wheel acceleration between neighbouring actions, m/s^2. The middle action does not accelerate
+#define PENDULUM_ACCELERATION_STEP 1.0f
+// largest random angular acceleration, rad/s^2
+#define PENDULUM_DISTURBANCE 0.5f
+// degrees
+#define PENDULUM_FALL_ANGLE 6.0f
+#define PENDULUM_START_ANGLE 2.0f
+
+#define PENDULUM_UPRIGHT_REWARD 1
+#define PENDULUM_FALL_PUNISHMENT -100
+
+// pitch (degrees) and pitch rate (degrees/s) bin edges
+static const float pendulum_phi_states[PENDULUM_BINS_PHI] = {-5, -3, -2, -1, -0.5, 0, 0.5, 1, 2, 3, 5};
+static const float pendulum_phi_d_states[PENDULUM_BINS_PHI_D] = {-40, -25, -15, -8, -3, 0, 3, 8, 15, 25, 40};
+
+class pendulum : public static_environment<pendulum>
+{
+public:
+    static constexpr int STATES = (PENDULUM_BINS_PHI + 1) * (PENDULUM_BINS_PHI_D + 1) + 1;
+    static constexpr state_t FALLEN_STATE = STATES - 1;
+
+    // Q table
+    QTable<STATES, PENDULUM_ACTIONS> Q;
+
+    // random engine for the start angle and the disturbance
+    random_engine rng;
+
+    pendulum() : Q(0), pitch_(0), pitch_dot_(0) {}
+
+    void seed(uint64_t seed_value, uint64_t stream = 0) { rng.seed(seed_value, stream); }
+    state_t reset();
+
+    float pitch() const { return pitch_; }
+    float pitchDot() const { return pitch_dot_; }
+
+    // static interface
+    static constexpr action_mask_t actionMask(state_t) { return (1 << PENDULUM_ACTIONS) - 1; }
+    state_t sampleNext(char action, state_t current_state);
+    static constexpr signed short int rewardOf(state_t next_state)
+    {
+        return next_state == FALLEN_STATE ? PENDULUM_FALL_PUNISHMENT : PENDULUM_UPRIGHT_REWARD;
+    }
+    static constexpr bool isTerminal(state_t next_state) { return next_state == FALLEN_STATE; }
+
+private:
+    // degrees and degrees/s
+    float pitch_;
+    float pitch_dot_;
+
+    state_t stateOf() const;
+};
+
+/**
+    Stand the pendulum up at a random angle within PENDULUM_START_ANGLE, at rest. Returns its state
+*/
+inline state_t pendulum::reset()
+{
+    pitch_ = (2 * rng.uniform() - 1) * PENDULUM_START_ANGLE;
+    pitch_dot_ = 0;
+    return stateOf();
+}
+
+/**
+    Accelerate the wheels by action for one control period and return the state the pendulum ends in.
+    The pendulum carries its own continuous state, so the bin it is in now is not needed
+*/
+inline state_t pendulum::sampleNext(char action, state_t)
+{
+    const float degrees = 180.0f / 3.14159265f;
+    float acceleration = (action - PENDULUM_ACTIONS / 2) * PENDULUM_ACCELERATION_STEP;
+    float disturbance = (2 * rng.uniform() - 1) * PENDULUM_DISTURBANCE;
+    float theta = pitch_ / degrees;
+    float theta_dot = pitch_dot_ / degrees;
+    float h = PENDULUM_DT / PENDULUM_SUBSTEPS;
+
+    // semi implicit Euler on theta'' = (g sin(theta) - a cos(theta)) / l
+    for (int i = 0; i < PENDULUM_SUBSTEPS; i++)
+    {
+        float theta_ddot = (PENDULUM_GRAVITY * std::sin(theta) - acceleration * std::cos(theta)) / PENDULUM_LENGTH + disturbance;
+        theta_dot += theta_ddot * h;
+        theta += theta_dot * h;
+    }
+    pitch_ = theta * degrees;
+    pitch_dot_ = theta_dot * degrees;
+    return std::fabs(pitch_) > PENDULUM_FALL_ANGLE ? FALLEN_STATE : stateOf();
+}
+
+/**
+    Return the bin of the current pitch and pitch rate
+*/
+inline state_t pendulum::stateOf() const
+{
+    return pitchState(pitch_, pitch_dot_, pendulum_phi_states, pendulum_phi_d_states);
+}
+
+#endif // PENDULUM_H
@@ -0,0 +1,168 @@
+/**
+    This script measures how much storing Q values in 16 bits (rl/q_value.hpp) changes learning.
+    Q-learning is run with float, half_float and fixed16 tables from the same seeds, so the agent and the
+    environment draw the same random numbers until the first rounding difference changes a decision.
+    - gridWorld: the cliff world of the examples, explored at a constant epsilon so every state keeps being
+      updated. Reports the fraction of states where the greedy action is optimal (planner Q* as the ground
+      truth), averaged over the last GRID_WINDOW episodes, and the distance to Q* after the last episode.
+    - pendulum: the host model of the balancing robot (pendulum.hpp). Reports the episode at which the mean
+      length of the last PENDULUM_WINDOW episodes first reaches PENDULUM_GOAL of the step limit and the mean
+      length of the last PENDULUM_WINDOW episodes.
+    Every figure is the median over the seeds, -1 when fewer than half of the runs got there. Row bytes is
+    the size of one padded row of the table.
+
+    Usage: precisionStudy_example [seeds] [first seed]
+
+    @author Alex Cornelio
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "gridWorld.hpp"
+#include "medians.hpp"
+#include "pendulum.hpp"
+
+#include <rl/planner.hpp>
+#include <rl/q_learning.hpp>
+#include <rl/q_value.hpp>
+#include <rl/training.hpp>
+
+// grid size, override with -DGRID_WIDTH=.. -DGRID_HEIGHT=..
+#ifndef GRID_WIDTH
+#define GRID_WIDTH 4
+#endif
+#ifndef GRID_HEIGHT
+#define GRID_HEIGHT 3
+#endif
+
+#define SEEDS 10
+
+// grid world agent, the discount factor of qLearningGridWorld
+#define GRID_EPISODES 500
+#define GRID_DISCOUNT_FACTOR 0.5
+#define GRID_ALPHA 0.1
+#define GRID_EPSILON 0.5
+#define GRID_WINDOW 100
+
+// pendulum agent
+#define PENDULUM_EPISODES 2000
+#define PENDULUM_MAX_STEPS 500
+#define PENDULUM_DISCOUNT_FACTOR 0.9
+#define PENDULUM_ALPHA 0.3
+#define PENDULUM_EPSILON 0.2
+#define PENDULUM_EPSILON_DECAY 0.998
+#define PENDULUM_WINDOW 100
+#define PENDULUM_GOAL 0.9
+
+using namespace std;
+
+typedef gridWorld<GRID_WIDTH, GRID_HEIGHT> grid_world;
+
+/**
+    One grid world run. Returns the mean fraction of optimal greedy actions over the last GRID_WINDOW episodes
+    and sets the final distance to Q*
+*/
+template <typename T>
+static float gridRun(grid_world &env, const planner &optimal, unsigned long long seed, float &distance)
+{
+    QTable<grid_world::STATES, ACTIONS, T> Q(0);
+    q_learning controller;
+    controller.seed(seed, 0);
+    env.seed(seed, 1);
+    td_parameters params = {GRID_ALPHA, GRID_DISCOUNT_FACTOR};
+    float agreement = 0;
+
+    for (int episode = 0; episode < GRID_EPISODES; episode++)
+    {
+        qLearningEpisode(env, Q, controller, grid_world::START_STATE, GRID_EPSILON, params);
+        if (episode >= GRID_EPISODES - GRID_WINDOW)
+        {
+            agreement += optimal.policyAgreement(Q) / GRID_WINDOW;
+        }
+    }
+    distance = optimal.distance(Q);
+    return agreement;
+}
+
+/**
+    One pendulum run. Returns the episode at which the pendulum is first kept up long enough on average (-1
+    if never) and sets the mean episode length of the last window
+*/
+template <typename T>
+static float pendulumRun(unsigned long long seed, float &final_length)
+{
+    pendulum env;
+    QTable<pendulum::STATES, PENDULUM_ACTIONS, T> Q(0);
+    q_learning controller;
+    controller.seed(seed, 0);
+    env.seed(seed, 1);
+    td_parameters params = {PENDULUM_ALPHA, PENDULUM_DISCOUNT_FACTOR};
+    float epsilon = PENDULUM_EPSILON;
+    vector<unsigned int> lengths;
+    unsigned long window_sum = 0;
+    float reached = -1;
+
+    for (int episode = 0; episode < PENDULUM_EPISODES; episode++)
+    {
+        episode_result result = qLearningEpisode(env, Q, controller, env.reset(), epsilon, params, PENDULUM_MAX_STEPS);
+        lengths.push_back(result.steps);
+        window_sum += result.steps;
+        if (lengths.size() > PENDULUM_WINDOW)
+        {
+            window_sum -= lengths[lengths.size() - 1 - PENDULUM_WINDOW];
+        }
+        if (reached < 0 && lengths.size() >= PENDULUM_WINDOW && window_sum >= PENDULUM_GOAL * PENDULUM_MAX_STEPS * PENDULUM_WINDOW)
+        {
+            reached = episode + 1;
+        }
+        epsilon *= PENDULUM_EPSILON_DECAY;
+    }
+    final_length = (float)window_sum / PENDULUM_WINDOW;
+    return reached;
+}
+
+/**
+    Run every seed with Q values stored as T and print the medians of both environments
+*/
+template <typename T>
+static void study(const char *storage, grid_world &env, const planner &optimal, unsigned int seeds, unsigned long long first_seed)
+{
+    vector<float> grid_agreements, grid_distances, pendulum_episodes, pendulum_lengths;
+    for (unsigned int k = 0; k < seeds; k++)
+    {
+        float distance, length;
+        grid_agreements.push_back(gridRun<T>(env, optimal, first_seed + k, distance));
+        grid_distances.push_back(distance);
+        pendulum_episodes.push_back(pendulumRun<T>(first_seed + k, length));
+        pendulum_lengths.push_back(length);
+    }
+
+    printf("%-10s %-8s %9u %16.3f %16.3f\n", "gridWorld", storage, (unsigned int)(QTable<1, ACTIONS, T>::STRIDE * sizeof(T)),
+           median(grid_agreements), median(grid_distances));
+    printf("%-10s %-8s %9u %16.1f %16.1f\n", "pendulum", storage, (unsigned int)(QTable<1, PENDULUM_ACTIONS, T>::STRIDE * sizeof(T)),
+           median(pendulum_episodes), median(pendulum_lengths));
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int seeds = (argc > 1) ? atoi(argv[1]) : SEEDS;
+    unsigned long long first_seed = (argc > 2) ? strtoull(argv[2], NULL, 10) : 1;
+
+    static grid_world env;
+    planner optimal(grid_world::STATES, ACTIONS);
+    buildModel(optimal, env);
+    optimal.valueIteration(GRID_DISCOUNT_FACTOR, 1e-3);
+
+    printf("%u seeds from %llu, medians\n", seeds, first_seed);
+    // gridWorld: optimal actions, distance to Q*. pendulum: episodes until balanced, mean episode length
+    printf("%-10s %-8s %9s %16s %16s\n", "env", "storage", "row bytes", "optimal/episodes", "distance/length");
+    study<float>("float", env, optimal, seeds, first_seed);
+    study<half_float>("half", env, optimal, seeds, first_seed);
+    study<fixed16<Q_FIXED16_FRACTION_BITS> >("fixed16", env, optimal, seeds, first_seed);
+    return 0;
+}
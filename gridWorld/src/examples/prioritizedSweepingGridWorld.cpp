@@ -0,0 +1,200 @@
+/**
+    This script compares prioritized sweeping (rl/prioritized_sweeping.hpp) with the q-learning loop of
+    qLearningGridWorld in the noisy gridworld environment, by the real steps each needs.
+    Both agents explore at a constant EPSILON and run episodes until they have taken the last number of
+    --steps real steps. The planner's Q* is the ground truth. After every episode the table is checked, and
+    the first real step after which the greedy policy is optimal in every state is the step the run
+    converged. At each number of --steps, where an episode is cut off if it is still running, the fraction of
+    optimal greedy actions and the distance to Q* are recorded. Prints the medians over --seeds seeds, and
+    the wall clock time per run.
+    With noise the values prioritized sweeping settles on are those of its model, whose transition counts
+    only approach the real probabilities, so on larger grids states with nearly equal actions can stay wrong
+    for a long time; the fraction of optimal actions shows how close it gets.
+
+    Usage: prioritizedSweepingGridWorld_example [options]
+        --seeds 10                   runs per agent, each with its own seed
+        --seed 1                     seed of the first run
+        --steps 1000,5000,20000      real steps at which the tables are measured
+        --backups 5                  backups prioritized sweeping does after every real step
+
+    @author Alex Cornelio
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "gridWorld.hpp"
+#include "medians.hpp"
+
+#include <rl/planner.hpp>
+#include <rl/prioritized_sweeping.hpp>
+#include <rl/q_learning.hpp>
+#include <rl/training.hpp>
+
+// grid size, override with -DGRID_WIDTH=.. -DGRID_HEIGHT=..
+#ifndef GRID_WIDTH
+#define GRID_WIDTH 4
+#endif
+#ifndef GRID_HEIGHT
+#define GRID_HEIGHT 3
+#endif
+// agent parameters, as in qLearningGridWorld
+#define DISCOUNT_FACTOR 0.5
+#define ALPHA 0.5
+#define EPSILON 0.5
+
+using namespace std;
+
+typedef gridWorld<GRID_WIDTH, GRID_HEIGHT> grid_world;
+
+/**
+    Where one run got to
+*/
+struct run_result
+{
+    float steps_to_optimal;    // -1 if the greedy policy never was optimal everywhere
+    vector<float> agreement;   // at every checkpoint
+    vector<float> distance;
+    float seconds;
+};
+
+/**
+    Split a comma separated list of numbers
+*/
+static vector<unsigned long> stepList(const string &list)
+{
+    vector<unsigned long> values;
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, ','))
+    {
+        if (!item.empty())
+        {
+            values.push_back(strtoul(item.c_str(), NULL, 10));
+        }
+    }
+    sort(values.begin(), values.end());
+    return values;
+}
+
+/**
+    Run one agent up to the last checkpoint. sweeper is null for q-learning
+*/
+static run_result run(grid_world &env, const planner &optimal, prioritized_sweeping *sweeper, unsigned int backups,
+                      unsigned long long seed, const vector<unsigned long> &checkpoints)
+{
+    env.Q.fill(0);
+    if (sweeper)
+    {
+        sweeper->clear();
+    }
+    q_learning controller;
+    controller.seed(seed, 0);
+    env.seed(seed, 1);
+    td_parameters params = {ALPHA, DISCOUNT_FACTOR};
+    run_result result;
+    result.steps_to_optimal = -1;
+    unsigned long taken = 0;
+    size_t next = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    while (next < checkpoints.size())
+    {
+        unsigned int budget = (unsigned int)(checkpoints[next] - taken);
+        episode_result episode = sweeper
+            ? prioritizedSweepingEpisode(env, env.Q, controller, *sweeper, env.START_STATE, EPSILON, DISCOUNT_FACTOR, backups, budget)
+            : qLearningEpisode(env, env.Q, controller, env.START_STATE, EPSILON, params, budget);
+        taken += episode.steps;
+        float agreement = optimal.policyAgreement(env.Q);
+        if (result.steps_to_optimal < 0 && agreement >= 1.0f)
+        {
+            result.steps_to_optimal = taken;
+        }
+        while (next < checkpoints.size() && taken >= checkpoints[next])
+        {
+            result.agreement.push_back(agreement);
+            result.distance.push_back(optimal.distance(env.Q));
+            next++;
+        }
+    }
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+/**
+    Run every seed with one agent and print the medians
+*/
+static void study(const char *agent, grid_world &env, const planner &optimal, prioritized_sweeping *sweeper,
+                  unsigned int backups, unsigned int seeds, unsigned long long first_seed,
+                  const vector<unsigned long> &checkpoints)
+{
+    vector<run_result> runs;
+    vector<float> steps_to_optimal, seconds;
+    for (unsigned int k = 0; k < seeds; k++)
+    {
+        runs.push_back(run(env, optimal, sweeper, backups, first_seed + k, checkpoints));
+        steps_to_optimal.push_back(runs.back().steps_to_optimal);
+        seconds.push_back(runs.back().seconds);
+    }
+    printf("%s: %.0f real steps to an optimal policy, %.4f seconds per run\n", agent, median(steps_to_optimal),
+           median(seconds));
+    for (size_t c = 0; c < checkpoints.size(); c++)
+    {
+        vector<float> agreements, distances;
+        for (unsigned int k = 0; k < seeds; k++)
+        {
+            agreements.push_back(runs[k].agreement[c]);
+            distances.push_back(runs[k].distance[c]);
+        }
+        printf("    %10lu steps %14.3f %10.1f\n", checkpoints[c], median(agreements), median(distances));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int seeds = 10;
+    unsigned long long first_seed = 1;
+    vector<unsigned long> checkpoints = stepList("1000,5000,20000");
+    unsigned int backups = 5;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        string option = argv[i];
+        string value = argv[i + 1];
+        if (option == "--seeds") seeds = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--seed") first_seed = strtoull(value.c_str(), NULL, 10);
+        else if (option == "--steps") checkpoints = stepList(value);
+        else if (option == "--backups") backups = strtoul(value.c_str(), NULL, 10);
+        else
+        {
+            cerr<<"unknown option "<<option<<endl;
+            return 1;
+        }
+    }
+    if (seeds == 0 || checkpoints.empty() || checkpoints[0] == 0)
+    {
+        cerr<<"give at least one seed and one number of steps above zero"<<endl;
+        return 1;
+    }
+
+    static grid_world env;
+    planner optimal(grid_world::STATES, ACTIONS);
+    buildModel(optimal, env);
+    optimal.valueIteration(DISCOUNT_FACTOR, 1e-3);
+    prioritized_sweeping sweeper(grid_world::STATES, ACTIONS);
+
+    printf("%dx%d grid, %u seeds from %llu, medians. -1: fewer than half of the runs got there\n", GRID_WIDTH,
+           GRID_HEIGHT, seeds, first_seed);
+    printf("    %16s %14s %10s\n", "real steps", "optimal", "distance");
+    study("q-learning", env, optimal, NULL, 0, seeds, first_seed, checkpoints);
+    char agent[64];
+    snprintf(agent, sizeof(agent), "prioritized sweeping, %u backups per step", backups);
+    study(agent, env, optimal, &sweeper, backups, seeds, first_seed, checkpoints);
+    return 0;
+}
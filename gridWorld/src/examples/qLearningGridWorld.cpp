@@ -1,7 +1,23 @@
 /**
     This script runs q-learning in the gridworld environment. 
-    The agents state is defined by a 2 digit number where the first digit is its x coordinate and the second is its
-    y coordinate in the grid. 00 is the bottom left. 
+    The agents state is x*GRID_HEIGHT + y where (x, y) is its cell in the grid. (0, 0) is the bottom left. 
+    Usage: gridWorld_example [seed] [map file|-] [checkpoint file|-] [metrics file|-] [trace file]. With a map
+    file (see makeGridMap) the world is loaded from the file instead of being the compiled in GRID_WIDTH x
+    GRID_HEIGHT cliff world, - keeps the compiled in world and skips the other files.
+    With a checkpoint file the run is saved there every CHECKPOINT_EVERY episodes (rl/checkpoint.hpp), from a
+    thread of its own. If the file already holds a checkpoint of the same world the run resumes from it, and
+    goes on exactly as the run that wrote it did. A checkpoint of another world or agent, told by the size and
+    hash of the map, the seed, PLANNING_STEPS and LAMBDA it was written with, is left alone and the run fails.
+    With a metrics file the stats of every episode are written there as binary records (rl/metrics.hpp)
+    instead of being printed, a resumed run goes on with the file. With a trace file every real transition and
+    its TD error is written there (rl/trace.hpp), see traceColumn to read it. A resumed run needs a new one.
+    Built with -DPLANNING_STEPS=n the agent is Dyna-Q: it remembers every transition (rl/dyna_model.hpp) and
+    replays n of them after each real step. Built with -DLAMBDA=x it is Watkins' Q(lambda) instead, every TD
+    error going back along the eligibility traces of the episode (rl/eligibility_traces.hpp).
+    Training stops before MAX_EPISODE once it has settled (rl/convergence_detector.hpp): no greedy action has
+    changed for CONVERGENCE_WINDOW episodes and no value has moved by more than CONVERGENCE_TOLERANCE.
+    Built with -DREPORT_OPTIMAL=1 or -DOPTIMAL_TOLERANCE=x the planner (rl/planner.hpp) solves the world first
+    and every episode prints how far the agent is from its Q*, with a tolerance it also stops within it.
     Please see this thesis for more information on how this algorithm works.
 
     @author Alex Cornelio
@@ -9,97 +25,308 @@
 
 
 
+#include <fstream>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "gridWorld.hpp"
+#include "mapGridWorld.hpp"
 
-#include <rl/rl.h>
+#include <rl/rl.hpp>
+#include <rl/checkpoint.hpp>
+#include <rl/dyna_model.hpp>
+#include <rl/eligibility_traces.hpp>
+#include <rl/metrics.hpp>
+#include <rl/planner.hpp>
 #include <rl/q_learning.hpp>
+#include <rl/training.hpp>
 
 #define MAX_EPISODE 100
+
+// grid size, override with -DGRID_WIDTH=.. -DGRID_HEIGHT=..
+#ifndef GRID_WIDTH
+#define GRID_WIDTH 4
+#endif
+#ifndef GRID_HEIGHT
+#define GRID_HEIGHT 3
+#endif
 // agent parameters
 #define DISCOUNT_FACTOR 0.5
 #define ALPHA 0.5
 #define EPSILON 0.5
 
+// Dyna-Q updates from the model after every real step, 0 is plain q-learning
+#ifndef PLANNING_STEPS
+#define PLANNING_STEPS 0
+#endif
+
+// Q(lambda) with eligibility traces when above 0, 0 is one step q-learning. Ignored by Dyna-Q.
+// The traces move many values per step behind the convergence detector's back, so with them every run
+// goes on to MAX_EPISODE
+#ifndef LAMBDA
+#define LAMBDA 0
+#endif
+
+// stop once the greedy policy has not changed for this many episodes, 0 always runs MAX_EPISODE
+#ifndef CONVERGENCE_WINDOW
+#define CONVERGENCE_WINDOW 10
+#endif
+// and no value in them moved by more than this. With the constant ALPHA every win or fall still moves a value
+// by about half the reward, so by default only the policy has to settle
+#ifndef CONVERGENCE_TOLERANCE
+#define CONVERGENCE_TOLERANCE REWARD
+#endif
+
+// stop once no Q value is further than this from the planner's Q*, 0 never stops early
+#ifndef OPTIMAL_TOLERANCE
+#define OPTIMAL_TOLERANCE 0
+#endif
+// print the distance to the planner's Q* every episode. Planning and the distance scan cost far more than
+// training on big maps, so they only run when asked for here or by OPTIMAL_TOLERANCE
+#ifndef REPORT_OPTIMAL
+#define REPORT_OPTIMAL 0
+#endif
+// episodes between checkpoints, when a checkpoint file is given
+#ifndef CHECKPOINT_EVERY
+#define CHECKPOINT_EVERY 10
+#endif
+
+// worlds with more states are not planned, the model would not fit in memory
+#define PLANNER_MAX_STATES 4000000
+
+// checkpoint section of the run_config a checkpoint was written with
+#define CHECKPOINT_CONFIG CHECKPOINT_USER
+
 using namespace std;
 
-int main()
+/**
+    The world and agent a run trains, a checkpoint only resumes a run with the same
+*/
+struct run_config
+{
+    uint32_t width;
+    uint32_t height;
+    uint64_t map_hash;          // mapGridWorld::hash of the map file, 0 for the compiled in world
+    uint64_t seed;
+    uint32_t planning_steps;
+    float lambda;
+};
+
+/**
+    Return true if a and b are the same world and agent
+*/
+static bool sameConfig(const run_config &a, const run_config &b)
+{
+    return a.width == b.width && a.height == b.height && a.map_hash == b.map_hash && a.seed == b.seed &&
+           a.planning_steps == b.planning_steps && a.lambda == b.lambda;
+}
+
+/**
+    Fill snapshot with everything the run needs to go on after run.episode episodes
+*/
+template <class Env>
+static void snapshotRun(checkpoint &snapshot, const run_config &config, const Env &env, const q_learning &controller,
+                        const dyna_model &model, const convergence_detector &convergence, const run_state &run)
+{
+    snapshot.clear();
+    snapshot.add(CHECKPOINT_CONFIG, &config, sizeof(config));
+    snapshot.add(CHECKPOINT_RUN, &run, sizeof(run));
+    snapshot.addTable(CHECKPOINT_Q, env.Q);
+    snapshot.addEngine(CHECKPOINT_AGENT_RNG, controller.rng);
+    snapshot.addEngine(CHECKPOINT_ENV_RNG, env.rng);
+    convergence.save(snapshot);
+    if (PLANNING_STEPS > 0)
+    {
+        model.save(snapshot);
+    }
+}
+
+/**
+    Restore a run from snapshot. Returns false if it was not written by a run of config
+*/
+template <class Env>
+static bool restoreRun(const checkpoint &snapshot, const run_config &config, Env &env, q_learning &controller,
+                       dyna_model &model, convergence_detector &convergence, run_state &run)
+{
+    run_config saved;
+    return snapshot.get(CHECKPOINT_CONFIG, &saved, sizeof(saved)) && sameConfig(saved, config) &&
+           snapshot.get(CHECKPOINT_RUN, &run, sizeof(run)) && snapshot.getTable(CHECKPOINT_Q, env.Q) &&
+           snapshot.getEngine(CHECKPOINT_AGENT_RNG, controller.rng) && snapshot.getEngine(CHECKPOINT_ENV_RNG, env.rng) &&
+           convergence.load(snapshot) && (PLANNING_STEPS == 0 || model.load(snapshot));
+}
+
+/**
+    Train a q-learning agent in env, the world of config, checkpointing to checkpoint_file, keeping the stats
+    in metrics_file and the transitions in trace_file unless they are NULL. Returns false, without training,
+    if checkpoint_file holds the checkpoint of another world or agent or the files cannot be written, and false
+    if they were not written in full
+*/
+template <class Env>
+static bool train(Env &env, const run_config &config, const char *checkpoint_file, const char *metrics_file,
+                  const char *trace_file)
 {
     // create main variables
-    signed short int time_step, reward;
     unsigned int wins, loses;
-    float td_error, td_target, epsilon;
-    char current_state, action, next_state, current_state_idx, next_state_idx, max_action_idx;
-    std::vector<bool> availableActions(4, false);
-    std::vector<float> q_row(4);
+    float epsilon;
+    episode_result result;
+    td_parameters params = {ALPHA, DISCOUNT_FACTOR};
 
     // create object instances
     q_learning controller;
-    gridWorld env;
+    controller.seed(config.seed, 0);
+    env.seed(config.seed, 1);
+    dyna_model model(PLANNING_STEPS > 0 ? env.STATES : 0, ACTIONS);
+    model.seed(config.seed, 2);
+    convergence_detector convergence(CONVERGENCE_WINDOW, CONVERGENCE_TOLERANCE);
+    // the Q(lambda) updates go around the detector, see LAMBDA
+    bool lambda = LAMBDA > 0 && PLANNING_STEPS == 0;
+    convergence_detector *detector = CONVERGENCE_WINDOW > 0 && !lambda ? &convergence : NULL;
+    eligibility_traces traces(lambda ? env.STATES : 0, ACTIONS);
 
-    srand(time(NULL));//seed the randomizer
+    // optimal Q values from the model, the ground truth the agent is measured against
+    bool planned = (REPORT_OPTIMAL || OPTIMAL_TOLERANCE > 0) && env.STATES <= PLANNER_MAX_STATES;
+    planner optimal(planned ? env.STATES : 0, ACTIONS);
+    if (planned)
+    {
+        buildModel(optimal, env);
+        optimal.valueIteration(DISCOUNT_FACTOR, 1e-3);
+    }
 
     wins = 0;
     loses = 0;
     epsilon = EPSILON;
+    int first_episode = 0;
 
-    for (int episode = 0; episode < MAX_EPISODE; episode++)
+    // resume where the last checkpoint left off
+    checkpoint snapshot;
+    run_state run = {0, 0, 0, 0, EPSILON, ALPHA};
+    if (checkpoint_file && snapshot.read(checkpoint_file))
     {
+        if (!restoreRun(snapshot, config, env, controller, model, convergence, run))
+        {
+            cerr<<"checkpoint "<<checkpoint_file<<" is not of this world or agent"<<endl;
+            return false;
+        }
+        wins = run.wins;
+        loses = run.loses;
+        epsilon = run.epsilon;
+        first_episode = run.episode;
+        cerr<<"resuming from "<<checkpoint_file<<" after "<<first_episode<<" episodes"<<endl;
+    }
+    else if (checkpoint_file && ifstream(checkpoint_file))
+    {
+        cerr<<"checkpoint "<<checkpoint_file<<" is damaged, starting a new run"<<endl;
+    }
 
-        // initalise system
-        time_step = 0;
-        current_state = 0;
+    // a resumed run goes on with its metrics file. A trace can only be read once it is closed, so the
+    // interrupted run's trace is kept and the resumed run needs a new one
+    metrics_sink metrics_out;
+    trace_writer trace_out;
+    bool metrics_ok = !metrics_file || (first_episode > 0 ? metrics_out.resume(metrics_file, first_episode)
+                                                          : metrics_out.open(metrics_file));
+    if (!metrics_ok)
+    {
+        cerr<<"cannot write metrics to "<<metrics_file<<endl;
+        return false;
+    }
+    if (trace_file && first_episode > 0 && ifstream(trace_file))
+    {
+        cerr<<trace_file<<" holds the trace of the interrupted run, give the resumed run a new one"<<endl;
+        return false;
+    }
+    if (trace_file && !trace_out.open(trace_file))
+    {
+        cerr<<"cannot create "<<trace_file<<endl;
+        return false;
+    }
+    metrics_sink *metrics = metrics_file ? &metrics_out : NULL;
+    trace_writer *trace = trace_file ? &trace_out : NULL;
+
+    // deleting the writer waits for the last checkpoint
+    checkpoint_writer *writer = checkpoint_file ? new checkpoint_writer(checkpoint_file) : NULL;
 
-        // continue forever until the agent has reached goal state or failed
-        while(1)
+    for (int episode = first_episode; episode < MAX_EPISODE; episode++)
+    {
+        if (trace)
         {
-            //get all legal actions based on state
-            available_acctions = env.availableActions(current_state);
-
-            //choose action based on policy
-            current_state_idx = env.getStateIndex(current_state);
-            action = controller.chooseAction(epsilon, available_acctions, env.Q[current_state_idx]);
-
-            //take action to get nextstate
-            next_state = env.takeAction(action, current_state, available_acctions);
-
-            //get reward
-            reward = env.getReward(next_state);
-
-            //TD update
-            next_state_idx = env.getStateIndex(next_state);            
-            max_action_idx = distance(env.Q[next_state_idx].begin(), max_element(env.Q[next_state_idx].begin(), env.Q[next_state_idx].end()));
-            td_target = reward + DISCOUNT_FACTOR*env.Q[next_state_idx][max_action_idx];
-            td_error = td_target - env.Q[current_state_idx][action];
-            env.Q[current_state_idx][action]+= td_error*ALPHA;
-            
-            // update wins, counts, timesteps and states
-            if (reward == REWARD)
-            {
-                wins++;
-                break;
-            }
-            else if (reward == PUNISHMENT)
+            trace->beginEpisode(episode);
+        }
+
+        // run until the agent has reached goal state or failed. The loop is compiled for this environment,
+        // so the step, reward and TD update are inlined
+        if (PLANNING_STEPS > 0)
+        {
+            result = dynaQEpisode(env, env.Q, controller, model, env.START_STATE, epsilon, params, PLANNING_STEPS,
+                                  UINT_MAX, detector, trace);
+        }
+        else if (lambda)
+        {
+            result = qLambdaEpisode(env, env.Q, controller, traces, env.START_STATE, epsilon, params, LAMBDA,
+                                    UINT_MAX, trace);
+        }
+        else
+        {
+            result = qLearningEpisode(env, env.Q, controller, env.START_STATE, epsilon, params, UINT_MAX, detector,
+                                      trace);
+        }
+
+        run.steps += result.steps;
+
+        // a full scan of the table, only when it is printed or tested
+        float distance = 0;
+        if (planned && (!metrics || OPTIMAL_TOLERANCE > 0))
+        {
+            distance = optimal.distance(env.Q);
+        }
+
+        // update wins and loses
+        if (result.reward == REWARD)
+        {
+            wins++;
+        }
+        else if (result.reward == PUNISHMENT)
+        {
+            loses++;
+        }
+
+        //print stats, or keep them as a binary record when there is a metrics file
+        if (metrics)
+        {
+            metrics_record record = {0, 0, (uint32_t)episode, result.time_step, wins, loses, epsilon,
+                                     result.episode_return};
+            metrics->record(record);
+        }
+        else
+        {
+            cout<<"-------------------------------------------"<<'\n';
+            cout<<"Episode number: "<<episode<<" | ";
+            cout<<"Time step: "<<result.time_step<<" | ";
+            cout<<"Wins: "<<wins<<" | ";
+            cout<<"Loses: "<<loses<<" | ";
+            if (planned)
             {
-                loses++;
-                break;
+                cout<<"EPSILON: "<<epsilon<<" | ";
+                cout<<"Distance to optimal: "<<distance<<" | ";
+                cout<<"Optimal actions: "<<optimal.policyAgreement(env.Q)<<'\n';
             }
             else
             {
-                time_step++;
-                current_state = next_state;
+                cout<<"EPSILON: "<<epsilon<<'\n';
             }
         }
 
-        //print stats 
-        cout<<"-------------------------------------------"<<endl;
-        cout<<"Episode number: "<<episode<<" | ";
-        cout<<"Time step: "<<time_step<<" | ";
-        cout<<"Wins: "<<wins<<" | ";
-        cout<<"Loses: "<<loses<<" | ";
-        cout<<"EPSILON: "<<epsilon<<endl;
+        if (planned && distance < OPTIMAL_TOLERANCE)
+        {
+            cout<<"Within "<<OPTIMAL_TOLERANCE<<" of optimal after "<<episode + 1<<" episodes"<<endl;
+            break;
+        }
+        if (detector && convergence.endEpisode())
+        {
+            cout<<"Converged after "<<episode + 1<<" episodes, no greedy action changed in the last "
+                <<CONVERGENCE_WINDOW<<endl;
+            break;
+        }
 
         
         //reduce exploration over time
@@ -107,5 +334,62 @@ int main()
         {
             epsilon-=0.2;
         }
+
+        // only the copy into the snapshot happens here, the writer thread does the disk
+        if (writer && (episode + 1) % CHECKPOINT_EVERY == 0)
+        {
+            run.episode = episode + 1;
+            run.wins = wins;
+            run.loses = loses;
+            run.epsilon = epsilon;
+            snapshotRun(snapshot, config, env, controller, model, convergence, run);
+            writer->submit(snapshot);
+        }
+    }
+    delete writer;
+
+    if (!metrics_out.close())
+    {
+        cerr<<"could not write all metrics to "<<metrics_file<<endl;
+        return false;
+    }
+    if (!trace_out.close())
+    {
+        cerr<<"could not write the whole trace to "<<trace_file<<endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    // seed the agent and the environment from the command line, or the clock if no seed is given.
+    // the same seed always replays the same run
+    unsigned long long seed = (argc > 1) ? strtoull(argv[1], NULL, 10) : (unsigned long long)time(NULL);
+
+    const char *checkpoint_file = (argc > 3 && string(argv[3]) != "-") ? argv[3] : NULL;
+    const char *metrics_file = (argc > 4 && string(argv[4]) != "-") ? argv[4] : NULL;
+    const char *trace_file = argc > 5 ? argv[5] : NULL;
+
+    bool trained;
+    if (argc > 2 && string(argv[2]) != "-")
+    {
+        mapGridWorld env;
+        if (!env.open(argv[2]))
+        {
+            cerr<<"cannot open map "<<argv[2]<<endl;
+            return 1;
+        }
+        // hashing reads the whole map, only checkpoints need it
+        run_config config = {(uint32_t)env.width(), (uint32_t)env.height(), checkpoint_file ? env.hash() : 0, seed,
+                             PLANNING_STEPS, LAMBDA};
+        trained = train(env, config, checkpoint_file, metrics_file, trace_file);
+    }
+    else
+    {
+        gridWorld<GRID_WIDTH, GRID_HEIGHT> env;
+        run_config config = {GRID_WIDTH, GRID_HEIGHT, 0, seed, PLANNING_STEPS, LAMBDA};
+        trained = train(env, config, checkpoint_file, metrics_file, trace_file);
     }
+    return trained ? 0 : 1;
 }
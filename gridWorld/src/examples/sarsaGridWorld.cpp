@@ -1,36 +1,57 @@
 
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "gridWorld.hpp"
+#include "mapGridWorld.hpp"
 
-#include <rl/RL.hpp>
+#include <rl/eligibility_traces.hpp>
+#include <rl/metrics.hpp>
+#include <rl/trace.hpp>
+#include <rl/rl.hpp>
 #include <rl/sarsa.hpp>
+#include <rl/training.hpp>
 
 #define MAX_EPISODE 100
 
+// SARSA(lambda) with eligibility traces when above 0, 0 is one step SARSA
+#ifndef LAMBDA
+#define LAMBDA 0
+#endif
+
+// grid size, override with -DGRID_WIDTH=.. -DGRID_HEIGHT=..
+#ifndef GRID_WIDTH
+#define GRID_WIDTH 4
+#endif
+#ifndef GRID_HEIGHT
+#define GRID_HEIGHT 3
+#endif
+
 using namespace std;
 
-int main()
+/**
+    Train a SARSA agent in env. The stats of every episode go to metrics, or to stdout if it is NULL, and
+    every transition to trace unless it is NULL
+*/
+template <class Env>
+static void train(Env &env, unsigned long long seed, metrics_sink *metrics, trace_writer *trace)
 {
     // create main variables
-    signed short int time_step, reward;
     unsigned int wins, loses, wins_prev=0;
-    float td_error, td_target, discount_factor, alpha, epsilon;
-    char current_state, goal_state, action, next_state, current_state_idx, next_state_idx, max_action_idx;
-    char next_action;
-    std::vector<bool> available_actions(4, false);
-    std::vector<float> q_row(4);
+    float epsilon;
+    episode_result result;
+    td_parameters params;
 
     // create object instances
     sarsa controller;
-    grid_world env;
-
-    srand(time(NULL));//seed the randomizer
+    controller.seed(seed, 0);
+    env.seed(seed, 1);
+    eligibility_traces traces(LAMBDA > 0 ? env.STATES : 0, ACTIONS);
 
     // rl variables (put in controller?)
-    discount_factor = 0.3;
-    alpha = 0.3;
+    params.discount_factor = 0.3;
+    params.alpha = 0.3;
     epsilon = 0.5;
 
     wins = 0;
@@ -39,78 +60,49 @@ int main()
 
     for (int episode = 0; episode < MAX_EPISODE; episode++)
     {
-
-        time_step = 0;
-        current_state = 00;
-        goal_state = 30;
-
-        //get all legal actions based on state
-        available_actions = env.available_actions(current_state);
-
-        //choose action based on policy
-        current_state_idx = env.get_state_index(current_state);
-        q_row = env.Q[current_state_idx];
-        action = controller.choose_action(epsilon, available_actions, q_row);
-
-
-        while(1)
+        if (trace)
         {
-            //get next state by taking action
-            //next_state = env.take_action(action, current_state);
-            //get next state. incorporates transition probs.
-            next_state = env.next_state(action, current_state, available_actions);
-
-            //get all legal actions based on state
-            available_actions = env.available_actions(next_state);
-
-            //get next action
-            next_state_idx = env.get_state_index(next_state);
-            q_row = env.Q[next_state_idx];
-            next_action = controller.choose_action(epsilon, available_actions, q_row);
-
-
-            //get reward
-            reward = env.get_reward(next_state);
-
-            //TD update
-            next_state_idx = env.get_state_index(next_state);
-            td_target = reward + discount_factor*env.Q[next_state_idx][next_action];
-            td_error = td_target - env.Q[current_state_idx][action];
-            env.Q[current_state_idx][action]+= td_error*alpha;
+            trace->beginEpisode(episode);
+        }
 
-            if (reward == 1000)
-            {
-                wins++;
-                break;
-            }
-            else if (reward == -1000)
-            {
-                loses++;
-                break;
-            }
-            else
-            {
-                time_step++;
-                current_state = next_state;
-                current_state_idx = env.get_state_index(current_state);
-                action = next_action;
-            }
+        // run until the agent has reached goal state or failed
+        if (LAMBDA > 0)
+        {
+            result = sarsaLambdaEpisode(env, env.Q, controller, traces, env.START_STATE, epsilon, params, LAMBDA,
+                                        UINT_MAX, trace);
+        }
+        else
+        {
+            result = sarsaEpisode(env, env.Q, controller, env.START_STATE, epsilon, params, UINT_MAX, NULL, trace);
+        }
 
-            if (episode > 15)
-                   {
-                    int hey = 0;
-                    }
+        if (result.reward == REWARD)
+        {
+            wins++;
+        }
+        else if (result.reward == PUNISHMENT)
+        {
+            loses++;
         }
         if (episode % 1 == 0 && episode > 1)
         {
             //print stats
 /*            cout<<"-------------------------------------------"<<endl;
             cout<<"Episode number: "<<episode<<" | ";
-            cout<<"Time step: "<<time_step<<" | ";
+            cout<<"Time step: "<<result.time_step<<" | ";
             cout<<"Wins: "<<wins<<" | ";
             cout<<"Loses: "<<loses<<" | ";
             cout<<"Epsilon: "<<epsilon<<endl;*/
-            cout<<episode<<","<<time_step<<","<<wins<<","<<loses<<","<<epsilon<<endl;
+            if (metrics)
+            {
+                metrics_record record = {0, 0, (uint32_t)episode, result.time_step, wins, loses, epsilon,
+                                         result.episode_return};
+                metrics->record(record);
+            }
+            else
+            {
+                cout<<episode<<","<<result.time_step<<","<<wins<<","<<loses<<","<<epsilon<<'\n';
+            }
         }
         //reduce exploration over time and when wins continually increase
         if (episode % 10 == 0 && wins > wins_prev*1.75)
@@ -127,3 +119,55 @@ int main()
     }
 }
 
+/**
+    Usage: sarsaGridWorld_example [seed] [map file|-] [metrics file|-] [trace file]
+    With a metrics file the stats of every episode are written there as binary records (rl/metrics.hpp)
+    instead of being printed, see metricsToCsv and metrics.py to read them. With a trace file every
+    transition and its TD error is written there (rl/trace.hpp), see traceColumn to read it
+*/
+int main(int argc, char **argv)
+{
+    // seed the agent and the environment from the command line, or the clock if no seed is given.
+    // the same seed always replays the same run
+    unsigned long long seed = (argc > 1) ? strtoull(argv[1], NULL, 10) : (unsigned long long)time(NULL);
+
+    metrics_sink metrics;
+    if (argc > 3 && string(argv[3]) != "-" && !metrics.open(argv[3]))
+    {
+        cerr<<"cannot create "<<argv[3]<<endl;
+        return 1;
+    }
+    trace_writer trace;
+    if (argc > 4 && !trace.open(argv[4]))
+    {
+        cerr<<"cannot create "<<argv[4]<<endl;
+        return 1;
+    }
+
+    if (argc > 2 && string(argv[2]) != "-")
+    {
+        mapGridWorld env;
+        if (!env.open(argv[2]))
+        {
+            cerr<<"cannot open map "<<argv[2]<<endl;
+            return 1;
+        }
+        train(env, seed, metrics.isOpen() ? &metrics : NULL, trace.isOpen() ? &trace : NULL);
+    }
+    else
+    {
+        gridWorld<GRID_WIDTH, GRID_HEIGHT> env;
+        train(env, seed, metrics.isOpen() ? &metrics : NULL, trace.isOpen() ? &trace : NULL);
+    }
+    if (!metrics.close())
+    {
+        cerr<<"could not write all metrics to "<<argv[3]<<endl;
+        return 1;
+    }
+    if (!trace.close())
+    {
+        cerr<<"could not write the whole trace to "<<argv[4]<<endl;
+        return 1;
+    }
+    return 0;
+}
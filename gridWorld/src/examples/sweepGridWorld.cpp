@@ -0,0 +1,325 @@
+/**
+    This script runs a hyperparameter sweep of q-learning and SARSA in the gridworld environment.
+    Every point of the parameter grid is run for a number of trials, each trial with its own random streams,
+    on a work stealing pool using all cores. Per episode results are streamed to one CSV file that
+    plot_results.py reads. With --metrics they go to a binary metrics file instead (rl/metrics.hpp), one
+    record per episode with the grid point as group and the trial as run, and the CSV file only lists the
+    grid points: formatting every episode as text dominates long sweeps.
+
+    Usage: sweepGridWorld_example [options]
+        --algorithm q,sarsa       algorithms to run
+        --alpha 0.1,0.3,0.5       learning rates
+        --discount 0.3,0.5        discount factors
+        --epsilon 0.5             starting exploration rates
+        --decay 0.2,0.05          amount epsilon is reduced by every 10 episodes
+        --decay-rule step,wins    step: always reduce. wins: only reduce when wins grew by 75% since the last
+                                  reduction. Both are the sweep's own, see DECAY_PERIOD
+        --trials 10               runs per grid point
+        --episodes 100            episodes per run
+        --max-steps 100000        steps before an episode is cut off
+        --converge-window 0       stop a run once its greedy policy has not changed for this many episodes,
+                                  0 always runs every episode
+        --converge-tolerance 1000 and no value in those episodes moved by more than this
+        --seed 1                  base seed, trial k of grid point p uses streams of this seed
+        --threads 4               worker threads, all cores by default
+        --out sweep.csv           output file
+        --metrics sweep.bin       binary file for the per episode results
+        --sample 1                with --metrics, keep every n-th episode only
+
+    @author Alex Cornelio
+*/
+
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <time.h>
+
+#include "gridWorld.hpp"
+
+#include <rl/metrics.hpp>
+#include <rl/q_learning.hpp>
+#include <rl/sarsa.hpp>
+#include <rl/thread_pool.hpp>
+#include <rl/training.hpp>
+
+// grid size, override with -DGRID_WIDTH=.. -DGRID_HEIGHT=..
+#ifndef GRID_WIDTH
+#define GRID_WIDTH 4
+#endif
+#ifndef GRID_HEIGHT
+#define GRID_HEIGHT 3
+#endif
+
+// epsilon schedules of the sweep. They are modelled on the drivers but are not theirs: epsilon never goes
+// below 0 (qLearningGridWorld lets it), the wins rule compares with the wins at the last reduction
+// (sarsaGridWorld always with 0) and its step is --decay (sarsaGridWorld 0.05), and neither
+// reduces at episode 0. A sweep point does not replay either driver
+#define DECAY_PERIOD 10
+#define WINS_GROWTH 1.75
+
+using namespace std;
+
+typedef gridWorld<GRID_WIDTH, GRID_HEIGHT> grid_world;
+
+/**
+    One point of the parameter grid
+*/
+struct sweep_point
+{
+    string algorithm;
+    float alpha;
+    float discount_factor;
+    float epsilon;
+    float decay;
+    string decay_rule;
+};
+
+/**
+    Split a comma separated list
+*/
+static vector<string> splitList(const string &list)
+{
+    vector<string> items;
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, ','))
+    {
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+static vector<float> floatList(const string &list)
+{
+    vector<string> items = splitList(list);
+    vector<float> values;
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        values.push_back(strtof(items[i].c_str(), NULL));
+    }
+    return values;
+}
+
+/**
+    Run one trial and return its CSV rows, or add its episodes to records if it is not NULL
+*/
+template <class Policy>
+static string runTrial(const sweep_point &point, unsigned int point_id, unsigned int trial, unsigned long long seed,
+                       unsigned int max_episode, unsigned int max_steps, unsigned int converge_window,
+                       float converge_tolerance, vector<metrics_record> *records)
+{
+    Policy controller;
+    grid_world env;
+    uint64_t stream = 2 * ((uint64_t)point_id << 32 | trial);
+    controller.seed(seed, stream);
+    env.seed(seed, stream + 1);
+
+    td_parameters params = {point.alpha, point.discount_factor};
+    float epsilon = point.epsilon;
+    unsigned int wins = 0, loses = 0, wins_prev = 0;
+    ostringstream rows;
+    convergence_detector convergence(converge_window, converge_tolerance);
+    convergence_detector *detector = converge_window > 0 ? &convergence : NULL;
+
+    for (unsigned int episode = 0; episode < max_episode; episode++)
+    {
+        episode_result result;
+        if (point.algorithm == "sarsa")
+        {
+            result = sarsaEpisode(env, env.Q, controller, env.START_STATE, epsilon, params, max_steps, detector);
+        }
+        else
+        {
+            result = qLearningEpisode(env, env.Q, controller, env.START_STATE, epsilon, params, max_steps, detector);
+        }
+        if (result.reward == REWARD)
+        {
+            wins++;
+        }
+        else if (result.reward == PUNISHMENT)
+        {
+            loses++;
+        }
+
+        if (records)
+        {
+            metrics_record record = {point_id, trial, episode, result.time_step, wins, loses, epsilon,
+                                     result.episode_return};
+            records->push_back(record);
+        }
+        else
+        {
+            rows<<point_id<<","<<trial<<","<<point.algorithm<<","<<point.alpha<<","<<point.discount_factor<<","
+                <<point.epsilon<<","<<point.decay<<","<<point.decay_rule<<","<<seed<<","
+                <<episode<<","<<result.time_step<<","<<wins<<","<<loses<<","<<epsilon<<"\n";
+        }
+        if (detector && convergence.endEpisode())
+        {
+            break;
+        }
+
+        //reduce exploration over time by --decay-rule, see DECAY_PERIOD
+        if (episode % DECAY_PERIOD == 0 && episode > 1)
+        {
+            bool reduce = point.decay_rule != "wins" || wins > wins_prev * WINS_GROWTH;
+            if (reduce)
+            {
+                epsilon = (epsilon > point.decay) ? epsilon - point.decay : 0;
+                wins_prev = wins;
+            }
+        }
+    }
+    return rows.str();
+}
+
+int main(int argc, char **argv)
+{
+    vector<string> algorithms = splitList("q,sarsa");
+    vector<float> alphas = floatList("0.1,0.3,0.5");
+    vector<float> discount_factors = floatList("0.3,0.5");
+    vector<float> epsilons = floatList("0.5");
+    vector<float> decays = floatList("0.2,0.05");
+    vector<string> decay_rules = splitList("step");
+    unsigned int trials = 10;
+    unsigned int max_episode = 100;
+    unsigned int max_steps = 100000;
+    unsigned int converge_window = 0;
+    float converge_tolerance = 1000;
+    unsigned long long seed = (unsigned long long)time(NULL);
+    unsigned int threads = 0;
+    string out = "sweep.csv";
+    string metrics_file;
+    unsigned int sample = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        string option = argv[i];
+        string value = argv[i + 1];
+        if (option == "--algorithm") algorithms = splitList(value);
+        else if (option == "--alpha") alphas = floatList(value);
+        else if (option == "--discount") discount_factors = floatList(value);
+        else if (option == "--epsilon") epsilons = floatList(value);
+        else if (option == "--decay") decays = floatList(value);
+        else if (option == "--decay-rule") decay_rules = splitList(value);
+        else if (option == "--trials") trials = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--episodes") max_episode = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--max-steps") max_steps = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--converge-window") converge_window = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--converge-tolerance") converge_tolerance = strtof(value.c_str(), NULL);
+        else if (option == "--seed") seed = strtoull(value.c_str(), NULL, 10);
+        else if (option == "--threads") threads = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--out") out = value;
+        else if (option == "--metrics") metrics_file = value;
+        else if (option == "--sample") sample = strtoul(value.c_str(), NULL, 10);
+        else
+        {
+            cerr<<"unknown option "<<option<<endl;
+            return 1;
+        }
+    }
+
+    for (size_t a = 0; a < algorithms.size(); a++)
+    {
+        if (algorithms[a] != "q" && algorithms[a] != "sarsa")
+        {
+            cerr<<"unknown algorithm "<<algorithms[a]<<endl;
+            return 1;
+        }
+    }
+    for (size_t r = 0; r < decay_rules.size(); r++)
+    {
+        if (decay_rules[r] != "step" && decay_rules[r] != "wins")
+        {
+            cerr<<"unknown decay rule "<<decay_rules[r]<<endl;
+            return 1;
+        }
+    }
+
+    // every combination of the lists
+    vector<sweep_point> points;
+    for (size_t a = 0; a < algorithms.size(); a++)
+        for (size_t l = 0; l < alphas.size(); l++)
+            for (size_t d = 0; d < discount_factors.size(); d++)
+                for (size_t e = 0; e < epsilons.size(); e++)
+                    for (size_t k = 0; k < decays.size(); k++)
+                        for (size_t r = 0; r < decay_rules.size(); r++)
+                        {
+                            sweep_point point = {algorithms[a], alphas[l], discount_factors[d], epsilons[e],
+                                                 decays[k], decay_rules[r]};
+                            points.push_back(point);
+                        }
+
+    ofstream file(out.c_str());
+    if (!file)
+    {
+        cerr<<"cannot open "<<out<<endl;
+        return 1;
+    }
+    metrics_sink metrics(4096, sample);
+    if (!metrics_file.empty())
+    {
+        if (!metrics.open(metrics_file))
+        {
+            cerr<<"cannot open "<<metrics_file<<endl;
+            return 1;
+        }
+        // the episodes only carry the point, its parameters are listed here
+        file<<"point,algorithm,alpha,discount_factor,epsilon0,decay,decay_rule,seed\n";
+        for (unsigned int p = 0; p < points.size(); p++)
+        {
+            file<<p<<","<<points[p].algorithm<<","<<points[p].alpha<<","<<points[p].discount_factor<<","
+                <<points[p].epsilon<<","<<points[p].decay<<","<<points[p].decay_rule<<","<<seed<<"\n";
+        }
+    }
+    else
+    {
+        file<<"point,trial,algorithm,alpha,discount_factor,epsilon0,decay,decay_rule,seed,"
+            <<"episode,time_step,wins,loses,epsilon\n";
+    }
+    mutex file_lock;
+
+    thread_pool pool(threads > 0 ? threads : thread::hardware_concurrency());
+    for (unsigned int p = 0; p < points.size(); p++)
+    {
+        for (unsigned int t = 0; t < trials; t++)
+        {
+            pool.submit([&, p, t] {
+                vector<metrics_record> records;
+                vector<metrics_record> *episodes = metrics.isOpen() ? &records : NULL;
+                string rows = (points[p].algorithm == "sarsa")
+                    ? runTrial<sarsa>(points[p], p, t, seed, max_episode, max_steps, converge_window, converge_tolerance,
+                                      episodes)
+                    : runTrial<q_learning>(points[p], p, t, seed, max_episode, max_steps, converge_window,
+                                           converge_tolerance, episodes);
+                // a whole trial at a time, so rows of different trials never interleave
+                lock_guard<mutex> guard(file_lock);
+                if (episodes)
+                {
+                    metrics.append(records.data(), records.size());
+                }
+                else
+                {
+                    file<<rows;
+                    file.flush();
+                }
+            });
+        }
+    }
+    pool.wait();
+
+    if (!metrics.close())
+    {
+        cerr<<"could not write all metrics to "<<metrics_file<<endl;
+        return 1;
+    }
+    cerr<<points.size()<<" grid points x "<<trials<<" trials on "<<pool.size()<<" threads written to "
+        <<(metrics_file.empty() ? out : metrics_file)<<endl;
+    return 0;
+}
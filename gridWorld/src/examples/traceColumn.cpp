@@ -0,0 +1,110 @@
+/**
+    This script reads a trace written by the examples, the Gazebo plugins or the robot (rl/trace.hpp).
+    Without a column it lists the columns with their sizes in the file. With one it reads that column only
+    and prints its count, min, max, mean and mean absolute value, or with --dump every value, one per line.
+
+    Usage: traceColumn trace.bin [column] [--dump]
+        e.g. traceColumn trace.bin td_error
+
+    @author Alex Cornelio
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <rl/trace.hpp>
+
+using namespace std;
+
+/**
+    Print the summary of values, or every value with dump
+*/
+template <class T>
+static void summarise(const char *name, const vector<T> &values, bool dump)
+{
+    if (dump)
+    {
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            printf("%g\n", (double)values[i]);
+        }
+        return;
+    }
+    double low = 0, high = 0, sum = 0, absolute = 0;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        double v = values[i];
+        low = (i == 0 || v < low) ? v : low;
+        high = (i == 0 || v > high) ? v : high;
+        sum += v;
+        absolute += v < 0 ? -v : v;
+    }
+    double n = values.empty() ? 1 : values.size();
+    printf("%-12s %12s %12s %12s %12s %12s\n", "column", "count", "min", "max", "mean", "mean |x|");
+    printf("%-12s %12zu %12g %12g %12g %12g\n", name, values.size(), low, high, sum / n, absolute / n);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        cerr<<"usage: traceColumn trace.bin [column] [--dump]"<<endl;
+        return 1;
+    }
+    trace_reader trace;
+    if (!trace.open(argv[1]))
+    {
+        cerr<<"cannot read a trace from "<<argv[1]<<endl;
+        return 1;
+    }
+
+    if (argc < 3)
+    {
+        printf("%llu rows in %u chunks\n", (unsigned long long)trace.rows(), trace.chunks());
+        printf("%-12s %6s %12s\n", "column", "type", "bytes/value");
+        const char *types[] = {"?", "uint8", "uint32", "float"};
+        for (unsigned int k = 0; k < trace.columns(); k++)
+        {
+            const trace_column_info &info = trace.column(k);
+            printf("%-12s %6s %12u\n", info.name, types[info.type <= TRACE_FLOAT32 ? info.type : 0], info.width);
+        }
+        return 0;
+    }
+
+    int k = trace.findColumn(argv[2]);
+    if (k < 0)
+    {
+        cerr<<"no column "<<argv[2]<<" in "<<argv[1]<<endl;
+        return 1;
+    }
+    bool dump = argc > 3 && string(argv[3]) == "--dump";
+    bool ok;
+    uint32_t type = trace.column(k).type;
+    if (type == TRACE_FLOAT32)
+    {
+        vector<float> values;
+        ok = trace.readColumn(k, values);
+        summarise(argv[2], values, dump);
+    }
+    else if (type == TRACE_UINT32)
+    {
+        vector<uint32_t> values;
+        ok = trace.readColumn(k, values);
+        summarise(argv[2], values, dump);
+    }
+    else
+    {
+        vector<uint8_t> values;
+        ok = trace.readColumn(k, values);
+        summarise(argv[2], values, dump);
+    }
+    if (!ok)
+    {
+        cerr<<"column "<<argv[2]<<" of "<<argv[1]<<" is damaged"<<endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+/**
+	Action selection helpers shared by every RL algorithm.
+	Legal actions are passed around as a bitmask and a Q row as a pointer and a length, so choosing an action
+	never copies a row or touches the heap.
+	@author Alex Cornelio
+*/
+
+#ifndef ACTION_SELECTION_H
+#define ACTION_SELECTION_H
+
+#include <cmath>
+#include <stdint.h>
+
+#include "random.hpp"
+
+// bit a is set when action a is legal. Enough bits for any action set used so far
+typedef unsigned int action_mask_t;
+
+#define MAX_ACTIONS (sizeof(action_mask_t) * 8)
+
+/**
+	Read only view of one row of a Q table
+*/
+struct q_row_view
+{
+    const float *values;
+    unsigned int size;
+
+    q_row_view(const float *values_, unsigned int size_) : values(values_), size(size_) {}
+    float operator[](unsigned int a) const { return values[a]; }
+};
+
+/**
+	Return a mask with the first n actions set
+*/
+inline action_mask_t allActions(unsigned int n)
+{
+    return n >= MAX_ACTIONS ? ~action_mask_t(0) : ((action_mask_t(1) << n) - 1);
+}
+
+/**
+	Return the number of legal actions in the mask
+*/
+inline int countActions(action_mask_t mask)
+{
+    return __builtin_popcount(mask);
+}
+
+/**
+	Return the index of the n-th legal action (counting from zero) in the mask
+*/
+inline char nthAction(action_mask_t mask, int n)
+{
+    for (; n > 0; n--)
+    {
+        mask &= mask - 1; //drop lowest set bit
+    }
+    return (char)__builtin_ctz(mask);
+}
+
+/**
+	Pick one of the legal actions uniformly. The mask must not be empty
+*/
+inline char randomAction(action_mask_t mask, random_engine &rng)
+{
+    int n = countActions(mask);
+    if (n == 1)
+    {
+        return (char)__builtin_ctz(mask);
+    }
+    return nthAction(mask, rng.below(n));
+}
+
+/**
+	Return the legal action with the largest Q value. If several legal actions share the largest value one of
+	them is picked at random. The mask must not be empty
+*/
+inline char maskedArgmax(action_mask_t legal, q_row_view row, random_engine &rng)
+{
+    action_mask_t best = 0;
+    float max_q = 0;
+
+    for (unsigned int a = 0; a < row.size; a++)
+    {
+        if (!((legal >> a) & 1))
+        {
+            continue;
+        }
+        if (best == 0 || row[a] > max_q)
+        {
+            max_q = row[a];
+            best = action_mask_t(1) << a;
+        }
+        else if (row[a] == max_q)
+        {
+            best |= action_mask_t(1) << a;
+        }
+    }
+    return randomAction(best, rng);
+}
+
+/**
+	Return the first legal action with the largest Q value. Unlike maskedArgmax ties always give the same
+	action, for comparing the greedy action of a row over time. The mask must not be empty
+*/
+inline char greedyAction(action_mask_t legal, q_row_view row)
+{
+    char best = (char)__builtin_ctz(legal);
+    for (unsigned int a = best + 1; a < row.size; a++)
+    {
+        if (((legal >> a) & 1) && row[a] > row[(int)best])
+        {
+            best = (char)a;
+        }
+    }
+    return best;
+}
+
+/**
+	Pick a legal action by upper confidence bound (UCB1): the largest Q value plus c * sqrt(ln n / n_a), where
+	n_a is the count of action a in visits and n the sum over the legal actions. Legal actions never tried
+	come first, one of them at random, and ties of the bound are broken at random. c is in units of Q, so it
+	scales with the rewards. The mask must not be empty
+*/
+inline char ucbAction(action_mask_t legal, q_row_view row, const uint32_t *visits, float c, random_engine &rng)
+{
+    action_mask_t untried = 0;
+    unsigned int total = 0;
+    for (unsigned int a = 0; a < row.size; a++)
+    {
+        if ((legal >> a) & 1)
+        {
+            total += visits[a];
+            untried |= visits[a] == 0 ? action_mask_t(1) << a : 0;
+        }
+    }
+    if (untried)
+    {
+        return randomAction(untried, rng);
+    }
+
+    float log_total = std::log((float)total);
+    action_mask_t best = 0;
+    float max_bound = 0;
+    for (unsigned int a = 0; a < row.size; a++)
+    {
+        if (!((legal >> a) & 1))
+        {
+            continue;
+        }
+        float bound = row[a] + c * std::sqrt(log_total / visits[a]);
+        if (best == 0 || bound > max_bound)
+        {
+            max_bound = bound;
+            best = action_mask_t(1) << a;
+        }
+        else if (bound == max_bound)
+        {
+            best |= action_mask_t(1) << a;
+        }
+    }
+    return randomAction(best, rng);
+}
+
+#endif // ACTION_SELECTION_H
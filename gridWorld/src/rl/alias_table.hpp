@@ -0,0 +1,108 @@
+/**
+	Alias method table (Walker / Vose) for sampling a small discrete distribution in O(1).
+	Building the table costs O(K) once, each sample afterwards costs one random draw and one table lookup.
+	@author Alex Cornelio
+*/
+
+#ifndef ALIAS_TABLE_H
+#define ALIAS_TABLE_H
+
+#include <cstddef>
+#include <stdint.h>
+
+#include "random.hpp"
+
+/**
+	Distribution over at most K outcomes
+*/
+template <std::size_t K>
+class alias_table
+{
+public:
+    alias_table() : size_(1)
+    {
+        for (std::size_t i = 0; i < K; i++)
+        {
+            keep_[i] = 1.0f;
+            alias_[i] = 0;
+        }
+    }
+
+    /**
+    	Build the table from n non-negative weights. They do not need to sum to one
+    */
+    void build(const float *weights, int n)
+    {
+        float scaled[K];
+        unsigned char small[K], large[K];
+        int n_small = 0, n_large = 0;
+        float total = 0;
+
+        size_ = (unsigned char)n;
+        for (int i = 0; i < n; i++)
+        {
+            total += weights[i];
+        }
+        for (int i = 0; i < n; i++)
+        {
+            scaled[i] = weights[i] * n / total;
+            alias_[i] = (unsigned char)i;
+            if (scaled[i] < 1.0f)
+            {
+                small[n_small++] = (unsigned char)i;
+            }
+            else
+            {
+                large[n_large++] = (unsigned char)i;
+            }
+        }
+
+        // pair every under full column with an over full one
+        while (n_small > 0 && n_large > 0)
+        {
+            unsigned char s = small[--n_small];
+            unsigned char l = large[--n_large];
+            keep_[s] = scaled[s];
+            alias_[s] = l;
+            scaled[l] = (scaled[l] + scaled[s]) - 1.0f;
+            if (scaled[l] < 1.0f)
+            {
+                small[n_small++] = l;
+            }
+            else
+            {
+                large[n_large++] = l;
+            }
+        }
+        // whatever is left is full up to rounding error
+        while (n_large > 0)
+        {
+            keep_[large[--n_large]] = 1.0f;
+        }
+        while (n_small > 0)
+        {
+            keep_[small[--n_small]] = 1.0f;
+        }
+    }
+
+    /**
+    	Return an outcome. The high half of one 64 bit draw picks the column, the low half decides between the
+    	column and its alias
+    */
+    int sample(random_engine &rng) const
+    {
+        uint64_t r = rng.next();
+        unsigned int column = (unsigned int)(((r >> 32) * size_) >> 32);
+        float u = (uint32_t)r * (1.0f / 4294967296.0f);
+        return u < keep_[column] ? (int)column : (int)alias_[column];
+    }
+
+    int size() const { return size_; }
+
+private:
+    float keep_[K];
+    unsigned char alias_[K];
+    unsigned char size_;
+};
+
+#endif // ALIAS_TABLE_H
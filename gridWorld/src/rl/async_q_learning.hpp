@@ -0,0 +1,269 @@
+/**
+	Asynchronous one-step Q-learning actors (Mnih et al., asynchronous methods for deep RL).
+	Every actor is a thread with its own environment, random streams and exploration rate, which it draws
+	once from an epsilon_distribution, so actors with different rates explore the same problem side by side.
+	As in the paper an actor can anneal from a common initial rate to its own over its first episodes.
+	An actor learns on a local copy of the shared table. It keeps the sum of its TD updates since it last
+	pushed and every push_interval steps it adds that sum to the shared table with relaxed atomic updates
+	(relaxed_float.hpp) and copies the shared table back into its local copy. Between pushes its targets come
+	from its local copy, which holds the shared values of the last push plus its own updates, so the shared
+	table acts as the target table and the actors never wait on each other.
+	@author Alex Cornelio
+*/
+
+#ifndef ASYNC_Q_LEARNING_H
+#define ASYNC_Q_LEARNING_H
+
+#include <atomic>
+#include <limits.h>
+#include <thread>
+#include <vector>
+
+#include "q_learning.hpp"
+#include "q_table.hpp"
+#include "random.hpp"
+#include "relaxed_float.hpp"
+#include "training.hpp"
+
+/**
+	Discrete distribution the actors draw their exploration rates from
+*/
+struct epsilon_distribution
+{
+    std::vector<float> values;
+    std::vector<float> weights;
+
+    /**
+    	Return one of values, picked with probability proportional to its weight
+    */
+    float sample(random_engine &rng) const
+    {
+        float total = 0;
+        for (size_t i = 0; i < weights.size(); i++)
+        {
+            total += weights[i];
+        }
+        float pick = rng.uniform() * total;
+        for (size_t i = 0; i + 1 < values.size(); i++)
+        {
+            pick -= weights[i];
+            if (pick < 0)
+            {
+                return values[i];
+            }
+        }
+        return values.back();
+    }
+};
+
+/**
+	Settings of the actors
+*/
+struct async_parameters
+{
+    td_parameters td;
+    unsigned int push_interval;     // steps between pushes to the shared table
+    unsigned int max_steps;         // steps before an episode is cut off
+    // every actor starts at initial_epsilon and moves linearly to its drawn rate over its first
+    // anneal_episodes episodes. 0 uses the drawn rate from the start
+    float initial_epsilon;
+    unsigned int anneal_episodes;
+};
+
+/**
+	What one actor did
+*/
+struct actor_result
+{
+    float epsilon;
+    unsigned long episodes;
+    unsigned long pushes;
+};
+
+/**
+	Local copy of a shared States x Actions table and the updates not pushed yet
+*/
+template <std::size_t States, std::size_t Actions>
+class q_actor
+{
+public:
+    static_assert(States != Q_TABLE_DYNAMIC_STATES, "the local copy needs a table of fixed size");
+    typedef QTable<States, Actions, relaxed_float> shared_table;
+    typedef QTable<States, Actions, float> local_table;
+
+    explicit q_actor(shared_table &shared);
+
+    local_table &table() { return local_; }
+    void update(state_t s, char action, float delta);
+    void push();
+
+private:
+    shared_table &shared_;
+    local_table local_;
+    // sum of the updates of every value since the last push and the values that have one
+    std::vector<float> pending_;
+    std::vector<unsigned int> touched_;
+
+    void pull();
+};
+
+/**
+	Constructor. The local copy starts as a copy of the shared table
+*/
+template <std::size_t States, std::size_t Actions>
+q_actor<States, Actions>::q_actor(shared_table &shared)
+    :shared_(shared),
+     local_(0),
+     pending_(local_table::SIZE, 0.0f)
+{
+    pull();
+}
+
+/**
+	Add delta to Q(s, action) of the local copy and to the updates of the next push
+*/
+template <std::size_t States, std::size_t Actions>
+inline void q_actor<States, Actions>::update(state_t s, char action, float delta)
+{
+    unsigned int i = s * local_table::STRIDE + action;
+    if (pending_[i] == 0)
+    {
+        touched_.push_back(i);
+    }
+    pending_[i] += delta;
+    local_[s][(int)action] += delta;
+}
+
+/**
+	Add the pending updates to the shared table and start again from its current values
+*/
+template <std::size_t States, std::size_t Actions>
+void q_actor<States, Actions>::push()
+{
+    relaxed_float *shared = shared_.data();
+    for (size_t k = 0; k < touched_.size(); k++)
+    {
+        unsigned int i = touched_[k];
+        shared[i] += pending_[i];
+        pending_[i] = 0;
+    }
+    touched_.clear();
+    pull();
+}
+
+/**
+	Copy the shared table into the local copy
+*/
+template <std::size_t States, std::size_t Actions>
+void q_actor<States, Actions>::pull()
+{
+    const relaxed_float *shared = shared_.data();
+    float *local = local_.data();
+    for (size_t i = 0; i < local_table::SIZE; i++)
+    {
+        local[i] = shared[i];
+    }
+}
+
+/**
+	Run one Q-learning episode of an actor from start, pushing every push_interval steps. since_push carries
+	the steps since the last push from one episode to the next
+*/
+template <class Env, std::size_t States, std::size_t Actions, class Policy>
+episode_result asyncQLearningEpisode(Env &env, q_actor<States, Actions> &actor, Policy &policy, state_t start, float epsilon,
+                                     const async_parameters &params, unsigned int &since_push, unsigned long &pushes)
+{
+    episode_result result = {0, 0, 0, 0.0f};
+    typename q_actor<States, Actions>::local_table &Q = actor.table();
+    state_t current_state = start;
+
+    while (result.steps < params.max_steps)
+    {
+        //choose action based on policy among the legal actions
+        char action = policy.chooseAction(epsilon, env.mask(current_state), q_row_view(Q[current_state], Q.actions()));
+
+        //take action to get next state and reward
+        step_result step = env.step(current_state, action);
+
+        //TD update of the local copy, kept for the next push
+        float td_target = step.reward + params.td.discount_factor * Q.max(step.next_state);
+        actor.update(current_state, action, (td_target - Q[current_state][(int)action]) * params.td.alpha);
+        if (++since_push >= params.push_interval)
+        {
+            actor.push();
+            pushes++;
+            since_push = 0;
+        }
+
+        result.steps++;
+        result.reward = step.reward;
+        result.episode_return += step.reward;
+        if (step.done)
+        {
+            break;
+        }
+        result.time_step++;
+        current_state = step.next_state;
+    }
+    return result;
+}
+
+/**
+	Run one actor thread per environment of envs against the shared table until done says to stop.
+	Actor k seeds its policy and its exploration rate draw from streams 2k and 2k + 1 of seed, the
+	environments come seeded. start(env) gives the first state of every episode. After every episode the
+	actor calls done(episodes), episodes being the number of episodes finished by all actors together, and
+	stops once any call returns true. Returns what every actor did
+*/
+template <class Env, std::size_t States, std::size_t Actions, class Start, class Done>
+std::vector<actor_result> runAsyncActors(std::vector<Env *> &envs, QTable<States, Actions, relaxed_float> &shared,
+                                         unsigned long long seed, const async_parameters &params, const epsilon_distribution &epsilons,
+                                         Start start, Done done)
+{
+    std::vector<actor_result> results(envs.size());
+    std::atomic<unsigned long> episodes(0);
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> actors;
+
+    for (unsigned int k = 0; k < envs.size(); k++)
+    {
+        actors.push_back(std::thread([&, k] {
+            Env &env = *envs[k];
+            q_learning policy;
+            policy.seed(seed, 2 * k);
+            random_engine rng(seed, 2 * k + 1);
+            q_actor<States, Actions> actor(shared);
+            actor_result &result = results[k];
+            result.epsilon = epsilons.sample(rng);
+            result.episodes = 0;
+            result.pushes = 0;
+            unsigned int since_push = 0;
+
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                float epsilon = result.epsilon;
+                if (result.episodes < params.anneal_episodes)
+                {
+                    float rest = 1.0f - (float)result.episodes / params.anneal_episodes;
+                    epsilon += (params.initial_epsilon - result.epsilon) * rest;
+                }
+                asyncQLearningEpisode(env, actor, policy, start(env), epsilon, params, since_push, result.pushes);
+                result.episodes++;
+                if (done(episodes.fetch_add(1, std::memory_order_relaxed) + 1))
+                {
+                    stop = true;
+                }
+            }
+            // hand over what is left
+            actor.push();
+            result.pushes++;
+        }));
+    }
+    for (size_t k = 0; k < actors.size(); k++)
+    {
+        actors[k].join();
+    }
+    return results;
+}
+
+#endif // ASYNC_Q_LEARNING_H
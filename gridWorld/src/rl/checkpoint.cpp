@@ -0,0 +1,308 @@
+/**
+	Checkpoint class methods: the section list, the file format and the background writer. Tables are
+	copied in and out by the templates in the header
+	@author Alex Cornelio
+*/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "checkpoint.hpp"
+
+checkpoint::checkpoint()
+{
+}
+
+checkpoint::~checkpoint()
+{
+
+}
+
+/**
+	Drop every section. The buffer keeps its memory for the next snapshot
+*/
+void checkpoint::clear()
+{
+    buffer_.clear();
+}
+
+/**
+	Append a section of bytes and return where its data goes
+*/
+unsigned char *checkpoint::reserve(uint32_t tag, std::size_t bytes)
+{
+    std::size_t start = buffer_.size();
+    std::size_t padded = (bytes + 7) & ~(std::size_t)7;
+    buffer_.resize(start + sizeof(section) + padded, 0);
+    section header = {tag, 0, bytes};
+    memcpy(&buffer_[start], &header, sizeof(section));
+    return &buffer_[start + sizeof(section)];
+}
+
+/**
+	Append a section holding a copy of data
+*/
+void checkpoint::add(uint32_t tag, const void *data, std::size_t bytes)
+{
+    unsigned char *out = reserve(tag, bytes);
+    if (bytes > 0)
+    {
+        memcpy(out, data, bytes);
+    }
+}
+
+/**
+	Append the 256 bit state of an engine
+*/
+void checkpoint::addEngine(uint32_t tag, const random_engine &rng)
+{
+    uint64_t state[4];
+    rng.getState(state);
+    add(tag, state, sizeof(state));
+}
+
+/**
+	Return the data of the first section with tag and its size, NULL if there is none
+*/
+const unsigned char *checkpoint::find(uint32_t tag, std::size_t *bytes) const
+{
+    std::size_t at = 0;
+    while (at + sizeof(section) <= buffer_.size())
+    {
+        section header;
+        memcpy(&header, &buffer_[at], sizeof(section));
+        std::size_t padded = (header.bytes + 7) & ~(uint64_t)7;
+        if (padded > buffer_.size() - at - sizeof(section))
+        {
+            return NULL;
+        }
+        if (header.tag == tag)
+        {
+            *bytes = header.bytes;
+            return &buffer_[at + sizeof(section)];
+        }
+        at += sizeof(section) + padded;
+    }
+    return NULL;
+}
+
+/**
+	Copy the section with tag into data, which must be exactly its size
+*/
+bool checkpoint::get(uint32_t tag, void *data, std::size_t bytes) const
+{
+    std::size_t found;
+    const unsigned char *in = find(tag, &found);
+    if (!in || found != bytes)
+    {
+        return false;
+    }
+    if (bytes > 0)
+    {
+        memcpy(data, in, bytes);
+    }
+    return true;
+}
+
+/**
+	Restore an engine added with addEngine
+*/
+bool checkpoint::getEngine(uint32_t tag, random_engine &rng) const
+{
+    uint64_t state[4];
+    if (!get(tag, state, sizeof(state)))
+    {
+        return false;
+    }
+    rng.setState(state);
+    return true;
+}
+
+/**
+	FNV-1a over the sections
+*/
+uint64_t checkpoint::checksum(const unsigned char *data, std::size_t bytes)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (std::size_t i = 0; i < bytes; i++)
+    {
+        hash = (hash ^ data[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+	Write the checkpoint to path.tmp, sync it and rename it over path. Returns false, and leaves whatever was
+	at path, if any step fails
+*/
+bool checkpoint::write(const std::string &path) const
+{
+    checkpoint_header header;
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.bytes = buffer_.size();
+    header.checksum = checksum(buffer_.data(), buffer_.size());
+
+    std::string temporary = path + ".tmp";
+    FILE *file = fopen(temporary.c_str(), "wb");
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (buffer_.empty() || fwrite(buffer_.data(), buffer_.size(), 1, file) == 1) &&
+              fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        unlink(temporary.c_str());
+        return false;
+    }
+
+    // make the rename itself durable
+    std::size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = open(directory.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+    return true;
+}
+
+/**
+	Replace the sections with those of the file at path. Returns false, and keeps the sections, if the file
+	cannot be read, is not a checkpoint or does not match its checksum
+*/
+bool checkpoint::read(const std::string &path)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+    // the sections must fill the rest of the file exactly, so a damaged size is caught before it is used
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    checkpoint_header header;
+    std::vector<unsigned char> sections;
+    bool ok = size >= (long)sizeof(header) && fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) == 0 &&
+              header.bytes == (uint64_t)size - sizeof(header);
+    if (ok)
+    {
+        sections.resize(header.bytes);
+        ok = header.bytes == 0 || fread(sections.data(), header.bytes, 1, file) == 1;
+    }
+    fclose(file);
+    if (!ok || checksum(sections.data(), sections.size()) != header.checksum)
+    {
+        return false;
+    }
+    buffer_.swap(sections);
+    return true;
+}
+
+/**
+	Constructor. Starts the writer thread
+*/
+checkpoint_writer::checkpoint_writer(const std::string &path)
+    :path_(path),
+     has_pending_(false),
+     busy_(false),
+     stop_(false),
+     written_(0),
+     failed_(0)
+{
+    thread_ = std::thread(&checkpoint_writer::run, this);
+}
+
+/**
+	Destructor. Writes the last snapshot submitted, then stops the thread
+*/
+checkpoint_writer::~checkpoint_writer()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+/**
+	Hand a snapshot to the writer. snapshot gets an older buffer back, which the caller clears and refills
+*/
+void checkpoint_writer::submit(checkpoint &snapshot)
+{
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        pending_.swap(snapshot);
+        has_pending_ = true;
+    }
+    wake_.notify_one();
+}
+
+/**
+	Wait until every snapshot submitted so far is on disk
+*/
+void checkpoint_writer::flush()
+{
+    std::unique_lock<std::mutex> guard(lock_);
+    done_.wait(guard, [this] { return !has_pending_ && !busy_; });
+}
+
+/**
+	Number of checkpoints written so far
+*/
+unsigned int checkpoint_writer::written()
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    return written_;
+}
+
+/**
+	Number of checkpoints that could not be written
+*/
+unsigned int checkpoint_writer::failed()
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    return failed_;
+}
+
+/**
+	Writer thread: write the newest pending snapshot whenever there is one, until stopped with nothing left
+*/
+void checkpoint_writer::run()
+{
+    std::unique_lock<std::mutex> guard(lock_);
+    while (true)
+    {
+        wake_.wait(guard, [this] { return has_pending_ || stop_; });
+        if (!has_pending_)
+        {
+            break;
+        }
+        writing_.swap(pending_);
+        has_pending_ = false;
+        busy_ = true;
+
+        guard.unlock();
+        bool ok = writing_.write(path_);
+        guard.lock();
+
+        busy_ = false;
+        if (ok)
+        {
+            written_++;
+        }
+        else
+        {
+            failed_++;
+        }
+        done_.notify_all();
+    }
+}
@@ -0,0 +1,243 @@
+/**
+	Checkpoint class declarations.
+	A checkpoint is a snapshot of a training run that it can be resumed from exactly: the Q table (and its
+	visit counts), the episode counters and exploration schedule, the state of every random engine and
+	whatever else a learner adds, such as the Dyna-Q model. It is built in memory as a list of tagged
+	sections, which only copies the tables, and checkpoint_writer saves it from a thread of its own, so the
+	control loop never waits for the disk. Files are written to path.tmp, synced and renamed over path, so
+	a crash or Ctrl-C while writing leaves the previous checkpoint in place and a reader never sees half a
+	file. A checksum over the sections catches files cut short or damaged in any other way.
+	The file is read back on the machine it was written on: values are stored in host byte order.
+	@author Alex Cornelio
+*/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "random.hpp"
+
+#define CHECKPOINT_MAGIC "RLCKPT01"
+
+// section tags used by rl_lib. Learners are free to use any tag from CHECKPOINT_USER on
+#define CHECKPOINT_RUN 1
+#define CHECKPOINT_Q 2
+#define CHECKPOINT_VISITS 3
+#define CHECKPOINT_AGENT_RNG 4
+#define CHECKPOINT_ENV_RNG 5
+// convergence_detector::save uses this tag and the two after it
+#define CHECKPOINT_CONVERGENCE 8
+// dyna_model::save uses this tag and the three after it
+#define CHECKPOINT_MODEL 16
+#define CHECKPOINT_USER 256
+
+/**
+	Counters and exploration schedule of a run, at the end of an episode
+*/
+struct run_state
+{
+    uint64_t episode;       // episodes finished
+    uint64_t steps;         // steps over all of them
+    uint32_t wins;
+    uint32_t loses;
+    float epsilon;
+    float alpha;
+};
+
+/**
+	Header at the start of a checkpoint file
+*/
+struct checkpoint_header
+{
+    char magic[8];
+    uint64_t bytes;     // of the sections that follow
+    uint64_t checksum;  // FNV-1a of those bytes
+};
+
+class checkpoint
+{
+public:
+    checkpoint();
+    ~checkpoint();
+
+    // building
+    void clear();
+    void add(uint32_t tag, const void *data, std::size_t bytes);
+    template <class T>
+    void addVector(uint32_t tag, const std::vector<T> &values) { add(tag, values.data(), values.size() * sizeof(T)); }
+    void addEngine(uint32_t tag, const random_engine &rng);
+    template <class Table>
+    void addTable(uint32_t tag, const Table &Q);
+    template <class Table>
+    void addVisits(uint32_t tag, const Table &Q);
+
+    // reading back, false if the section is missing or has another size
+    bool get(uint32_t tag, void *data, std::size_t bytes) const;
+    template <class T>
+    bool getVector(uint32_t tag, std::vector<T> &values) const;
+    bool getEngine(uint32_t tag, random_engine &rng) const;
+    template <class Table>
+    bool getTable(uint32_t tag, Table &Q) const;
+    template <class Table>
+    bool getVisits(uint32_t tag, Table &Q) const;
+
+    bool write(const std::string &path) const;
+    bool read(const std::string &path);
+
+    std::size_t bytes() const { return buffer_.size(); }
+    void swap(checkpoint &other) { buffer_.swap(other.buffer_); }
+
+private:
+    /**
+    	Start of every section, the data follows padded to 8 bytes
+    */
+    struct section
+    {
+        uint32_t tag;
+        uint32_t reserved;
+        uint64_t bytes;
+    };
+
+    std::vector<unsigned char> buffer_;
+
+    unsigned char *reserve(uint32_t tag, std::size_t bytes);
+    const unsigned char *find(uint32_t tag, std::size_t *bytes) const;
+    static uint64_t checksum(const unsigned char *data, std::size_t bytes);
+};
+
+/**
+	Writes checkpoints from a background thread. submit() hands a snapshot over by swapping buffers, so the
+	caller gets an older buffer back to fill next time and nothing is allocated once the sizes have settled.
+	When a new snapshot comes in before the last one was written only the newer one is written
+*/
+class checkpoint_writer
+{
+public:
+    explicit checkpoint_writer(const std::string &path);
+    ~checkpoint_writer();
+
+    void submit(checkpoint &snapshot);
+    void flush();
+
+    const std::string &path() const { return path_; }
+    unsigned int written();
+    unsigned int failed();
+
+private:
+    std::string path_;
+    checkpoint pending_;
+    checkpoint writing_;
+    bool has_pending_;
+    bool busy_;
+    bool stop_;
+    unsigned int written_;
+    unsigned int failed_;
+    std::mutex lock_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::thread thread_;
+
+    void run();
+};
+
+/**
+	Add the Q values of every state as stored, STRIDE values per row. Works for the tables whose rows are the
+	states 0 .. Q.states() - 1 (QTable, CountedQTable), not for SparseQTable
+*/
+template <class Table>
+void checkpoint::addTable(uint32_t tag, const Table &Q)
+{
+    typedef typename Table::value_type value_type;
+    std::size_t row_bytes = Q.stride() * sizeof(value_type);
+    unsigned char *out = reserve(tag, Q.states() * row_bytes);
+    for (std::size_t s = 0; s < Q.states(); s++)
+    {
+        const value_type *row = Q[s];
+        const unsigned char *in = reinterpret_cast<const unsigned char *>(row);
+        std::copy(in, in + row_bytes, out + s * row_bytes);
+    }
+}
+
+/**
+	Add the visit counts of a CountedQTable, STRIDE counts per row
+*/
+template <class Table>
+void checkpoint::addVisits(uint32_t tag, const Table &Q)
+{
+    std::size_t row_bytes = Q.stride() * sizeof(uint32_t);
+    unsigned char *out = reserve(tag, Q.states() * row_bytes);
+    for (std::size_t s = 0; s < Q.states(); s++)
+    {
+        const unsigned char *in = reinterpret_cast<const unsigned char *>(Q.visits(s));
+        std::copy(in, in + row_bytes, out + s * row_bytes);
+    }
+}
+
+/**
+	Read a vector added with addVector, sized from the section
+*/
+template <class T>
+bool checkpoint::getVector(uint32_t tag, std::vector<T> &values) const
+{
+    std::size_t bytes;
+    const unsigned char *in = find(tag, &bytes);
+    if (!in || bytes % sizeof(T) != 0)
+    {
+        return false;
+    }
+    values.resize(bytes / sizeof(T));
+    std::copy(in, in + bytes, reinterpret_cast<unsigned char *>(values.data()));
+    return true;
+}
+
+/**
+	Read Q values added with addTable into a table of the same dimensions
+*/
+template <class Table>
+bool checkpoint::getTable(uint32_t tag, Table &Q) const
+{
+    typedef typename Table::value_type value_type;
+    std::size_t row_bytes = Q.stride() * sizeof(value_type);
+    std::size_t bytes;
+    const unsigned char *in = find(tag, &bytes);
+    if (!in || bytes != Q.states() * row_bytes)
+    {
+        return false;
+    }
+    for (std::size_t s = 0; s < Q.states(); s++)
+    {
+        value_type *row = Q[s];
+        std::copy(in + s * row_bytes, in + (s + 1) * row_bytes, reinterpret_cast<unsigned char *>(row));
+    }
+    return true;
+}
+
+/**
+	Read visit counts added with addVisits into a CountedQTable of the same dimensions
+*/
+template <class Table>
+bool checkpoint::getVisits(uint32_t tag, Table &Q) const
+{
+    std::size_t row_bytes = Q.stride() * sizeof(uint32_t);
+    std::size_t bytes;
+    const unsigned char *in = find(tag, &bytes);
+    if (!in || bytes != Q.states() * row_bytes)
+    {
+        return false;
+    }
+    for (std::size_t s = 0; s < Q.states(); s++)
+    {
+        std::copy(in + s * row_bytes, in + (s + 1) * row_bytes, reinterpret_cast<unsigned char *>(Q.visits(s)));
+    }
+    return true;
+}
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,117 @@
+/**
+	Convergence detector class methods. The update of a Q table is templated on the table and lives in the
+	header
+	@author Alex Cornelio
+*/
+
+#include "convergence_detector.hpp"
+
+convergence_detector::convergence_detector(unsigned int window, float tolerance, unsigned int max_policy_changes)
+    :window_(window > 0 ? window : 1),
+     tolerance_(tolerance),
+     max_policy_changes_(max_policy_changes),
+     policy_changes_(window > 0 ? window : 1, 0)
+{
+    reset();
+}
+
+convergence_detector::~convergence_detector()
+{
+
+}
+
+/**
+	Note one TD update of the current episode: the value moved by change, and the greedy action of its state
+	changed if policy_changed
+*/
+void convergence_detector::record(float change, bool policy_changed)
+{
+    change = change < 0 ? -change : change;
+    episode_change_ = change > episode_change_ ? change : episode_change_;
+    episode_policy_changes_ += policy_changed;
+}
+
+/**
+	Close the current episode: slide the window over it and return whether training has converged
+*/
+bool convergence_detector::endEpisode()
+{
+    unsigned int slot = episodes_ % window_;
+    window_policy_changes_ += episode_policy_changes_ - policy_changes_[slot];
+    policy_changes_[slot] = episode_policy_changes_;
+
+    // episodes that left the window go from the front, smaller changes before this one from the back
+    while (!maxima_.empty() && maxima_.front().episode + window_ <= episodes_)
+    {
+        maxima_.pop_front();
+    }
+    while (!maxima_.empty() && maxima_.back().change <= episode_change_)
+    {
+        maxima_.pop_back();
+    }
+    episode_change e = {episodes_, episode_change_};
+    maxima_.push_back(e);
+
+    episodes_++;
+    episode_change_ = 0;
+    episode_policy_changes_ = 0;
+    converged_ = episodes_ >= window_ && windowChange() <= tolerance_ &&
+                 window_policy_changes_ <= max_policy_changes_;
+    return converged_;
+}
+
+/**
+	Forget every episode, for a new run
+*/
+void convergence_detector::reset()
+{
+    episode_change_ = 0;
+    episode_policy_changes_ = 0;
+    episodes_ = 0;
+    maxima_.clear();
+    for (std::size_t k = 0; k < policy_changes_.size(); k++)
+    {
+        policy_changes_[k] = 0;
+    }
+    window_policy_changes_ = 0;
+    converged_ = false;
+}
+
+/**
+	Add the window to a checkpoint, under CHECKPOINT_CONVERGENCE and the two tags after it
+*/
+void convergence_detector::save(checkpoint &snapshot) const
+{
+    uint32_t counters[4] = {episodes_, episode_policy_changes_, window_policy_changes_, converged_};
+    std::vector<episode_change> maxima(maxima_.begin(), maxima_.end());
+    snapshot.add(CHECKPOINT_CONVERGENCE, counters, sizeof(counters));
+    snapshot.addVector(CHECKPOINT_CONVERGENCE + 1, maxima);
+    snapshot.addVector(CHECKPOINT_CONVERGENCE + 2, policy_changes_);
+}
+
+/**
+	Restore a window saved with save by a detector of the same window length. Returns false, and leaves the
+	detector as it was, otherwise
+*/
+bool convergence_detector::load(const checkpoint &snapshot)
+{
+    uint32_t counters[4];
+    std::vector<episode_change> maxima;
+    std::vector<unsigned int> policy_changes;
+    if (!snapshot.get(CHECKPOINT_CONVERGENCE, counters, sizeof(counters)) ||
+        !snapshot.getVector(CHECKPOINT_CONVERGENCE + 1, maxima) ||
+        !snapshot.getVector(CHECKPOINT_CONVERGENCE + 2, policy_changes) || policy_changes.size() != window_)
+    {
+        return false;
+    }
+    episodes_ = counters[0];
+    episode_policy_changes_ = counters[1];
+    window_policy_changes_ = counters[2];
+    converged_ = counters[3] != 0;
+    // an episode that had not ended moved nothing yet, checkpoints are taken between episodes
+    episode_change_ = 0;
+    maxima_.assign(maxima.begin(), maxima.end());
+    policy_changes_.swap(policy_changes);
+    return true;
+}
+
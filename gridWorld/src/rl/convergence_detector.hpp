@@ -0,0 +1,103 @@
+/**
+	Convergence detector class declaration.
+	Decides when training can stop without looking at the whole Q table. Every TD update goes through
+	update(), which notes how far the value moved and whether the greedy action of its state changed, both
+	read from the one row the update touches anyway. At the end of each episode the largest change and the
+	number of greedy changes of that episode enter a sliding window of the last episodes: the largest change
+	in the window is kept by a monotonic queue and the greedy changes by a running sum, so closing an episode
+	costs O(1) amortised. Training has converged once the window is full, no value in it moved by more than
+	the tolerance and the greedy policy changed at most max_policy_changes times.
+	@author Alex Cornelio
+*/
+
+#ifndef CONVERGENCE_DETECTOR_H
+#define CONVERGENCE_DETECTOR_H
+
+#include <deque>
+#include <vector>
+
+#include "checkpoint.hpp"
+#include "environment.hpp"
+
+class convergence_detector
+{
+public:
+    convergence_detector(unsigned int window, float tolerance, unsigned int max_policy_changes = 0);
+    ~convergence_detector();
+
+    template <class Table>
+    void update(Table &Q, state_t s, action_mask_t available_actions, char action, float delta);
+    void record(float change, bool policy_changed);
+    bool endEpisode();
+    void reset();
+    void save(checkpoint &snapshot) const;
+    bool load(const checkpoint &snapshot);
+
+    bool converged() const { return converged_; }
+    unsigned int episodes() const { return episodes_; }
+    // over the episodes in the window
+    float windowChange() const { return maxima_.empty() ? 0.0f : maxima_.front().change; }
+    unsigned int windowPolicyChanges() const { return window_policy_changes_; }
+
+private:
+    /**
+    	Largest change of an episode, kept while no later episode in the window beats it
+    */
+    struct episode_change
+    {
+        unsigned int episode;
+        float change;
+    };
+
+    unsigned int window_;
+    float tolerance_;
+    unsigned int max_policy_changes_;
+
+    // current episode
+    float episode_change_;
+    unsigned int episode_policy_changes_;
+
+    unsigned int episodes_;
+    std::deque<episode_change> maxima_;
+    // greedy changes of the last window episodes, a ring indexed by episode
+    std::vector<unsigned int> policy_changes_;
+    unsigned int window_policy_changes_;
+    bool converged_;
+
+    template <class Table>
+    static char greedy(Table &Q, state_t s, action_mask_t available_actions);
+};
+
+/**
+	First available action of s with the largest Q value, the same one every time for the same row
+*/
+template <class Table>
+inline char convergence_detector::greedy(Table &Q, state_t s, action_mask_t available_actions)
+{
+    char best = (char)__builtin_ctz(available_actions);
+    for (unsigned int a = best + 1; available_actions >> a; a++)
+    {
+        if (((available_actions >> a) & 1) && Q[s][a] > Q[s][(int)best])
+        {
+            best = (char)a;
+        }
+    }
+    return best;
+}
+
+/**
+	Add delta to Q(s, action) and record how far it moved and whether the greedy action of s among
+	available_actions changed. Illegal actions are left out, as their untouched values may hold the row
+	maximum and hide every change of the policy. The change is read back from the table, so values stored in
+	16 bits count what was really stored
+*/
+template <class Table>
+inline void convergence_detector::update(Table &Q, state_t s, action_mask_t available_actions, char action, float delta)
+{
+    char before_action = greedy(Q, s, available_actions);
+    float before = Q[s][(int)action];
+    Q[s][(int)action] += delta;
+    record((float)Q[s][(int)action] - before, greedy(Q, s, available_actions) != before_action);
+}
+
+#endif // CONVERGENCE_DETECTOR_H
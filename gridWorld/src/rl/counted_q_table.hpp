@@ -0,0 +1,309 @@
+/**
+	CountedQTable class declaration and methods.
+	A Q table that also counts how often every (state, action) pair has been updated, for learning rates that
+	shrink with the visits of a pair (visitRate) and for exploration by count (ucbAction in
+	action_selection.hpp). Each state's counts are stored right after its Q row in one block, so the row the
+	TD update reads and writes and the count it bumps share a cache line: with float values 4 actions take 32
+	bytes per state, 7 or 8 actions one 64 byte line. The Q row keeps the stride and padding of QTable, so rowMax and rowArgmax
+	scan it the same way, and the table can be used wherever a QTable is.
+	@author Alex Cornelio
+*/
+
+#ifndef COUNTED_Q_TABLE_H
+#define COUNTED_Q_TABLE_H
+
+#include <cmath>
+#include <cstddef>
+#include <limits.h>
+#include <limits>
+#include <new>
+#include <stdint.h>
+
+#include "action_selection.hpp"
+#include "environment.hpp"
+#include "q_table.hpp"
+#include "training.hpp"
+
+/**
+	States x Actions table of Q values with a visit count next to every value
+*/
+template <std::size_t States, std::size_t Actions, typename T = float>
+class CountedQTable
+{
+public:
+    typedef T value_type;
+    // padded row length, the same as QTable's
+    static constexpr std::size_t STRIDE = QTable<1, Actions, T>::STRIDE;
+
+    CountedQTable();
+    explicit CountedQTable(T initial_value);
+    CountedQTable(std::size_t states, T initial_value);
+    CountedQTable(const CountedQTable &other);
+    CountedQTable &operator=(const CountedQTable &other);
+    ~CountedQTable();
+
+    T *operator[](std::size_t s) { return rows_[s].values; }
+    const T *operator[](std::size_t s) const { return rows_[s].values; }
+
+    uint32_t *visits(std::size_t s) { return rows_[s].visits; }
+    const uint32_t *visits(std::size_t s) const { return rows_[s].visits; }
+    uint32_t visit(std::size_t s, std::size_t a) { return ++rows_[s].visits[a]; }
+
+    std::size_t states() const { return States != Q_TABLE_DYNAMIC_STATES ? States : states_; }
+    constexpr std::size_t actions() const { return Actions; }
+    constexpr std::size_t stride() const { return STRIDE; }
+
+    void fill(T value);
+    void clearVisits();
+    std::size_t argmax(std::size_t s) const;
+    T max(std::size_t s) const;
+
+private:
+    /**
+    	One state: its Q row, padded as in QTable, then the counts of its actions
+    */
+    struct alignas(Q_TABLE_SIMD_BYTES) row
+    {
+        T values[STRIDE];
+        uint32_t visits[STRIDE];
+    };
+
+    row *rows_;
+    std::size_t states_;
+
+    void allocate();
+    void release();
+};
+
+/**
+	Constructor. All Q values and counts start at zero
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+CountedQTable<States, Actions, T>::CountedQTable()
+    :states_(States)
+{
+    allocate();
+    fill(T(0));
+}
+
+/**
+	Constructor. All Q values start at initial_value
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+CountedQTable<States, Actions, T>::CountedQTable(T initial_value)
+    :states_(States)
+{
+    allocate();
+    fill(initial_value);
+}
+
+/**
+	Constructor for a table with states rows, all Q values start at initial_value
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+CountedQTable<States, Actions, T>::CountedQTable(std::size_t states, T initial_value)
+    :states_(states)
+{
+    static_assert(States == Q_TABLE_DYNAMIC_STATES, "the number of rows is already fixed by the template");
+    allocate();
+    fill(initial_value);
+}
+
+/**
+	Copy constructor
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+CountedQTable<States, Actions, T>::CountedQTable(const CountedQTable &other)
+    :states_(other.states_)
+{
+    allocate();
+    for (std::size_t s = 0; s < states(); s++)
+    {
+        rows_[s] = other.rows_[s];
+    }
+}
+
+/**
+	Copy assignment
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+CountedQTable<States, Actions, T> &CountedQTable<States, Actions, T>::operator=(const CountedQTable &other)
+{
+    if (other.states_ != states_)
+    {
+        release();
+        states_ = other.states_;
+        allocate();
+    }
+    for (std::size_t s = 0; s < states(); s++)
+    {
+        rows_[s] = other.rows_[s];
+    }
+    return *this;
+}
+
+/**
+	Destructor
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+CountedQTable<States, Actions, T>::~CountedQTable()
+{
+    release();
+}
+
+/**
+	Get one aligned block for every row and construct them in it. Counts start at zero
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+void CountedQTable<States, Actions, T>::allocate()
+{
+    void *raw = ::operator new[](states() * sizeof(row), std::align_val_t(Q_TABLE_ALIGNMENT));
+    rows_ = static_cast<row *>(raw);
+    for (std::size_t s = 0; s < states(); s++)
+    {
+        new (rows_ + s) row();
+    }
+    clearVisits();
+}
+
+/**
+	Destroy every row and give the block back
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+void CountedQTable<States, Actions, T>::release()
+{
+    for (std::size_t s = 0; s < states(); s++)
+    {
+        rows_[s].~row();
+    }
+    ::operator delete[](rows_, std::align_val_t(Q_TABLE_ALIGNMENT));
+}
+
+/**
+	Set every Q value, with the padding at the lowest value as in QTable. The counts are kept
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+void CountedQTable<States, Actions, T>::fill(T value)
+{
+    for (std::size_t s = 0; s < states(); s++)
+    {
+        for (std::size_t a = 0; a < Actions; a++)
+        {
+            rows_[s].values[a] = value;
+        }
+        for (std::size_t a = Actions; a < STRIDE; a++)
+        {
+            rows_[s].values[a] = std::numeric_limits<T>::lowest();
+        }
+    }
+}
+
+/**
+	Set every count to zero
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+void CountedQTable<States, Actions, T>::clearVisits()
+{
+    for (std::size_t s = 0; s < states(); s++)
+    {
+        for (std::size_t a = 0; a < STRIDE; a++)
+        {
+            rows_[s].visits[a] = 0;
+        }
+    }
+}
+
+/**
+	Return the index of the best action in state s. Ties go to the lowest index, same as std::max_element
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+std::size_t CountedQTable<States, Actions, T>::argmax(std::size_t s) const
+{
+    return rowArgmax<Actions, STRIDE>(rows_[s].values);
+}
+
+/**
+	Return the best Q value in state s
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+T CountedQTable<States, Actions, T>::max(std::size_t s) const
+{
+    return rowMax<Actions, STRIDE>(rows_[s].values);
+}
+
+/**
+	Learning rate of a pair updated for the visits-th time: 1 / visits^exponent, never below minimum. An
+	exponent of 1 averages every target the pair has seen, exponents between 0.5 and 1 weigh recent targets
+	more, which suits targets that still move as the rest of Q learns, and still settle where transitions
+	are noisy, unlike a constant rate. An exponent of 0 gives the constant rate minimum
+*/
+inline float visitRate(unsigned int visits, float exponent, float minimum)
+{
+    if (exponent <= 0)
+    {
+        return minimum;
+    }
+    if (visits <= 1)
+    {
+        return 1.0f;
+    }
+    float rate = exponent == 1.0f ? 1.0f / visits : std::pow((float)visits, -exponent);
+    return rate < minimum ? minimum : rate;
+}
+
+/**
+	How a counted agent learns and explores
+*/
+struct count_parameters
+{
+    float rate_exponent;    // learning rate 1 / visits^rate_exponent (visitRate), 0 keeps the constant alpha
+    float min_alpha;        // lowest learning rate
+    float ucb_c;            // weight of the UCB bonus, 0 explores epsilon greedy through the policy
+};
+
+/**
+	Run one Q-learning episode from start on a table with visit counts. Every update bumps the count of its
+	pair, whose learning rate then comes from the count, and with ucb_c above 0 actions are picked by
+	ucbAction instead of the policy's epsilon greedy choice
+*/
+template <class Env, class Table, class Policy>
+episode_result countedQLearningEpisode(Env &env, Table &Q, Policy &policy, state_t start, float epsilon,
+                                       const td_parameters &params, const count_parameters &counts,
+                                       unsigned int max_steps = UINT_MAX)
+{
+    episode_result result = {0, 0, 0, 0.0f};
+    state_t current_state = start;
+    float scratch[MAX_ACTIONS];
+
+    while (result.steps < max_steps)
+    {
+        //choose action among the legal actions, by count or by the policy
+        action_mask_t available_actions = env.mask(current_state);
+        char action = counts.ucb_c > 0
+            ? ucbAction(available_actions, rowView(Q, current_state, scratch), Q.visits(current_state), counts.ucb_c, policy.rng)
+            : policy.chooseAction(epsilon, available_actions, rowView(Q, current_state, scratch));
+
+        //take action to get next state and reward
+        step_result step = env.step(current_state, action);
+
+        //TD update with the pair's own learning rate
+        unsigned int visits = Q.visit(current_state, action);
+        float alpha = counts.rate_exponent > 0 ? visitRate(visits, counts.rate_exponent, counts.min_alpha) : params.alpha;
+        float td_target = step.reward + params.discount_factor * Q.max(step.next_state);
+        float td_error = td_target - Q[current_state][(int)action];
+        Q[current_state][(int)action] += td_error * alpha;
+
+        result.steps++;
+        result.reward = step.reward;
+        result.episode_return += step.reward;
+        if (step.done)
+        {
+            break;
+        }
+        result.time_step++;
+        current_state = step.next_state;
+    }
+    return result;
+}
+
+#endif // COUNTED_Q_TABLE_H
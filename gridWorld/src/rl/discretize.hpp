@@ -0,0 +1,41 @@
+/**
+	Discretisation of continuous measurements into table states.
+	This is the pitch / pitch rate binning the Gazebo plugins and the robot controller do in get_state, kept in
+	one place so it can be shared and benchmarked on the host.
+	@author Alex Cornelio
+*/
+
+#ifndef DISCRETIZE_H
+#define DISCRETIZE_H
+
+#include <cstddef>
+
+/**
+	Return the bin of value given sorted bin edges: the first i with value <= edges[i], or N when value is
+	above the last edge. Same answer as the loops in get_state. A plain early exit scan measured faster than
+	a branch free count or binary search for the handful of edges used here (see the discretize cases of rl_bench)
+*/
+template <typename T, std::size_t N>
+inline int binIndex(float value, const T (&edges)[N])
+{
+    for (std::size_t k = 0; k < N; k++)
+    {
+        if (value <= edges[k])
+        {
+            return (int)k;
+        }
+    }
+    return value > edges[N - 1] ? (int)N : 0;
+}
+
+/**
+	Return the state number of a (pitch, pitch rate) pair. There are N+1 bins per measurement, so the table
+	needs (N_PHI+1)*(N_PHI_D+1) rows
+*/
+template <typename T, std::size_t N_PHI, typename U, std::size_t N_PHI_D>
+inline int pitchState(float pitch, float pitch_dot, const T (&phi_states)[N_PHI], const U (&phi_d_states)[N_PHI_D])
+{
+    return binIndex(pitch_dot, phi_d_states) + (int)(N_PHI_D + 1) * binIndex(pitch, phi_states);
+}
+
+#endif // DISCRETIZE_H
@@ -0,0 +1,97 @@
+/**
+	Dyna-Q model class methods. Planning is templated on the Q table and lives in the header
+	@author Alex Cornelio
+*/
+
+#include "dyna_model.hpp"
+
+dyna_model::dyna_model(unsigned int states, unsigned int actions)
+    :actions_(actions),
+     index_(states * actions, UNSEEN)
+{
+}
+
+dyna_model::~dyna_model()
+{
+
+}
+
+/**
+	Add a real transition: action in s led to next_state and paid reward, and the episode ended there if done
+*/
+void dyna_model::observe(state_t s, char action, state_t next_state, float reward, bool done)
+{
+    uint32_t &i = index_[s * actions_ + action];
+    if (i == UNSEEN)
+    {
+        entry e = {s, 0, UNSEEN, (unsigned char)action};
+        i = (uint32_t)entries_.size();
+        entries_.push_back(e);
+    }
+    entry &e = entries_[i];
+    e.visits++;
+
+    uint32_t *link = &e.first;
+    while (*link != UNSEEN)
+    {
+        outcome &o = outcomes_[*link];
+        if (o.next_state == next_state)
+        {
+            o.count++;
+            o.reward_sum += reward;
+            return;
+        }
+        link = &o.next;
+    }
+    outcome o = {next_state, 1, reward, UNSEEN, done};
+    *link = (uint32_t)outcomes_.size();
+    outcomes_.push_back(o);
+}
+
+/**
+	Forget every transition
+*/
+void dyna_model::clear()
+{
+    for (std::size_t k = 0; k < entries_.size(); k++)
+    {
+        index_[entries_[k].s * actions_ + entries_[k].action] = UNSEEN;
+    }
+    entries_.clear();
+    outcomes_.clear();
+}
+
+/**
+	Add the model and the state of its engine to a checkpoint, under CHECKPOINT_MODEL and the three tags
+	after it
+*/
+void dyna_model::save(checkpoint &snapshot) const
+{
+    snapshot.addVector(CHECKPOINT_MODEL, index_);
+    snapshot.addVector(CHECKPOINT_MODEL + 1, entries_);
+    snapshot.addVector(CHECKPOINT_MODEL + 2, outcomes_);
+    snapshot.addEngine(CHECKPOINT_MODEL + 3, rng_);
+}
+
+/**
+	Restore a model saved with save. Returns false, and leaves the model as it was, if the checkpoint has no
+	model or one of another size
+*/
+bool dyna_model::load(const checkpoint &snapshot)
+{
+    std::vector<uint32_t> index;
+    std::vector<entry> entries;
+    std::vector<outcome> outcomes;
+    random_engine rng;
+    if (!snapshot.getVector(CHECKPOINT_MODEL, index) || index.size() != index_.size() ||
+        !snapshot.getVector(CHECKPOINT_MODEL + 1, entries) || !snapshot.getVector(CHECKPOINT_MODEL + 2, outcomes) ||
+        !snapshot.getEngine(CHECKPOINT_MODEL + 3, rng))
+    {
+        return false;
+    }
+    index_.swap(index);
+    entries_.swap(entries);
+    outcomes_.swap(outcomes);
+    rng_ = rng;
+    return true;
+}
@@ -0,0 +1,177 @@
+/**
+	Dyna-Q model class declaration (Sutton, Dyna).
+	Remembers the outcomes of every (state, action) pair the agent has tried: each next state it has led to,
+	how often, the mean reward there and whether the episode ended, in small entries chained per pair.
+	After every real step the agent replays planning steps from the model: a tried pair is drawn at random,
+	one of its outcomes is drawn as often as it was seen, and the pair gets the same TD update a real step
+	would give it. Every real transition is then learnt from many times, which is what counts where real
+	steps are expensive, as on the robot, and planning costs little more than the Q table update itself.
+	Drawing from the counts instead of replaying the last outcome keeps noisy transitions (the slips of the
+	grid world) at their observed frequencies, so planning does not chase whichever outcome came last.
+	@author Alex Cornelio
+*/
+
+#ifndef DYNA_MODEL_H
+#define DYNA_MODEL_H
+
+#include <cstddef>
+#include <limits.h>
+#include <stdint.h>
+#include <vector>
+
+#include "action_selection.hpp"
+#include "checkpoint.hpp"
+#include "environment.hpp"
+#include "random.hpp"
+#include "training.hpp"
+
+class dyna_model
+{
+public:
+    dyna_model(unsigned int states, unsigned int actions);
+    ~dyna_model();
+
+    void seed(uint64_t seed_value, uint64_t stream = 0) { rng_.seed(seed_value, stream); }
+    void observe(state_t s, char action, state_t next_state, float reward, bool done);
+    void clear();
+    void save(checkpoint &snapshot) const;
+    bool load(const checkpoint &snapshot);
+
+    template <class Table>
+    unsigned int plan(Table &Q, unsigned int planning_steps, const td_parameters &params);
+
+    // number of pairs tried
+    unsigned int size() const { return (unsigned int)entries_.size(); }
+
+private:
+    static constexpr uint32_t UNSEEN = 0xffffffff;
+
+    /**
+    	A tried pair and the first of its outcomes
+    */
+    struct entry
+    {
+        state_t s;
+        unsigned int visits;
+        uint32_t first;
+        unsigned char action;
+    };
+
+    /**
+    	One next state of a pair, next is the pair's following outcome or UNSEEN
+    */
+    struct outcome
+    {
+        state_t next_state;
+        unsigned int count;
+        float reward_sum;
+        uint32_t next;
+        bool done;
+    };
+
+    unsigned int actions_;
+    // entry of every pair s * actions + a, UNSEEN until it is tried
+    std::vector<uint32_t> index_;
+    std::vector<entry> entries_;
+    std::vector<outcome> outcomes_;
+    random_engine rng_;
+
+    const outcome &sample(const entry &e);
+};
+
+/**
+	Return one outcome of a pair, each with the probability it was observed with
+*/
+inline const dyna_model::outcome &dyna_model::sample(const entry &e)
+{
+    unsigned int pick = rng_.below(e.visits);
+    uint32_t k = e.first;
+    while (pick >= outcomes_[k].count)
+    {
+        pick -= outcomes_[k].count;
+        k = outcomes_[k].next;
+    }
+    return outcomes_[k];
+}
+
+/**
+	Replay planning_steps transitions from the model, each from a pair drawn uniformly from the pairs tried so
+	far, with the Q-learning update of training.hpp. Returns the number of updates done
+*/
+template <class Table>
+unsigned int dyna_model::plan(Table &Q, unsigned int planning_steps, const td_parameters &params)
+{
+    if (entries_.empty())
+    {
+        return 0;
+    }
+    for (unsigned int i = 0; i < planning_steps; i++)
+    {
+        const entry &e = entries_[rng_.below((unsigned int)entries_.size())];
+        const outcome &o = sample(e);
+        float reward = o.reward_sum / o.count;
+        float td_target = reward + (o.done ? 0.0f : params.discount_factor * (float)Q.max(o.next_state));
+        float td_error = td_target - Q[e.s][e.action];
+        Q[e.s][e.action] += td_error * params.alpha;
+    }
+    return planning_steps;
+}
+
+/**
+	Run one Dyna-Q episode from start: a Q-learning episode that also remembers every real transition in
+	model and plans planning_steps updates after each one. The real updates are recorded in detector and the
+	real transitions in trace if there are
+*/
+template <class Env, class Table, class Policy>
+episode_result dynaQEpisode(Env &env, Table &Q, Policy &policy, dyna_model &model, state_t start, float epsilon,
+                            const td_parameters &params, unsigned int planning_steps, unsigned int max_steps = UINT_MAX,
+                            convergence_detector *detector = NULL, trace_writer *trace = NULL)
+{
+    episode_result result = {0, 0, 0, 0.0f};
+    state_t current_state = start;
+    float scratch[MAX_ACTIONS];
+
+    while (result.steps < max_steps)
+    {
+        //choose action based on policy among the legal actions
+        action_mask_t available_actions = env.mask(current_state);
+        char action = policy.chooseAction(epsilon, available_actions, rowView(Q, current_state, scratch));
+
+        //take action to get next state and reward
+        step_result step = env.step(current_state, action);
+
+        //TD update
+        float td_target = step.reward + params.discount_factor * Q.max(step.next_state);
+        float td_error = td_target - Q[current_state][(int)action];
+        if (detector)
+        {
+            detector->update(Q, current_state, available_actions, action, td_error * params.alpha);
+        }
+        else
+        {
+            Q[current_state][(int)action] += td_error * params.alpha;
+        }
+
+        //remember the transition and learn from the model
+        model.observe(current_state, action, step.next_state, step.reward, step.done);
+        model.plan(Q, planning_steps, params);
+
+        if (trace)
+        {
+            trace->record(result.steps, current_state, action, step.reward, step.next_state, td_error, step.done);
+        }
+
+        result.steps++;
+        result.reward = step.reward;
+        result.episode_return += step.reward;
+        if (step.done)
+        {
+            break;
+        }
+        result.time_step++;
+        current_state = step.next_state;
+    }
+    return result;
+}
+
+#endif // DYNA_MODEL_H
@@ -0,0 +1,219 @@
+/**
+	Eligibility traces for SARSA(lambda) and Watkins' Q(lambda), kept as a list of the active (state, action)
+	pairs only.
+	Every TD error is applied to all pairs in proportion to their trace, and every trace decays by
+	discount_factor * lambda per step. A trace that falls below the threshold is dropped from the list, so a
+	step costs the pairs visited in the last few steps and not the whole table, and a reward at the end of an
+	episode (a fall of the robot, the goal or the cliff of the grid world) reaches the pairs that led to it in
+	that same step instead of creeping back one state per episode. The position of each pair in the list is
+	kept in a dense index so a revisited pair is found without a search.
+	Traces are replacing: a visit sets the pair's trace to 1 instead of adding 1 to it.
+	@author Alex Cornelio
+*/
+
+#ifndef ELIGIBILITY_TRACES_H
+#define ELIGIBILITY_TRACES_H
+
+#include <cstddef>
+#include <limits.h>
+#include <stdint.h>
+#include <vector>
+
+#include "action_selection.hpp"
+#include "environment.hpp"
+#include "training.hpp"
+
+class eligibility_traces
+{
+public:
+    eligibility_traces(unsigned int states, unsigned int actions, float threshold = 1e-3f)
+        :actions_(actions),
+         threshold_(threshold),
+         slot_((std::size_t)states * actions, ABSENT)
+    {
+    }
+
+    void visit(state_t s, char action);
+    template <class Table>
+    void update(Table &Q, float step, float decay);
+    void clear();
+
+    // number of pairs with a trace above the threshold
+    unsigned int active() const { return (unsigned int)active_.size(); }
+
+private:
+    static constexpr uint32_t ABSENT = 0xffffffff;
+
+    /**
+    	A pair s * actions + a and its trace
+    */
+    struct trace
+    {
+        uint32_t pair;
+        float value;
+    };
+
+    unsigned int actions_;
+    float threshold_;
+    std::vector<trace> active_;
+    // position of every pair in active_, ABSENT if it has no trace
+    std::vector<uint32_t> slot_;
+};
+
+/**
+	Set the trace of (s, action) to 1, adding the pair to the active list if it is not there
+*/
+inline void eligibility_traces::visit(state_t s, char action)
+{
+    uint32_t pair = (uint32_t)(s * actions_ + action);
+    if (slot_[pair] != ABSENT)
+    {
+        active_[slot_[pair]].value = 1.0f;
+        return;
+    }
+    slot_[pair] = (uint32_t)active_.size();
+    trace t = {pair, 1.0f};
+    active_.push_back(t);
+}
+
+/**
+	Add step times its trace to Q of every active pair, then multiply the traces by decay and drop those below
+	the threshold. A decay of 0 applies step and then cuts every trace
+*/
+template <class Table>
+void eligibility_traces::update(Table &Q, float step, float decay)
+{
+    std::size_t k = 0;
+    while (k < active_.size())
+    {
+        trace &t = active_[k];
+        Q[t.pair / actions_][t.pair % actions_] += step * t.value;
+        t.value *= decay;
+        if (t.value >= threshold_)
+        {
+            k++;
+            continue;
+        }
+        // the last pair fills the hole and is looked at next
+        slot_[t.pair] = ABSENT;
+        if (k + 1 < active_.size())
+        {
+            active_[k] = active_.back();
+            slot_[active_[k].pair] = (uint32_t)k;
+        }
+        active_.pop_back();
+    }
+}
+
+/**
+	Drop every trace, at the start of an episode
+*/
+inline void eligibility_traces::clear()
+{
+    for (std::size_t k = 0; k < active_.size(); k++)
+    {
+        slot_[active_[k].pair] = ABSENT;
+    }
+    active_.clear();
+}
+
+/**
+	Run one SARSA(lambda) episode from start: sarsaEpisode with every TD error applied through traces. Every
+	transition is written to trace if there is one
+*/
+template <class Env, class Table, class Policy>
+episode_result sarsaLambdaEpisode(Env &env, Table &Q, Policy &policy, eligibility_traces &traces, state_t start,
+                                  float epsilon, const td_parameters &params, float lambda,
+                                  unsigned int max_steps = UINT_MAX, trace_writer *trace = NULL)
+{
+    episode_result result = {0, 0, 0, 0.0f};
+    state_t current_state = start;
+    float scratch[MAX_ACTIONS];
+    char action = policy.chooseAction(epsilon, env.mask(current_state), rowView(Q, current_state, scratch));
+    traces.clear();
+
+    while (result.steps < max_steps)
+    {
+        //get next state, then the next action from it
+        step_result step = env.step(current_state, action);
+        char next_action = policy.chooseAction(epsilon, env.mask(step.next_state), rowView(Q, step.next_state, scratch));
+
+        //TD update of every pair with a trace
+        float td_target = step.reward + params.discount_factor * Q[step.next_state][(int)next_action];
+        float td_error = td_target - Q[current_state][(int)action];
+        traces.visit(current_state, action);
+        traces.update(Q, td_error * params.alpha, params.discount_factor * lambda);
+
+        if (trace)
+        {
+            trace->record(result.steps, current_state, action, step.reward, step.next_state, td_error, step.done);
+        }
+
+        result.steps++;
+        result.reward = step.reward;
+        result.episode_return += step.reward;
+        if (step.done)
+        {
+            break;
+        }
+        result.time_step++;
+        current_state = step.next_state;
+        action = next_action;
+    }
+    return result;
+}
+
+/**
+	Run one Watkins' Q(lambda) episode from start: qLearningEpisode with every TD error applied through
+	traces. The traces are cut when the next action is exploratory, since the greedy return they stand for no
+	longer follows from there. The next state is valued over its legal actions only, so an illegal action
+	holding the row maximum neither raises the target nor cuts the traces. Every transition is written to
+	trace if there is one
+*/
+template <class Env, class Table, class Policy>
+episode_result qLambdaEpisode(Env &env, Table &Q, Policy &policy, eligibility_traces &traces, state_t start,
+                              float epsilon, const td_parameters &params, float lambda,
+                              unsigned int max_steps = UINT_MAX, trace_writer *trace = NULL)
+{
+    episode_result result = {0, 0, 0, 0.0f};
+    state_t current_state = start;
+    float scratch[MAX_ACTIONS];
+    char action = policy.chooseAction(epsilon, env.mask(current_state), rowView(Q, current_state, scratch));
+    traces.clear();
+
+    while (result.steps < max_steps)
+    {
+        //take action, then choose the next one before Q changes
+        step_result step = env.step(current_state, action);
+        action_mask_t next_actions = env.mask(step.next_state);
+        q_row_view next_row = rowView(Q, step.next_state, scratch);
+        char next_action = policy.chooseAction(epsilon, next_actions, next_row);
+        float best = next_row[greedyAction(next_actions, next_row)];
+        bool greedy = next_row[next_action] == best;
+
+        //TD update of every pair with a trace
+        float td_target = step.reward + params.discount_factor * best;
+        float td_error = td_target - Q[current_state][(int)action];
+        traces.visit(current_state, action);
+        traces.update(Q, td_error * params.alpha, greedy ? params.discount_factor * lambda : 0.0f);
+
+        if (trace)
+        {
+            trace->record(result.steps, current_state, action, step.reward, step.next_state, td_error, step.done);
+        }
+
+        result.steps++;
+        result.reward = step.reward;
+        result.episode_return += step.reward;
+        if (step.done)
+        {
+            break;
+        }
+        result.time_step++;
+        current_state = step.next_state;
+        action = next_action;
+    }
+    return result;
+}
+
+#endif // ELIGIBILITY_TRACES_H
@@ -3,7 +3,7 @@
 	@author Alex Cornelio
 */
 
-#include "environment.h"
+#include "environment.hpp"
 
 environment::environment()
 {
@@ -14,22 +14,10 @@ environment::~environment()
 
 }
 
-std::vector<bool> environment::availableActions(char s)
-{
-
-}
-
-char environment::takeAction(char action, char current_state)
-{
-
-}
-
-char environment::nextState(char action, char current_state,std::vector<bool> availiable_actions)
-{
-
-}
-
-signed short int environment::getReward(char next_state)
+/**
+	Seed the environment's random engine
+*/
+void environment::seed(uint64_t seed_value, uint64_t stream)
 {
-
+    rng.seed(seed_value, stream);
 }
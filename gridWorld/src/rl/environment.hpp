@@ -6,7 +6,10 @@
 #ifndef ENVIRONMENT_H
 #define ENVIRONMENT_H
 
-#include <vector>
+#include "action_selection.hpp"
+
+// state number. Wide enough for grids far bigger than the 4x3 world
+typedef int state_t;
 
 
 /**
@@ -17,12 +20,16 @@ class environment
 public:
 
     environment();  
-    ~environment();
+    virtual ~environment();
+
+    // random engine for noisy transitions, separate from the agent's
+    random_engine rng;
+    void seed(uint64_t seed_value, uint64_t stream = 0);
 
-    virtual std::vector<bool> available_actions(char s) = 0;
-    virtual char take_action(char action, char current_state) = 0;
-    virtual char next_state(char action, char current_state, std::vector<bool> availiable_actions) = 0;
-    virtual signed short int get_reward(char next_state) = 0;
+    virtual action_mask_t availableActions(state_t s) = 0;
+    virtual state_t takeAction(char action, state_t current_state) = 0;
+    virtual state_t nextState(char action, state_t current_state, action_mask_t available_actions) = 0;
+    virtual signed short int getReward(state_t next_state) = 0;
 
 
 };
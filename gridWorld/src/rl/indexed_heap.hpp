@@ -0,0 +1,163 @@
+/**
+	Indexed binary max heap of keys 0 .. capacity - 1 with float priorities.
+	Every key is in the heap at most once and its position is kept in an index, so the priority of a queued
+	key can be raised or lowered in place (O(log n) sift up or down) and a key can be removed from the middle
+	of the heap, instead of pushing duplicates and skipping stale entries when they come out.
+	@author Alex Cornelio
+*/
+
+#ifndef INDEXED_HEAP_H
+#define INDEXED_HEAP_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+class indexed_heap
+{
+public:
+    explicit indexed_heap(std::size_t capacity)
+        :priority_(capacity, 0.0f),
+         position_(capacity, ABSENT)
+    {
+    }
+
+    bool empty() const { return heap_.empty(); }
+    std::size_t size() const { return heap_.size(); }
+    bool contains(uint32_t key) const { return position_[key] != ABSENT; }
+    float priority(uint32_t key) const { return priority_[key]; }
+    uint32_t top() const { return heap_[0]; }
+    float topPriority() const { return priority_[heap_[0]]; }
+
+    void set(uint32_t key, float priority);
+    uint32_t pop();
+    void erase(uint32_t key);
+    void clear();
+
+private:
+    static constexpr uint32_t ABSENT = 0xffffffff;
+
+    std::vector<uint32_t> heap_;
+    std::vector<float> priority_;
+    std::vector<uint32_t> position_;
+
+    void place(uint32_t key, std::size_t i) { heap_[i] = key; position_[key] = (uint32_t)i; }
+    void siftUp(std::size_t i);
+    void siftDown(std::size_t i);
+};
+
+/**
+	Queue key with priority, or move it to priority if it is queued already. Works both ways: raising
+	sifts the key up, lowering sifts it down
+*/
+inline void indexed_heap::set(uint32_t key, float priority)
+{
+    if (!contains(key))
+    {
+        priority_[key] = priority;
+        heap_.push_back(key);
+        position_[key] = (uint32_t)(heap_.size() - 1);
+        siftUp(heap_.size() - 1);
+        return;
+    }
+    float previous = priority_[key];
+    priority_[key] = priority;
+    if (priority > previous)
+    {
+        siftUp(position_[key]);
+    }
+    else
+    {
+        siftDown(position_[key]);
+    }
+}
+
+/**
+	Remove the key with the highest priority and return it. The heap must not be empty
+*/
+inline uint32_t indexed_heap::pop()
+{
+    uint32_t key = heap_[0];
+    erase(key);
+    return key;
+}
+
+/**
+	Remove key from the heap if it is queued
+*/
+inline void indexed_heap::erase(uint32_t key)
+{
+    if (!contains(key))
+    {
+        return;
+    }
+    std::size_t i = position_[key];
+    uint32_t last = heap_.back();
+    heap_.pop_back();
+    position_[key] = ABSENT;
+    if (last == key)
+    {
+        return;
+    }
+    // the last key fills the hole and moves whichever way its priority says
+    place(last, i);
+    siftUp(i);
+    siftDown(position_[last]);
+}
+
+/**
+	Remove every key
+*/
+inline void indexed_heap::clear()
+{
+    for (std::size_t i = 0; i < heap_.size(); i++)
+    {
+        position_[heap_[i]] = ABSENT;
+    }
+    heap_.clear();
+}
+
+/**
+	Move the key at i up until its parent has a priority at least as high
+*/
+inline void indexed_heap::siftUp(std::size_t i)
+{
+    uint32_t key = heap_[i];
+    while (i > 0)
+    {
+        std::size_t parent = (i - 1) / 2;
+        if (priority_[heap_[parent]] >= priority_[key])
+        {
+            break;
+        }
+        place(heap_[parent], i);
+        i = parent;
+    }
+    place(key, i);
+}
+
+/**
+	Move the key at i down until both children have a priority no higher
+*/
+inline void indexed_heap::siftDown(std::size_t i)
+{
+    uint32_t key = heap_[i];
+    std::size_t n = heap_.size();
+    while (2 * i + 1 < n)
+    {
+        std::size_t child = 2 * i + 1;
+        if (child + 1 < n && priority_[heap_[child + 1]] > priority_[heap_[child]])
+        {
+            child++;
+        }
+        if (priority_[heap_[child]] <= priority_[key])
+        {
+            break;
+        }
+        place(heap_[child], i);
+        i = child;
+    }
+    place(key, i);
+}
+
+#endif // INDEXED_HEAP_H
@@ -0,0 +1,194 @@
+/**
+	Metrics sink class methods and the reader of its files
+	@author Alex Cornelio
+*/
+
+#include <algorithm>
+#include <string.h>
+
+#include "metrics.hpp"
+
+/**
+	Start of every chunk, its records follow
+*/
+struct metrics_chunk
+{
+    uint32_t records;
+    uint32_t reserved;
+};
+
+metrics_sink::metrics_sink(std::size_t chunk_records, unsigned int sample_every)
+    :file_(NULL),
+     chunk_records_(chunk_records > 0 ? chunk_records : 1),
+     sample_every_(sample_every > 0 ? sample_every : 1),
+     written_(0),
+     failed_(false)
+{
+    buffer_.reserve(chunk_records_);
+}
+
+/**
+	Destructor. Writes what is still buffered
+*/
+metrics_sink::~metrics_sink()
+{
+    close();
+}
+
+/**
+	Start a new file at path, closing the one before. Returns false if it cannot be created
+*/
+bool metrics_sink::open(const std::string &path)
+{
+    close();
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_)
+    {
+        return false;
+    }
+    metrics_header header;
+    memcpy(header.magic, METRICS_MAGIC, sizeof(header.magic));
+    header.record_bytes = sizeof(metrics_record);
+    header.sample_every = sample_every_;
+    written_ = 0;
+    failed_ = fwrite(&header, sizeof(header), 1, file_) != 1;
+    return !failed_;
+}
+
+/**
+	Go on with the file at path after a checkpoint taken once episodes episodes had ended. Its records of
+	earlier episodes are kept. Later ones were written by the interrupted run after its last checkpoint and
+	are dropped, the resumed run writes them again. Starts a new file if there is none. Returns false, leaving
+	the file alone, if it is not a metrics file sampled as this sink samples, or cannot be written
+*/
+bool metrics_sink::resume(const std::string &path, uint32_t episodes)
+{
+    std::vector<metrics_record> kept;
+    FILE *existing = fopen(path.c_str(), "rb");
+    if (existing)
+    {
+        fclose(existing);
+        unsigned int sample_every;
+        if (!readMetrics(path, kept, &sample_every) || sample_every != sample_every_)
+        {
+            return false;
+        }
+        kept.erase(std::remove_if(kept.begin(), kept.end(),
+                                  [episodes](const metrics_record &r) { return r.episode >= episodes; }),
+                   kept.end());
+    }
+    if (!open(path))
+    {
+        return false;
+    }
+    append(kept.data(), kept.size());
+    return flush();
+}
+
+/**
+	Write what is buffered and close the file. Returns false if anything written to it was lost
+*/
+bool metrics_sink::close()
+{
+    if (!file_)
+    {
+        return !failed_;
+    }
+    writeChunk();
+    failed_ = fclose(file_) != 0 || failed_;
+    file_ = NULL;
+    return !failed_;
+}
+
+/**
+	Keep a run of records at once, e.g. a whole trial gathered by a worker thread. Sampled as record does
+*/
+void metrics_sink::append(const metrics_record *records, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        record(records[i]);
+    }
+}
+
+/**
+	Write what is buffered as a chunk and push it to the operating system
+*/
+bool metrics_sink::flush()
+{
+    writeChunk();
+    if (file_ && fflush(file_) != 0)
+    {
+        failed_ = true;
+    }
+    return !failed_;
+}
+
+/**
+	Write the buffer as one chunk. Without a file the records are dropped
+*/
+void metrics_sink::writeChunk()
+{
+    if (buffer_.empty())
+    {
+        return;
+    }
+    if (file_)
+    {
+        metrics_chunk chunk = {(uint32_t)buffer_.size(), 0};
+        bool ok = fwrite(&chunk, sizeof(chunk), 1, file_) == 1 &&
+                  fwrite(buffer_.data(), sizeof(metrics_record), buffer_.size(), file_) == buffer_.size();
+        failed_ = failed_ || !ok;
+        written_ += ok ? buffer_.size() : 0;
+    }
+    buffer_.clear();
+}
+
+/**
+	Append the records of the metrics file at path to records, and set sample_every to the sampling it was
+	written with. A last chunk cut short is left out. Returns false if the file cannot be read or was not
+	written by a metrics_sink with this record layout
+*/
+bool readMetrics(const std::string &path, std::vector<metrics_record> &records, unsigned int *sample_every)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    metrics_header header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, METRICS_MAGIC, sizeof(header.magic)) != 0 ||
+        header.record_bytes != sizeof(metrics_record))
+    {
+        fclose(file);
+        return false;
+    }
+    if (sample_every)
+    {
+        *sample_every = header.sample_every;
+    }
+
+    metrics_chunk chunk;
+    while (fread(&chunk, sizeof(chunk), 1, file) == 1)
+    {
+        // a damaged count must not allocate more than the file holds
+        if ((uint64_t)chunk.records * sizeof(metrics_record) > (uint64_t)(size - ftell(file)))
+        {
+            break;
+        }
+        std::size_t start = records.size();
+        records.resize(start + chunk.records);
+        std::size_t got = fread(&records[start], sizeof(metrics_record), chunk.records, file);
+        if (got != chunk.records)
+        {
+            records.resize(start);
+            break;
+        }
+    }
+    fclose(file);
+    return true;
+}
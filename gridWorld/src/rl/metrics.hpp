@@ -0,0 +1,92 @@
+/**
+	Metrics sink class declaration.
+	Per episode statistics of a training run as fixed size binary records, instead of a formatted line per
+	episode: a record is copied into a buffer and the buffer goes to the file as one chunk once it holds
+	chunk_records of them, so a run of millions of episodes costs one write per chunk and no formatting.
+	With sample_every above 1 only every sample_every-th episode is kept. Each chunk starts with its record
+	count, so a file cut short by a crash reads back up to its last whole chunk. readMetrics loads a file
+	back, metricsToCsv turns one into the CSV of sarsaGridWorld and gridWorld/metrics.py loads it in python.
+	Values are stored in host byte order.
+	@author Alex Cornelio
+*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#define METRICS_MAGIC "RLMETR01"
+
+/**
+	One episode. group and run tell runs written to the same file apart, e.g. grid point and trial of a sweep
+*/
+struct metrics_record
+{
+    uint32_t group;
+    uint32_t run;
+    uint32_t episode;
+    uint32_t steps;
+    uint32_t wins;
+    uint32_t loses;
+    float epsilon;
+    float episode_return;
+};
+
+/**
+	Header at the start of a metrics file
+*/
+struct metrics_header
+{
+    char magic[8];
+    uint32_t record_bytes;  // sizeof(metrics_record), for readers of other versions
+    uint32_t sample_every;
+};
+
+class metrics_sink
+{
+public:
+    metrics_sink(std::size_t chunk_records = 4096, unsigned int sample_every = 1);
+    ~metrics_sink();
+
+    bool open(const std::string &path);
+    bool resume(const std::string &path, uint32_t episodes);
+    bool close();
+
+    // kept if the episode is sampled
+    void record(const metrics_record &r)
+    {
+        if (r.episode % sample_every_ == 0)
+        {
+            buffer_.push_back(r);
+            if (buffer_.size() >= chunk_records_)
+            {
+                writeChunk();
+            }
+        }
+    }
+    void append(const metrics_record *records, std::size_t count);
+    bool flush();
+
+    bool isOpen() const { return file_ != NULL; }
+    bool failed() const { return failed_; }
+    unsigned int sampleEvery() const { return sample_every_; }
+    uint64_t written() const { return written_; }
+
+private:
+    FILE *file_;
+    std::size_t chunk_records_;
+    unsigned int sample_every_;
+    std::vector<metrics_record> buffer_;
+    uint64_t written_;
+    bool failed_;
+
+    void writeChunk();
+};
+
+bool readMetrics(const std::string &path, std::vector<metrics_record> &records, unsigned int *sample_every = NULL);
+
+#endif // METRICS_H
@@ -0,0 +1,280 @@
+/**
+	Planner class methods.
+	Both planners are built on one Bellman sweep. The states are cut into blocks of PLANNER_BLOCK_STATES and the
+	blocks are swept in parallel on a thread pool. Inside a block the sweep is Gauss-Seidel: states reached in
+	the same block use the values already updated this sweep, states in other blocks use last sweep's values.
+	So no block reads what another block is writing and the result does not depend on the thread count.
+	@author Alex Cornelio
+*/
+
+#include <algorithm>
+#include <limits>
+
+#include "planner.hpp"
+#include "thread_pool.hpp"
+
+planner::planner(unsigned int states, unsigned int actions)
+    :states_(states),
+     actions_(actions),
+     reward_(states, 0),
+     terminal_(states, 0),
+     available_actions_(states, allActions(actions)),
+     offset_(1, 0),
+     q_(states * actions, 0),
+     value_(states, 0),
+     previous_value_(states, 0),
+     policy_(states, 0),
+     residual_(0)
+{
+}
+
+planner::~planner()
+{
+
+}
+
+/**
+	Set the reward for arriving in state s
+*/
+void planner::setReward(state_t s, float reward)
+{
+    reward_[s] = reward;
+}
+
+/**
+	Mark s as a state that ends the episode. Its value is zero
+*/
+void planner::setTerminal(state_t s, bool terminal)
+{
+    terminal_[s] = terminal;
+}
+
+/**
+	Set the actions available in state s
+*/
+void planner::setAvailableActions(state_t s, action_mask_t available_actions)
+{
+    available_actions_[s] = available_actions;
+}
+
+/**
+	Add the probability of reaching next_state when action is taken in s
+*/
+void planner::addTransition(state_t s, char action, state_t next_state, float probability)
+{
+    closeRows(s * actions_ + action);
+    next_.push_back(next_state);
+    probability_.push_back(probability);
+    offset_.back() = next_.size();
+}
+
+/**
+	Start rows up to and including row, every row before it is complete
+*/
+void planner::closeRows(unsigned int row)
+{
+    while (offset_.size() <= row + 1)
+    {
+        offset_.push_back(next_.size());
+    }
+}
+
+/**
+	Expected reward plus discounted value of taking action in s
+*/
+float planner::backup(state_t s, char action, float discount_factor, state_t begin, state_t end) const
+{
+    unsigned int row = s * actions_ + action;
+    float q = 0;
+    for (unsigned int k = offset_[row]; k < offset_[row + 1]; k++)
+    {
+        state_t next_state = next_[k];
+        float next_value = (next_state >= begin && next_state < end) ? value_[next_state] : previous_value_[next_state];
+        q += probability_[k] * (reward_[next_state] + discount_factor * (terminal_[next_state] ? 0 : next_value));
+    }
+    return q;
+}
+
+/**
+	Sweep the states [begin, end) once and return the largest change of a state value
+*/
+float planner::sweepBlock(state_t begin, state_t end, float discount_factor, bool fixed_policy)
+{
+    float largest_change = 0;
+    for (state_t s = begin; s < end; s++)
+    {
+        if (terminal_[s])
+        {
+            continue;
+        }
+        float best;
+        if (fixed_policy)
+        {
+            best = backup(s, policy_[s], discount_factor, begin, end);
+            q_[s * actions_ + policy_[s]] = best;
+        }
+        else
+        {
+            best = std::numeric_limits<float>::lowest();
+            for (unsigned int a = 0; a < actions_; a++)
+            {
+                if ((available_actions_[s] >> a) & 1)
+                {
+                    float q = backup(s, (char)a, discount_factor, begin, end);
+                    q_[s * actions_ + a] = q;
+                    best = std::max(best, q);
+                }
+            }
+        }
+        float change = best - previous_value_[s];
+        change = change < 0 ? -change : change;
+        largest_change = std::max(largest_change, change);
+        value_[s] = best;
+    }
+    return largest_change;
+}
+
+/**
+	One Bellman sweep over all states, one task per block on the pool, or in this thread without one. Returns
+	the largest change of a state value
+*/
+float planner::sweep(float discount_factor, bool fixed_policy, thread_pool *pool)
+{
+    unsigned int blocks = (states_ + PLANNER_BLOCK_STATES - 1) / PLANNER_BLOCK_STATES;
+    std::vector<float> block_change(blocks, 0);
+
+    if (pool == NULL)
+    {
+        for (unsigned int b = 0; b < blocks; b++)
+        {
+            state_t begin = b * PLANNER_BLOCK_STATES;
+            block_change[b] = sweepBlock(begin, std::min(begin + PLANNER_BLOCK_STATES, (state_t)states_), discount_factor, fixed_policy);
+        }
+    }
+    else
+    {
+        for (unsigned int b = 0; b < blocks; b++)
+        {
+            pool->submit([this, b, discount_factor, fixed_policy, &block_change] {
+                state_t begin = b * PLANNER_BLOCK_STATES;
+                block_change[b] = sweepBlock(begin, std::min(begin + PLANNER_BLOCK_STATES, (state_t)states_), discount_factor, fixed_policy);
+            });
+        }
+        pool->wait();
+    }
+
+    previous_value_ = value_;
+    return *std::max_element(block_change.begin(), block_change.end());
+}
+
+/**
+	Return a pool for threads workers, or none when the sweeps should run in the calling thread
+*/
+thread_pool *planner::makePool(unsigned int threads) const
+{
+    if (threads == 0)
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads <= 1 || states_ <= PLANNER_BLOCK_STATES)
+    {
+        return NULL;
+    }
+    return new thread_pool(threads);
+}
+
+/**
+	Run value iteration until no state value changes by more than tolerance in a sweep. Returns the number of
+	sweeps
+*/
+unsigned int planner::valueIteration(float discount_factor, float tolerance, unsigned int threads, unsigned int max_sweeps)
+{
+    if (states_ == 0)
+    {
+        return 0;
+    }
+    closeRows(states_ * actions_ - 1);
+    thread_pool *pool = makePool(threads);
+    unsigned int sweeps = iterate(discount_factor, tolerance, pool, max_sweeps);
+    delete pool;
+    return sweeps;
+}
+
+/**
+	Value iteration sweeps on a pool
+*/
+unsigned int planner::iterate(float discount_factor, float tolerance, thread_pool *pool, unsigned int max_sweeps)
+{
+    unsigned int sweeps = 0;
+    do
+    {
+        residual_ = sweep(discount_factor, false, pool);
+        sweeps++;
+    } while (residual_ > tolerance && sweeps < max_sweeps);
+    return sweeps;
+}
+
+/**
+	Make the policy greedy in Q. A state keeps its action unless another is better by more than tolerance.
+	Returns true when the policy did not change
+*/
+bool planner::improvePolicy(float tolerance)
+{
+    bool stable = true;
+    for (state_t s = 0; s < (state_t)states_; s++)
+    {
+        if (terminal_[s])
+        {
+            continue;
+        }
+        unsigned char best = policy_[s];
+        for (unsigned int a = 0; a < actions_; a++)
+        {
+            if (((available_actions_[s] >> a) & 1) && q_[s * actions_ + a] > q_[s * actions_ + best] + tolerance)
+            {
+                best = (unsigned char)a;
+            }
+        }
+        stable = stable && best == policy_[s];
+        policy_[s] = best;
+    }
+    return stable;
+}
+
+/**
+	Run policy iteration: evaluate the policy to within tolerance, make it greedy, repeat until it is stable.
+	Returns the number of improvement steps
+*/
+unsigned int planner::policyIteration(float discount_factor, float tolerance, unsigned int threads, unsigned int max_iterations)
+{
+    if (states_ == 0)
+    {
+        return 0;
+    }
+    closeRows(states_ * actions_ - 1);
+    thread_pool *pool = makePool(threads);
+
+    // start from the first available action everywhere
+    for (state_t s = 0; s < (state_t)states_; s++)
+    {
+        policy_[s] = available_actions_[s] ? __builtin_ctz(available_actions_[s]) : 0;
+    }
+
+    unsigned int iterations = 0;
+    bool stable = false;
+    while (!stable && iterations < max_iterations)
+    {
+        while (sweep(discount_factor, true, pool) > tolerance)
+        {
+        }
+        // Q of every action under the evaluated values
+        sweep(discount_factor, false, pool);
+        stable = improvePolicy(tolerance);
+        iterations++;
+    }
+
+    // settle Q* and the values on the final policy
+    iterate(discount_factor, tolerance, pool, 100000);
+    delete pool;
+    return iterations;
+}
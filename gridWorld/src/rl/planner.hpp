@@ -0,0 +1,169 @@
+/**
+	Planner class declaration.
+	Computes the optimal action values Q* of an environment from its model (transition probabilities, rewards
+	and terminal states) by value iteration or policy iteration. Used as the ground truth the learners are
+	measured against.
+	@author Alex Cornelio
+*/
+
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <vector>
+
+#include "action_selection.hpp"
+#include "environment.hpp"
+
+class thread_pool;
+
+// states per block of a sweep. One block is one task and its values stay in cache while it is swept
+#define PLANNER_BLOCK_STATES 2048
+
+class planner
+{
+public:
+    planner(unsigned int states, unsigned int actions);
+    ~planner();
+
+    // model. Transitions must be added in order of state, then action
+    void setReward(state_t s, float reward);
+    void setTerminal(state_t s, bool terminal);
+    void setAvailableActions(state_t s, action_mask_t available_actions);
+    void addTransition(state_t s, char action, state_t next_state, float probability);
+
+    unsigned int valueIteration(float discount_factor, float tolerance, unsigned int threads = 0,
+                                unsigned int max_sweeps = 100000);
+    unsigned int policyIteration(float discount_factor, float tolerance, unsigned int threads = 0,
+                                 unsigned int max_iterations = 1000);
+
+    unsigned int states() const { return states_; }
+    unsigned int actions() const { return actions_; }
+    float q(state_t s, char action) const { return q_[s * actions_ + action]; }
+    float value(state_t s) const { return value_[s]; }
+    bool isTerminal(state_t s) const { return terminal_[s]; }
+    action_mask_t availableActions(state_t s) const { return available_actions_[s]; }
+    float residual() const { return residual_; }
+
+    template <class Table>
+    float distance(Table &Q) const;
+    template <class Table>
+    float policyAgreement(Table &Q) const;
+
+private:
+    unsigned int states_;
+    unsigned int actions_;
+
+    std::vector<float> reward_;
+    std::vector<unsigned char> terminal_;
+    std::vector<action_mask_t> available_actions_;
+
+    // transitions of (s, a) are next_[offset_[s*actions+a] .. offset_[s*actions+a+1])
+    std::vector<unsigned int> offset_;
+    std::vector<state_t> next_;
+    std::vector<float> probability_;
+
+    std::vector<float> q_;
+    std::vector<float> value_;
+    std::vector<float> previous_value_;
+    std::vector<unsigned char> policy_;
+    float residual_;
+
+    void closeRows(unsigned int row);
+    float backup(state_t s, char action, float discount_factor, state_t begin, state_t end) const;
+    float sweepBlock(state_t begin, state_t end, float discount_factor, bool fixed_policy);
+    float sweep(float discount_factor, bool fixed_policy, thread_pool *pool);
+    unsigned int iterate(float discount_factor, float tolerance, thread_pool *pool, unsigned int max_sweeps);
+    thread_pool *makePool(unsigned int threads) const;
+    bool improvePolicy(float tolerance);
+};
+
+/**
+	Largest difference between Q and Q* over the available actions of every non terminal state
+*/
+template <class Table>
+float planner::distance(Table &Q) const
+{
+    float worst = 0;
+    for (state_t s = 0; s < (state_t)states_; s++)
+    {
+        if (terminal_[s])
+        {
+            continue;
+        }
+        for (unsigned int a = 0; a < actions_; a++)
+        {
+            if ((available_actions_[s] >> a) & 1)
+            {
+                float error = Q[s][a] - q_[s * actions_ + a];
+                error = error < 0 ? -error : error;
+                worst = error > worst ? error : worst;
+            }
+        }
+    }
+    return worst;
+}
+
+/**
+	Fraction of non terminal states where the greedy action of Q is optimal. An action is optimal when its Q*
+	is within the planner's residual of the state's value
+*/
+template <class Table>
+float planner::policyAgreement(Table &Q) const
+{
+    unsigned int agree = 0, total = 0;
+    for (state_t s = 0; s < (state_t)states_; s++)
+    {
+        if (terminal_[s])
+        {
+            continue;
+        }
+        int greedy = -1;
+        for (unsigned int a = 0; a < actions_; a++)
+        {
+            if (((available_actions_[s] >> a) & 1) && (greedy < 0 || Q[s][a] > Q[s][greedy]))
+            {
+                greedy = (int)a;
+            }
+        }
+        total++;
+        agree += q_[s * actions_ + greedy] >= value_[s] - residual_;
+    }
+    return total > 0 ? (float)agree / total : 1.0f;
+}
+
+/**
+	Fill the planner with the model of an environment with a static interface (static_environment.hpp) that
+	also exposes its noisy transitions through outcomeProbabilities, like gridWorld: the outcome k of an
+	action is takeAction(k, s)
+*/
+template <class Env>
+void buildModel(planner &plan, Env &env)
+{
+    for (state_t s = 0; s < (state_t)plan.states(); s++)
+    {
+        plan.setReward(s, env.rewardOf(s));
+        plan.setTerminal(s, env.isTerminal(s));
+        plan.setAvailableActions(s, env.actionMask(s));
+    }
+    for (state_t s = 0; s < (state_t)plan.states(); s++)
+    {
+        action_mask_t available_actions = env.actionMask(s);
+        for (unsigned int a = 0; a < plan.actions(); a++)
+        {
+            if (!((available_actions >> a) & 1))
+            {
+                continue;
+            }
+            const float *outcome = env.outcomeProbabilities(s, (char)a);
+            for (unsigned int k = 0; k < plan.actions(); k++)
+            {
+                if (outcome[k] > 0)
+                {
+                    plan.addTransition(s, (char)a, env.takeAction((char)k, s), outcome[k]);
+                }
+            }
+        }
+    }
+}
+
+#endif // PLANNER_H
@@ -0,0 +1,64 @@
+/**
+	Prioritized sweeping class methods. The model is kept here, the backups are templated on the Q table and
+	live in the header
+	@author Alex Cornelio
+*/
+
+#include "prioritized_sweeping.hpp"
+
+prioritized_sweeping::prioritized_sweeping(unsigned int states, unsigned int actions, float threshold)
+    :states_(states),
+     actions_(actions),
+     threshold_(threshold),
+     model_(states * actions),
+     visits_(states * actions, 0),
+     predecessors_(states),
+     queue_(states * actions)
+{
+}
+
+prioritized_sweeping::~prioritized_sweeping()
+{
+
+}
+
+/**
+	Add a real transition to the model: action in s led to next_state, where next_actions are legal, and
+	paid reward, and the episode ended there if done. The first time a pair reaches a state it becomes one of that state's predecessors
+*/
+void prioritized_sweeping::observe(state_t s, char action, state_t next_state, action_mask_t next_actions, float reward,
+                                   bool done)
+{
+    unsigned int pair = s * actions_ + action;
+    visits_[pair]++;
+    std::vector<outcome> &outcomes = model_[pair];
+    for (size_t k = 0; k < outcomes.size(); k++)
+    {
+        if (outcomes[k].next_state == next_state)
+        {
+            outcomes[k].count++;
+            outcomes[k].reward_sum += reward;
+            return;
+        }
+    }
+    outcome o = {next_state, next_actions, 1, reward, done};
+    outcomes.push_back(o);
+    predecessors_[next_state].push_back(pair);
+}
+
+/**
+	Forget the model and the queue
+*/
+void prioritized_sweeping::clear()
+{
+    for (size_t pair = 0; pair < model_.size(); pair++)
+    {
+        model_[pair].clear();
+        visits_[pair] = 0;
+    }
+    for (size_t s = 0; s < predecessors_.size(); s++)
+    {
+        predecessors_[s].clear();
+    }
+    queue_.clear();
+}
@@ -0,0 +1,200 @@
+/**
+	Prioritized sweeping class declaration (Moore and Atkeson).
+	A model based learner for tabular environments. Every real transition goes into a model of counts: how
+	often each (state, action) pair was tried, where it led and what it paid. Q values are only changed by
+	full backups over that model, the expected reward plus the discounted value of every observed next state
+	weighted by how often it was seen, so noisy transitions are averaged instead of followed one at a time.
+	The pairs whose backup would change Q by more than a threshold wait in an indexed heap keyed by that
+	Bellman error. After every real step a bounded number of the largest are backed up, and every backup of a
+	state's action re-scores the pairs that lead into the state, found through a predecessor index. A pair
+	already queued is moved in place to its new error, up or down.
+	@author Alex Cornelio
+*/
+
+#ifndef PRIORITIZED_SWEEPING_H
+#define PRIORITIZED_SWEEPING_H
+
+#include <limits.h>
+#include <vector>
+
+#include "action_selection.hpp"
+#include "environment.hpp"
+#include "indexed_heap.hpp"
+#include "training.hpp"
+
+class prioritized_sweeping
+{
+public:
+    prioritized_sweeping(unsigned int states, unsigned int actions, float threshold = 1e-3f);
+    ~prioritized_sweeping();
+
+    void observe(state_t s, char action, state_t next_state, action_mask_t next_actions, float reward, bool done);
+    void clear();
+
+    template <class Table>
+    float target(Table &Q, state_t s, char action, float discount_factor) const;
+    template <class Table>
+    void prioritize(Table &Q, state_t s, char action, float discount_factor);
+    template <class Table>
+    unsigned int sweep(Table &Q, float discount_factor, unsigned int backups);
+
+    unsigned int queued() const { return (unsigned int)queue_.size(); }
+    unsigned int visits(state_t s, char action) const { return visits_[s * actions_ + action]; }
+
+private:
+    /**
+    	Where one pair led and what it paid there, over every time it did
+    */
+    struct outcome
+    {
+        state_t next_state;
+        action_mask_t next_actions;
+        unsigned int count;
+        float reward_sum;
+        bool done;
+    };
+
+    unsigned int states_;
+    unsigned int actions_;
+    float threshold_;
+
+    // model of every pair s * actions + a
+    std::vector<std::vector<outcome> > model_;
+    std::vector<unsigned int> visits_;
+    // pairs that have led into each state
+    std::vector<std::vector<unsigned int> > predecessors_;
+
+    indexed_heap queue_;
+
+    template <class Table>
+    static float value(Table &Q, state_t s, action_mask_t available_actions);
+};
+
+/**
+	Best Q value of s over its available actions
+*/
+template <class Table>
+inline float prioritized_sweeping::value(Table &Q, state_t s, action_mask_t available_actions)
+{
+    float best = 0;
+    bool first = true;
+    for (unsigned int a = 0; available_actions >> a; a++)
+    {
+        if (((available_actions >> a) & 1) && (first || Q[s][a] > best))
+        {
+            best = Q[s][a];
+            first = false;
+        }
+    }
+    return best;
+}
+
+/**
+	Expected backup of Q(s, action) over the model, the value Q(s, action) gets when it is swept. Q(s,
+	action) itself if the pair was never tried. Next states are valued over their legal actions only, as the
+	planner does, so the untouched values of illegal actions never count as the best
+*/
+template <class Table>
+float prioritized_sweeping::target(Table &Q, state_t s, char action, float discount_factor) const
+{
+    unsigned int pair = s * actions_ + action;
+    if (visits_[pair] == 0)
+    {
+        return Q[s][(int)action];
+    }
+    float sum = 0;
+    const std::vector<outcome> &outcomes = model_[pair];
+    for (size_t k = 0; k < outcomes.size(); k++)
+    {
+        const outcome &o = outcomes[k];
+        sum += o.reward_sum + (o.done ? 0.0f : o.count * discount_factor * value(Q, o.next_state, o.next_actions));
+    }
+    return sum / visits_[pair];
+}
+
+/**
+	Queue (s, action) by how far Q(s, action) is from its backup, or drop it from the queue when that is
+	below the threshold
+*/
+template <class Table>
+void prioritized_sweeping::prioritize(Table &Q, state_t s, char action, float discount_factor)
+{
+    float error = target(Q, s, action, discount_factor) - Q[s][(int)action];
+    error = error < 0 ? -error : error;
+    unsigned int pair = s * actions_ + action;
+    if (error > threshold_)
+    {
+        queue_.set(pair, error);
+    }
+    else
+    {
+        queue_.erase(pair);
+    }
+}
+
+/**
+	Back up at most backups of the queued pairs, largest error first, and re-score the predecessors of every
+	state whose value changed. Returns the number of backups done
+*/
+template <class Table>
+unsigned int prioritized_sweeping::sweep(Table &Q, float discount_factor, unsigned int backups)
+{
+    unsigned int done = 0;
+    while (done < backups && !queue_.empty())
+    {
+        unsigned int pair = queue_.pop();
+        state_t s = pair / actions_;
+        char action = pair % actions_;
+        Q[s][(int)action] = target(Q, s, action, discount_factor);
+        done++;
+
+        const std::vector<unsigned int> &predecessors = predecessors_[s];
+        for (size_t k = 0; k < predecessors.size(); k++)
+        {
+            prioritize(Q, predecessors[k] / actions_, predecessors[k] % actions_, discount_factor);
+        }
+    }
+    return done;
+}
+
+/**
+	Run one prioritized sweeping episode from start: every real step goes into the model, the pair just
+	tried is re-scored and up to backups queued pairs are swept
+*/
+template <class Env, class Table, class Policy>
+episode_result prioritizedSweepingEpisode(Env &env, Table &Q, Policy &policy, prioritized_sweeping &sweeper,
+                                          state_t start, float epsilon, float discount_factor, unsigned int backups,
+                                          unsigned int max_steps = UINT_MAX)
+{
+    episode_result result = {0, 0, 0, 0.0f};
+    state_t current_state = start;
+    float scratch[MAX_ACTIONS];
+
+    while (result.steps < max_steps)
+    {
+        //choose action based on policy among the legal actions
+        action_mask_t available_actions = env.mask(current_state);
+        char action = policy.chooseAction(epsilon, available_actions, rowView(Q, current_state, scratch));
+
+        //take action to get next state and reward
+        step_result step = env.step(current_state, action);
+
+        //learn the model, then plan on it
+        sweeper.observe(current_state, action, step.next_state, env.mask(step.next_state), step.reward, step.done);
+        sweeper.prioritize(Q, current_state, action, discount_factor);
+        sweeper.sweep(Q, discount_factor, backups);
+
+        result.steps++;
+        result.reward = step.reward;
+        result.episode_return += step.reward;
+        if (step.done)
+        {
+            break;
+        }
+        result.time_step++;
+        current_state = step.next_state;
+    }
+    return result;
+}
+
+#endif // PRIORITIZED_SWEEPING_H
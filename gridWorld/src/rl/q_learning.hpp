@@ -11,13 +11,13 @@
 #include <stdlib.h>
 #include <cmath>
 
-class q_learning : public reinforcement_learning
+class q_learning final : public RL
 {
 public:
     q_learning();//float ep);
     ~q_learning();
 
-    char choose_action(float epsilon, std::vector<bool> available_actions, std::vector<float> state_row);
+    char chooseAction(float epsilon, action_mask_t available_actions, q_row_view state_row);
 
 
 };
@@ -0,0 +1,285 @@
+/**
+	QTable class declaration and methods.
+	Stores the Q matrix as one flat buffer instead of a vector of vectors. The buffer is aligned to a cache line
+	and every row is padded up to a whole number of SIMD registers, so a row never needs more than one pointer
+	to find and a row scan never splits a register. The dimensions are template parameters so the row stride
+	is a compile time constant. Environments whose size is only known at run time (e.g. a map loaded from a
+	file) use Q_TABLE_DYNAMIC_STATES as the state count and pass the number of rows to the constructor; the
+	stride stays a compile time constant.
+	@author Alex Cornelio
+*/
+
+#ifndef Q_TABLE_H
+#define Q_TABLE_H
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// alignment of the table and width of a SIMD register in bytes
+#define Q_TABLE_ALIGNMENT 64
+#if defined(__AVX__)
+#define Q_TABLE_SIMD_BYTES 32
+#else
+#define Q_TABLE_SIMD_BYTES 16
+#endif
+
+// state count of a table whose number of rows is given at run time
+#define Q_TABLE_DYNAMIC_STATES 0
+
+
+/**
+	Return the best value of a row of Actions values padded to Stride. The row must be aligned to a SIMD register
+	and its padding must hold the lowest value. Shared by every Q table layout
+*/
+template <std::size_t Actions, std::size_t Stride, typename T>
+inline T rowMax(const T *row)
+{
+#if defined(__SSE2__)
+    if constexpr (std::is_same<T, float>::value && Stride % 4 == 0)
+    {
+        // the padding holds the lowest float so it never wins
+        __m128 best = _mm_load_ps(row);
+        for (std::size_t a = 4; a < Stride; a += 4)
+        {
+            best = _mm_max_ps(best, _mm_load_ps(row + a));
+        }
+        best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(1, 0, 3, 2)));
+        best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(best);
+    }
+#endif
+    T best = row[0];
+    for (std::size_t a = 1; a < Actions; a++)
+    {
+        best = (best < row[a]) ? row[a] : best;
+    }
+    return best;
+}
+
+/**
+	Return the index of the best value of a row laid out as for rowMax. Ties go to the lowest index, same as
+	std::max_element
+*/
+template <std::size_t Actions, std::size_t Stride, typename T>
+inline std::size_t rowArgmax(const T *row)
+{
+#if defined(__SSE2__)
+    if constexpr (std::is_same<T, float>::value && Stride % 4 == 0 && Stride <= 64)
+    {
+        // compare the whole padded row against its maximum and take the first lane that matches.
+        // no early exit, a mispredicted branch costs more than the extra compares
+        const __m128 best_value = _mm_set1_ps(rowMax<Actions, Stride>(row));
+        unsigned long long matches = 0;
+        for (std::size_t a = 0; a < Stride; a += 4)
+        {
+            matches |= (unsigned long long)_mm_movemask_ps(_mm_cmpeq_ps(_mm_load_ps(row + a), best_value)) << a;
+        }
+        return __builtin_ctzll(matches);
+    }
+#endif
+    std::size_t best = 0;
+    for (std::size_t a = 1; a < Actions; a++)
+    {
+        if (row[best] < row[a])
+        {
+            best = a;
+        }
+    }
+    return best;
+}
+
+/**
+	States x Actions table of Q values. Q[s][a] works the same as it did with the vector of vectors.
+*/
+template <std::size_t States, std::size_t Actions, typename T = float>
+class QTable
+{
+public:
+    typedef T value_type;
+    static constexpr std::size_t STATES = States;
+    static constexpr std::size_t ACTIONS = Actions;
+    // number of values that fit in one SIMD register and the padded row length. Values narrower than a float
+    // (q_value.hpp) are padded like floats, so their rows take half the bytes rather than the same
+    static constexpr std::size_t VALUE_BYTES = sizeof(T) < sizeof(float) ? sizeof(float) : sizeof(T);
+    static constexpr std::size_t LANES = (Q_TABLE_SIMD_BYTES / VALUE_BYTES) > 0 ? (Q_TABLE_SIMD_BYTES / VALUE_BYTES) : 1;
+    static constexpr std::size_t STRIDE = ((Actions + LANES - 1) / LANES) * LANES;
+    static constexpr std::size_t SIZE = States * STRIDE;
+
+    QTable();
+    explicit QTable(T initial_value);
+    QTable(std::size_t states, T initial_value);
+    QTable(const QTable &other);
+    QTable &operator=(const QTable &other);
+    ~QTable();
+
+    T *operator[](std::size_t s) { return data_ + s * STRIDE; }
+    const T *operator[](std::size_t s) const { return data_ + s * STRIDE; }
+
+    T *data() { return data_; }
+    const T *data() const { return data_; }
+    std::size_t states() const { return States != Q_TABLE_DYNAMIC_STATES ? States : states_; }
+    std::size_t size() const { return states() * STRIDE; }
+    constexpr std::size_t actions() const { return Actions; }
+    constexpr std::size_t stride() const { return STRIDE; }
+
+    void fill(T value);
+    std::size_t argmax(std::size_t s) const;
+    T max(std::size_t s) const;
+
+private:
+    T *data_;
+    std::size_t states_;
+
+    void allocate();
+    void release();
+};
+
+/**
+	Constructor. All Q values start at zero
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+QTable<States, Actions, T>::QTable()
+    :states_(States)
+{
+    allocate();
+    fill(T(0));
+}
+
+/**
+	Constructor. All Q values start at initial_value
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+QTable<States, Actions, T>::QTable(T initial_value)
+    :states_(States)
+{
+    allocate();
+    fill(initial_value);
+}
+
+/**
+	Constructor for a table with states rows, all Q values start at initial_value
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+QTable<States, Actions, T>::QTable(std::size_t states, T initial_value)
+    :states_(states)
+{
+    static_assert(States == Q_TABLE_DYNAMIC_STATES, "the number of rows is already fixed by the template");
+    allocate();
+    fill(initial_value);
+}
+
+/**
+	Copy constructor
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+QTable<States, Actions, T>::QTable(const QTable &other)
+    :states_(other.states_)
+{
+    allocate();
+    for (std::size_t i = 0; i < size(); i++)
+    {
+        data_[i] = other.data_[i];
+    }
+}
+
+/**
+	Copy assignment
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+QTable<States, Actions, T> &QTable<States, Actions, T>::operator=(const QTable &other)
+{
+    if (other.states_ != states_)
+    {
+        release();
+        states_ = other.states_;
+        allocate();
+    }
+    for (std::size_t i = 0; i < size(); i++)
+    {
+        data_[i] = other.data_[i];
+    }
+    return *this;
+}
+
+/**
+	Destructor
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+QTable<States, Actions, T>::~QTable()
+{
+    release();
+}
+
+/**
+	Get one aligned block for the whole table and construct every element in it
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+void QTable<States, Actions, T>::allocate()
+{
+    void *raw = ::operator new[](size() * sizeof(T), std::align_val_t(Q_TABLE_ALIGNMENT));
+    data_ = static_cast<T *>(raw);
+    for (std::size_t i = 0; i < size(); i++)
+    {
+        new (data_ + i) T();
+    }
+}
+
+/**
+	Destroy every element and give the block back
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+void QTable<States, Actions, T>::release()
+{
+    for (std::size_t i = 0; i < size(); i++)
+    {
+        data_[i].~T();
+    }
+    ::operator delete[](data_, std::align_val_t(Q_TABLE_ALIGNMENT));
+}
+
+/**
+	Set every Q value. The padding at the end of each row is set to the lowest value so a scan over the
+	full stride can never pick it as a maximum.
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+void QTable<States, Actions, T>::fill(T value)
+{
+    for (std::size_t s = 0; s < states(); s++)
+    {
+        T *row = data_ + s * STRIDE;
+        for (std::size_t a = 0; a < Actions; a++)
+        {
+            row[a] = value;
+        }
+        for (std::size_t a = Actions; a < STRIDE; a++)
+        {
+            row[a] = std::numeric_limits<T>::lowest();
+        }
+    }
+}
+
+/**
+	Return the index of the best action in state s. Ties go to the lowest index, same as std::max_element
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+std::size_t QTable<States, Actions, T>::argmax(std::size_t s) const
+{
+    return rowArgmax<Actions, STRIDE>(data_ + s * STRIDE);
+}
+
+/**
+	Return the best Q value in state s
+*/
+template <std::size_t States, std::size_t Actions, typename T>
+T QTable<States, Actions, T>::max(std::size_t s) const
+{
+    return rowMax<Actions, STRIDE>(data_ + s * STRIDE);
+}
+
+#endif // Q_TABLE_H
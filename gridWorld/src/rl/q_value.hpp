@@ -0,0 +1,185 @@
+/**
+	16 bit storage types for Q values.
+	A QTable or SparseQTable of half_float or fixed16 holds every Q value in two bytes instead of four, which
+	halves the memory and bandwidth of a large table and the size of a table sent over the network. The types
+	only store: reading one gives a float and writing a float rounds it once, so every TD update is computed
+	in float and loses precision only where its result is stored.
+	The controllers pick the type at compile time with Q_STORAGE.
+	@author Alex Cornelio
+*/
+
+#ifndef Q_VALUE_H
+#define Q_VALUE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+#include <limits>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+// storage of the controllers' Q values, set with -DQ_STORAGE=..
+#define Q_STORAGE_FLOAT 0
+#define Q_STORAGE_HALF 1
+#define Q_STORAGE_FIXED16 2
+#ifndef Q_STORAGE
+#define Q_STORAGE Q_STORAGE_FLOAT
+#endif
+
+// fraction bits of fixed16 Q values. 4 bits hold -2048 to 2047.9375 in steps of 1/16
+#ifndef Q_FIXED16_FRACTION_BITS
+#define Q_FIXED16_FRACTION_BITS 4
+#endif
+
+/**
+	IEEE 754 binary16 value: 1 sign bit, 5 exponent bits, 10 mantissa bits, about 3 significant digits up to
+	65504. Converted with F16C when the target has it, otherwise in software with round to nearest even
+*/
+struct half_float
+{
+    uint16_t bits;
+
+    half_float() : bits(0) {}
+    half_float(float value) : bits(fromFloat(value)) {}
+
+    operator float() const { return toFloat(bits); }
+    half_float &operator+=(float value) { bits = fromFloat(toFloat(bits) + value); return *this; }
+    half_float &operator-=(float value) { bits = fromFloat(toFloat(bits) - value); return *this; }
+
+    static uint16_t fromFloat(float value);
+    static float toFloat(uint16_t bits);
+};
+
+/**
+	Return the binary16 value nearest to value, ties to even. Too large values become infinity
+*/
+inline uint16_t half_float::fromFloat(float value)
+{
+#if defined(__F16C__)
+    return _cvtss_sh(value, 0);
+#else
+    uint32_t x;
+    memcpy(&x, &value, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t magnitude = x & 0x7fffffff;
+
+    if (magnitude >= 0x7f800000)
+    {
+        // infinity stays infinity, NaN stays a quiet NaN
+        return sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0);
+    }
+    if (magnitude >= 0x477ff000)
+    {
+        // halfway past 65504 and above
+        return sign | 0x7c00;
+    }
+    if (magnitude < 0x38800000)
+    {
+        // below the smallest normal half, 2^-14: a subnormal in steps of 2^-24, or zero
+        if (magnitude < 0x33000000)
+        {
+            return sign;
+        }
+        uint32_t mantissa = (magnitude & 0x7fffff) | 0x800000;
+        uint32_t shift = 126 - (magnitude >> 23);
+        uint32_t result = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        result += rest > halfway || (rest == halfway && (result & 1));
+        return sign | result;
+    }
+    // normal: rebias the exponent from 127 to 15 and round the 13 dropped mantissa bits
+    uint32_t result = (magnitude >> 13) - (112 << 10);
+    uint32_t rest = magnitude & 0x1fff;
+    result += rest > 0x1000 || (rest == 0x1000 && (result & 1));
+    return sign | result;
+#endif
+}
+
+/**
+	Return the float of a binary16 value, exact
+*/
+inline float half_float::toFloat(uint16_t bits)
+{
+#if defined(__F16C__)
+    return _cvtsh_ss(bits);
+#else
+    uint32_t sign = (uint32_t)(bits & 0x8000) << 16;
+    uint32_t exponent = (bits >> 10) & 0x1f;
+    uint32_t mantissa = bits & 0x3ff;
+    uint32_t x;
+    if (exponent == 0)
+    {
+        float value = mantissa * (1.0f / 16777216.0f);
+        return sign ? -value : value;
+    }
+    else if (exponent == 31)
+    {
+        x = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else
+    {
+        x = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float value;
+    memcpy(&value, &x, sizeof(value));
+    return value;
+#endif
+}
+
+/**
+	Signed 16 bit fixed point value with FRACTION_BITS bits after the point. Values out of range saturate
+*/
+template <int FRACTION_BITS>
+struct fixed16
+{
+    int16_t raw;
+
+    fixed16() : raw(0) {}
+    fixed16(float value) : raw(fromFloat(value)) {}
+
+    operator float() const { return raw * (1.0f / (1 << FRACTION_BITS)); }
+    fixed16 &operator+=(float value) { raw = fromFloat((float)*this + value); return *this; }
+    fixed16 &operator-=(float value) { raw = fromFloat((float)*this - value); return *this; }
+
+    /**
+    	Return the raw value nearest to value
+    */
+    static int16_t fromFloat(float value)
+    {
+        float scaled = value * (1 << FRACTION_BITS);
+        scaled = scaled < -32768.0f ? -32768.0f : scaled;
+        scaled = scaled > 32767.0f ? 32767.0f : scaled;
+        return (int16_t)lrintf(scaled);
+    }
+};
+
+namespace std
+{
+// lowest values, QTable pads its rows with them so a row scan never picks the padding
+template <>
+struct numeric_limits<half_float> : numeric_limits<float>
+{
+    static half_float lowest() { half_float h; h.bits = 0xfbff; return h; }
+    static half_float max() { half_float h; h.bits = 0x7bff; return h; }
+};
+
+template <int FRACTION_BITS>
+struct numeric_limits<fixed16<FRACTION_BITS> > : numeric_limits<float>
+{
+    static fixed16<FRACTION_BITS> lowest() { fixed16<FRACTION_BITS> f; f.raw = -32768; return f; }
+    static fixed16<FRACTION_BITS> max() { fixed16<FRACTION_BITS> f; f.raw = 32767; return f; }
+};
+}
+
+#if Q_STORAGE == Q_STORAGE_HALF
+typedef half_float q_value_t;
+#elif Q_STORAGE == Q_STORAGE_FIXED16
+typedef fixed16<Q_FIXED16_FRACTION_BITS> q_value_t;
+#else
+typedef float q_value_t;
+#endif
+
+#endif // Q_VALUE_H
@@ -0,0 +1,149 @@
+/**
+	Random number engine used by the agents and environments instead of the global rand().
+	Each agent owns its own engine, so there is no shared state between threads and a run can be repeated
+	exactly from its seed. The generator is xoshiro256** (Blackman and Vigna), seeded through splitmix64.
+	@author Alex Cornelio
+*/
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+/**
+	xoshiro256** engine. Small enough to copy around and fast enough to call every step
+*/
+class random_engine
+{
+public:
+    random_engine() { seed(0, 0); }
+    explicit random_engine(uint64_t seed_value, uint64_t stream = 0) { seed(seed_value, stream); }
+
+    /**
+    	Seed the engine. Engines with the same seed and different streams produce unrelated sequences, which
+    	is how independent agents in one run are seeded.
+    */
+    void seed(uint64_t seed_value, uint64_t stream = 0)
+    {
+        uint64_t x = seed_value ^ mix(stream + 0x6a09e667f3bcc909ULL);
+        for (int i = 0; i < 4; i++)
+        {
+            s[i] = splitmix64(x);
+        }
+    }
+
+    /**
+    	Return the next 64 random bits
+    */
+    uint64_t next()
+    {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    /**
+    	Return a random float between 0 and 1, 1 excluded
+    */
+    float uniform()
+    {
+        return (next() >> 40) * (1.0f / 16777216.0f);
+    }
+
+    /**
+    	Return a random integer between 0 and n - 1 (multiply and shift, no division)
+    */
+    unsigned int below(unsigned int n)
+    {
+        return (unsigned int)(((next() >> 32) * n) >> 32);
+    }
+
+    /**
+    	Advance the engine by 2^128 steps. Used to hand out non-overlapping sub streams
+    */
+    void jump()
+    {
+        static const uint64_t JUMP[4] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                         0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+        uint64_t t[4] = {0, 0, 0, 0};
+        for (int i = 0; i < 4; i++)
+        {
+            for (int b = 0; b < 64; b++)
+            {
+                if (JUMP[i] & (uint64_t(1) << b))
+                {
+                    for (int k = 0; k < 4; k++)
+                    {
+                        t[k] ^= s[k];
+                    }
+                }
+                next();
+            }
+        }
+        for (int k = 0; k < 4; k++)
+        {
+            s[k] = t[k];
+        }
+    }
+
+    /**
+    	Return an engine for a new stream and move this one past it
+    */
+    random_engine split()
+    {
+        random_engine child = *this;
+        jump();
+        return child;
+    }
+
+    /**
+    	Copy the 256 bit engine state out, e.g. to run many engines side by side or to save a run
+    */
+    void getState(uint64_t state[4]) const
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            state[i] = s[i];
+        }
+    }
+
+    /**
+    	Restore a state from getState
+    */
+    void setState(const uint64_t state[4])
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            s[i] = state[i];
+        }
+    }
+
+private:
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    static uint64_t splitmix64(uint64_t &x)
+    {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    static uint64_t mix(uint64_t x)
+    {
+        return splitmix64(x);
+    }
+};
+
+#endif // RANDOM_H
@@ -0,0 +1,47 @@
+/**
+	Q value shared between threads without locks, for Hogwild training: several threads run their own
+	episodes against one table and update it at the same time.
+	Every read and write of a relaxed_float is a relaxed atomic load or store of a float, so there is no data
+	race and no fence, and on x86 the code is the same as for a plain float. An update is a load followed by
+	a store, not a compare and swap, so when two threads update the same value at the same moment one of the
+	updates can be lost. TD learning tolerates that the same way it tolerates noise in the rewards, and it
+	only happens when two threads are in the same state at once.
+	@author Alex Cornelio
+*/
+
+#ifndef RELAXED_FLOAT_H
+#define RELAXED_FLOAT_H
+
+#include <atomic>
+#include <limits>
+
+struct relaxed_float
+{
+    std::atomic<float> value;
+
+    relaxed_float() : value(0.0f) {}
+    relaxed_float(float v) : value(v) {}
+    relaxed_float(const relaxed_float &other) : value((float)other) {}
+    relaxed_float &operator=(const relaxed_float &other) { value.store((float)other, std::memory_order_relaxed); return *this; }
+    relaxed_float &operator=(float v) { value.store(v, std::memory_order_relaxed); return *this; }
+
+    operator float() const { return value.load(std::memory_order_relaxed); }
+    relaxed_float &operator+=(float v) { return *this = (float)*this + v; }
+    relaxed_float &operator-=(float v) { return *this = (float)*this - v; }
+};
+
+static_assert(std::atomic<float>::is_always_lock_free, "relaxed_float needs lock free float atomics");
+static_assert(sizeof(relaxed_float) == sizeof(float), "relaxed_float must pack like a float");
+
+namespace std
+{
+// lowest value, QTable pads its rows with it so a row scan never picks the padding
+template <>
+struct numeric_limits<relaxed_float> : numeric_limits<float>
+{
+    static relaxed_float lowest() { return relaxed_float(numeric_limits<float>::lowest()); }
+    static relaxed_float max() { return relaxed_float(numeric_limits<float>::max()); }
+};
+}
+
+#endif // RELAXED_FLOAT_H
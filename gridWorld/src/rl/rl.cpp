@@ -1,4 +1,4 @@
-#include "RL.hpp"
+#include "rl.hpp"
 
 /**
 	Constructor
@@ -15,10 +15,11 @@ RL::~RL()
 {
 
 }
+
 /**
-	Choose an action
+	Seed this agent's random engine
 */
-char RL::chooseAction(float epsilon, std::vector<bool> available_actions, std::vector<float> state_row)
+void RL::seed(uint64_t seed_value, uint64_t stream)
 {
-
+    rng.seed(seed_value, stream);
 }
@@ -3,6 +3,8 @@
 
 #include <vector>
 
+#include "action_selection.hpp"
+
 
 /**
 	Base class for all Rienforcement learning algorithms
@@ -11,10 +13,15 @@ class RL
 {
 public:
     RL();
-    ~RL();
+    virtual ~RL();
+
+    // per agent random engine used for exploration and tie breaking
+    random_engine rng;
+    void seed(uint64_t seed_value, uint64_t stream = 0);
 
     char policy(std::vector<char>);
-    char virtual choose_action(float epsilon, std::vector<bool> available_actions, std::vector<float> state_row) = 0;
+    char virtual chooseAction(float epsilon, action_mask_t available_actions, q_row_view state_row) = 0;
 };
 
 #endif // RL_H
+
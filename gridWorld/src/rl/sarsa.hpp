@@ -12,13 +12,13 @@
 #include <stdlib.h>
 #include <cmath>
 
-class sarsa : public RL
+class sarsa final : public RL
 {
 public:
     sarsa();
     ~sarsa();
 
-    char chooseAction(float epsilon, std::vector<bool> available_actions, std::vector<float> state_row);
+    char chooseAction(float epsilon, action_mask_t available_actions, q_row_view state_row);
 
 };
 
@@ -0,0 +1,353 @@
+/**
+	SparseQTable class declaration and methods.
+	Q table for state spaces too large to allocate up front, e.g. the product of the bins of every measurement
+	of the robot once pitch acceleration and wheel velocity are added. A row is only stored once its state is
+	written, so memory grows with the number of visited states instead of the number of possible ones.
+	The interface is QTable's: Q[s][a], max, argmax, fill, actions and stride, so the training loops and the
+	controllers take either table.
+	States are found through an open addressing hash index with linear probing. The rows themselves live in
+	cache line aligned chunks that are never moved, so a row pointer stays valid while other states are
+	inserted and growing the index only rehashes keys. Reads of a state that was never written (the const
+	operator[], max and argmax) see a shared row of initial values and store nothing.
+	@author Alex Cornelio
+*/
+
+#ifndef SPARSE_Q_TABLE_H
+#define SPARSE_Q_TABLE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "q_table.hpp"
+
+// rows per chunk of row storage
+#define SPARSE_Q_TABLE_CHUNK_ROWS 1024
+// the index grows when more than this percentage of its slots is used
+#define SPARSE_Q_TABLE_MAX_LOAD 50
+
+/**
+	Sparse table of Q values with the same rows as QTable<States, Actions, T>
+*/
+template <std::size_t Actions, typename T = float>
+class SparseQTable
+{
+public:
+    typedef T value_type;
+    static constexpr std::size_t ACTIONS = Actions;
+    static constexpr std::size_t LANES = QTable<1, Actions, T>::LANES;
+    static constexpr std::size_t STRIDE = QTable<1, Actions, T>::STRIDE;
+
+    explicit SparseQTable(T initial_value = T(0));
+    SparseQTable(std::size_t expected_states, T initial_value);
+    SparseQTable(const SparseQTable &other);
+    SparseQTable &operator=(const SparseQTable &other);
+    ~SparseQTable();
+
+    T *operator[](std::size_t s);
+    const T *operator[](std::size_t s) const;
+
+    // number of stored rows, the states that have been written
+    std::size_t states() const { return keys_.size(); }
+    std::size_t size() const { return states() * STRIDE; }
+    constexpr std::size_t actions() const { return Actions; }
+    constexpr std::size_t stride() const { return STRIDE; }
+    bool contains(std::size_t s) const { return find(s) != EMPTY; }
+
+    // stored rows in the order they were inserted, row i belongs to state stateAt(i)
+    std::size_t stateAt(std::size_t i) const { return keys_[i]; }
+    const T *rowAt(std::size_t i) const { return chunks_[i / SPARSE_Q_TABLE_CHUNK_ROWS] + (i % SPARSE_Q_TABLE_CHUNK_ROWS) * STRIDE; }
+
+    void fill(T value);
+    void clear();
+    std::size_t argmax(std::size_t s) const { return rowArgmax<Actions, STRIDE>((*this)[s]); }
+    T max(std::size_t s) const { return rowMax<Actions, STRIDE>((*this)[s]); }
+    std::size_t memoryBytes() const;
+
+private:
+    static constexpr uint32_t EMPTY = 0xffffffff;
+
+    // index slots, slot_row_ is EMPTY for a free slot
+    std::vector<uint64_t> slot_key_;
+    std::vector<uint32_t> slot_row_;
+    int shift_;
+
+    // key of every stored row and the chunks holding the rows
+    std::vector<uint64_t> keys_;
+    std::vector<T *> chunks_;
+
+    T *initial_row_;
+    T initial_value_;
+
+    std::size_t slotOf(uint64_t key) const { return (std::size_t)((key * 0x9e3779b97f4a7c15ULL) >> shift_); }
+    uint32_t find(std::size_t s) const;
+    uint32_t insert(std::size_t s);
+    void rehash(std::size_t slots);
+    T *row(uint32_t i) const { return chunks_[i / SPARSE_Q_TABLE_CHUNK_ROWS] + (i % SPARSE_Q_TABLE_CHUNK_ROWS) * STRIDE; }
+    static T *allocateRows(std::size_t rows);
+    static void releaseRows(T *rows, std::size_t count);
+    static void setRow(T *row, T value);
+    void release();
+    void copyFrom(const SparseQTable &other);
+};
+
+/**
+	Constructor. Every state reads initial_value until it is written
+*/
+template <std::size_t Actions, typename T>
+SparseQTable<Actions, T>::SparseQTable(T initial_value)
+    :SparseQTable(0, initial_value)
+{
+}
+
+/**
+	Constructor that sizes the index for expected_states states, so it does not grow until there are more
+*/
+template <std::size_t Actions, typename T>
+SparseQTable<Actions, T>::SparseQTable(std::size_t expected_states, T initial_value)
+    :shift_(64),
+     initial_row_(allocateRows(1)),
+     initial_value_(initial_value)
+{
+    setRow(initial_row_, initial_value);
+    std::size_t slots = 16;
+    while (slots * SPARSE_Q_TABLE_MAX_LOAD / 100 < expected_states)
+    {
+        slots *= 2;
+    }
+    rehash(slots);
+}
+
+/**
+	Copy constructor
+*/
+template <std::size_t Actions, typename T>
+SparseQTable<Actions, T>::SparseQTable(const SparseQTable &other)
+    :initial_row_(allocateRows(1))
+{
+    copyFrom(other);
+}
+
+/**
+	Copy assignment
+*/
+template <std::size_t Actions, typename T>
+SparseQTable<Actions, T> &SparseQTable<Actions, T>::operator=(const SparseQTable &other)
+{
+    if (this != &other)
+    {
+        clear();
+        copyFrom(other);
+    }
+    return *this;
+}
+
+/**
+	Destructor
+*/
+template <std::size_t Actions, typename T>
+SparseQTable<Actions, T>::~SparseQTable()
+{
+    release();
+    releaseRows(initial_row_, 1);
+}
+
+/**
+	Return the row of state s, storing it with initial values the first time s is seen
+*/
+template <std::size_t Actions, typename T>
+inline T *SparseQTable<Actions, T>::operator[](std::size_t s)
+{
+    uint32_t i = find(s);
+    return row(i != EMPTY ? i : insert(s));
+}
+
+/**
+	Return the row of state s, or a row of initial values if s was never written
+*/
+template <std::size_t Actions, typename T>
+inline const T *SparseQTable<Actions, T>::operator[](std::size_t s) const
+{
+    uint32_t i = find(s);
+    return i != EMPTY ? row(i) : initial_row_;
+}
+
+/**
+	Return the row number of state s, or EMPTY
+*/
+template <std::size_t Actions, typename T>
+inline uint32_t SparseQTable<Actions, T>::find(std::size_t s) const
+{
+    std::size_t mask = slot_key_.size() - 1;
+    for (std::size_t slot = slotOf(s);; slot = (slot + 1) & mask)
+    {
+        uint32_t i = slot_row_[slot];
+        if (i == EMPTY || slot_key_[slot] == s)
+        {
+            return i;
+        }
+    }
+}
+
+/**
+	Store a new row of initial values for state s and return its number. s must not be stored yet
+*/
+template <std::size_t Actions, typename T>
+uint32_t SparseQTable<Actions, T>::insert(std::size_t s)
+{
+    if ((keys_.size() + 1) * 100 > slot_key_.size() * SPARSE_Q_TABLE_MAX_LOAD)
+    {
+        rehash(slot_key_.size() * 2);
+    }
+    uint32_t i = (uint32_t)keys_.size();
+    if (i % SPARSE_Q_TABLE_CHUNK_ROWS == 0)
+    {
+        chunks_.push_back(allocateRows(SPARSE_Q_TABLE_CHUNK_ROWS));
+    }
+    setRow(row(i), initial_value_);
+    keys_.push_back(s);
+
+    std::size_t mask = slot_key_.size() - 1;
+    std::size_t slot = slotOf(s);
+    while (slot_row_[slot] != EMPTY)
+    {
+        slot = (slot + 1) & mask;
+    }
+    slot_key_[slot] = s;
+    slot_row_[slot] = i;
+    return i;
+}
+
+/**
+	Rebuild the index with slots slots (a power of two). Only keys move, the rows stay where they are
+*/
+template <std::size_t Actions, typename T>
+void SparseQTable<Actions, T>::rehash(std::size_t slots)
+{
+    shift_ = 64 - __builtin_ctzll(slots);
+    slot_key_.assign(slots, 0);
+    slot_row_.assign(slots, EMPTY);
+    for (uint32_t i = 0; i < keys_.size(); i++)
+    {
+        std::size_t slot = slotOf(keys_[i]);
+        while (slot_row_[slot] != EMPTY)
+        {
+            slot = (slot + 1) & (slots - 1);
+        }
+        slot_key_[slot] = keys_[i];
+        slot_row_[slot] = i;
+    }
+}
+
+/**
+	Set every stored Q value and the value states read before they are written
+*/
+template <std::size_t Actions, typename T>
+void SparseQTable<Actions, T>::fill(T value)
+{
+    initial_value_ = value;
+    setRow(initial_row_, value);
+    for (uint32_t i = 0; i < keys_.size(); i++)
+    {
+        setRow(row(i), value);
+    }
+}
+
+/**
+	Forget every stored state. The memory of the rows is given back, the index keeps its size
+*/
+template <std::size_t Actions, typename T>
+void SparseQTable<Actions, T>::clear()
+{
+    release();
+    slot_row_.assign(slot_row_.size(), EMPTY);
+}
+
+/**
+	Return the bytes held by the index and the rows
+*/
+template <std::size_t Actions, typename T>
+std::size_t SparseQTable<Actions, T>::memoryBytes() const
+{
+    return slot_key_.capacity() * sizeof(uint64_t) + slot_row_.capacity() * sizeof(uint32_t) +
+           keys_.capacity() * sizeof(uint64_t) + (chunks_.size() * SPARSE_Q_TABLE_CHUNK_ROWS + 1) * STRIDE * sizeof(T);
+}
+
+/**
+	Get an aligned block of rows and construct every element in it
+*/
+template <std::size_t Actions, typename T>
+T *SparseQTable<Actions, T>::allocateRows(std::size_t rows)
+{
+    T *data = static_cast<T *>(::operator new[](rows * STRIDE * sizeof(T), std::align_val_t(Q_TABLE_ALIGNMENT)));
+    for (std::size_t i = 0; i < rows * STRIDE; i++)
+    {
+        new (data + i) T();
+    }
+    return data;
+}
+
+/**
+	Destroy every element of a block of count rows and give it back
+*/
+template <std::size_t Actions, typename T>
+void SparseQTable<Actions, T>::releaseRows(T *rows, std::size_t count)
+{
+    for (std::size_t i = 0; i < count * STRIDE; i++)
+    {
+        rows[i].~T();
+    }
+    ::operator delete[](rows, std::align_val_t(Q_TABLE_ALIGNMENT));
+}
+
+/**
+	Set the values of a row, the padding gets the lowest value as in QTable::fill
+*/
+template <std::size_t Actions, typename T>
+void SparseQTable<Actions, T>::setRow(T *row, T value)
+{
+    for (std::size_t a = 0; a < Actions; a++)
+    {
+        row[a] = value;
+    }
+    for (std::size_t a = Actions; a < STRIDE; a++)
+    {
+        row[a] = std::numeric_limits<T>::lowest();
+    }
+}
+
+/**
+	Give back every chunk of rows
+*/
+template <std::size_t Actions, typename T>
+void SparseQTable<Actions, T>::release()
+{
+    for (std::size_t c = 0; c < chunks_.size(); c++)
+    {
+        releaseRows(chunks_[c], SPARSE_Q_TABLE_CHUNK_ROWS);
+    }
+    chunks_.clear();
+    keys_.clear();
+}
+
+/**
+	Make this an empty table with other's index size, initial value and rows. The rows are copied in the same
+	order so row numbers and stateAt stay the same
+*/
+template <std::size_t Actions, typename T>
+void SparseQTable<Actions, T>::copyFrom(const SparseQTable &other)
+{
+    initial_value_ = other.initial_value_;
+    setRow(initial_row_, initial_value_);
+    keys_ = other.keys_;
+    for (std::size_t c = 0; c < other.chunks_.size(); c++)
+    {
+        chunks_.push_back(allocateRows(SPARSE_Q_TABLE_CHUNK_ROWS));
+        for (std::size_t i = 0; i < SPARSE_Q_TABLE_CHUNK_ROWS * STRIDE; i++)
+        {
+            chunks_[c][i] = other.chunks_[c][i];
+        }
+    }
+    rehash(other.slot_key_.size());
+}
+
+#endif // SPARSE_Q_TABLE_H
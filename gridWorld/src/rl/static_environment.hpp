@@ -0,0 +1,57 @@
+/**
+	Statically dispatched environment interface.
+	The virtual environment class costs an indirect call per method per step and hands the compiler nothing to
+	inline. Environments that also derive from static_environment<Derived> (CRTP) can be driven by the
+	templated training loops in training.hpp, where the whole step is visible to the optimiser.
+
+	A derived environment provides the following, static and constexpr where the world is fixed at compile
+	time (gridWorld) or ordinary members where it is data (mapGridWorld):
+		action_mask_t actionMask(state_t s)                legal actions in s
+		state_t sampleNext(char action, state_t s)         next state, including any noise
+		signed short int rewardOf(state_t next)            reward for arriving in next
+		bool isTerminal(state_t next)                      the episode ends in next
+	@author Alex Cornelio
+*/
+
+#ifndef STATIC_ENVIRONMENT_H
+#define STATIC_ENVIRONMENT_H
+
+#include "environment.hpp"
+
+/**
+	Everything one transition produces
+*/
+struct step_result
+{
+    state_t next_state;
+    signed short int reward;
+    bool done;
+};
+
+template <class Derived>
+class static_environment
+{
+public:
+    /**
+    	Take action in state s
+    */
+    step_result step(state_t s, char action)
+    {
+        Derived &env = static_cast<Derived &>(*this);
+        step_result result;
+        result.next_state = env.sampleNext(action, s);
+        result.reward = env.rewardOf(result.next_state);
+        result.done = env.isTerminal(result.next_state);
+        return result;
+    }
+
+    /**
+    	Legal actions in state s
+    */
+    action_mask_t mask(state_t s)
+    {
+        return static_cast<Derived &>(*this).actionMask(s);
+    }
+};
+
+#endif // STATIC_ENVIRONMENT_H
@@ -0,0 +1,196 @@
+/**
+	Work stealing thread pool.
+	Every worker owns a queue. Tasks submitted from inside a task go to the submitting worker's own queue,
+	tasks submitted from outside are dealt round robin. A worker takes from the back of its own queue and,
+	when that is empty, steals from the front of the others, so long and short tasks even out across cores.
+	@author Alex Cornelio
+*/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class thread_pool
+{
+public:
+    explicit thread_pool(unsigned int threads = std::thread::hardware_concurrency());
+    ~thread_pool();
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    void submit(std::function<void()> task);
+    void wait();
+
+    unsigned int size() const { return (unsigned int)threads_.size(); }
+
+private:
+    struct worker_queue
+    {
+        std::mutex lock;
+        std::deque<std::function<void()> > tasks;
+    };
+
+    std::vector<std::unique_ptr<worker_queue> > queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<unsigned int> next_queue_;
+
+    // queued counts tasks waiting in a queue, pending also counts the running ones. Taken before a queue
+    // lock, never while holding one
+    std::mutex state_lock_;
+    std::condition_variable work_available_;
+    std::condition_variable all_done_;
+    unsigned long queued_;
+    unsigned long pending_;
+    bool stopping_;
+
+    // which pool and queue the current thread works for, so nested submits stay local
+    static inline thread_local thread_pool *current_pool_ = nullptr;
+    static inline thread_local unsigned int current_queue_ = 0;
+
+    bool take(unsigned int self, std::function<void()> &task);
+    void workerLoop(unsigned int self);
+};
+
+/**
+	Start the workers. At least one worker is started even if the core count is unknown
+*/
+inline thread_pool::thread_pool(unsigned int threads)
+    :next_queue_(0),
+     queued_(0),
+     pending_(0),
+     stopping_(false)
+{
+    if (threads == 0)
+    {
+        threads = 1;
+    }
+    for (unsigned int i = 0; i < threads; i++)
+    {
+        queues_.push_back(std::unique_ptr<worker_queue>(new worker_queue));
+    }
+    for (unsigned int i = 0; i < threads; i++)
+    {
+        threads_.push_back(std::thread(&thread_pool::workerLoop, this, i));
+    }
+}
+
+/**
+	Finish every submitted task, then stop the workers
+*/
+inline thread_pool::~thread_pool()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> guard(state_lock_);
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+    for (std::size_t i = 0; i < threads_.size(); i++)
+    {
+        threads_[i].join();
+    }
+}
+
+/**
+	Queue a task. It is counted in the same critical section it is queued in, so no worker can take and
+	finish it before it is counted
+*/
+inline void thread_pool::submit(std::function<void()> task)
+{
+    unsigned int q = (current_pool_ == this) ? current_queue_ : next_queue_++ % queues_.size();
+    {
+        std::lock_guard<std::mutex> state_guard(state_lock_);
+        queued_++;
+        pending_++;
+        std::lock_guard<std::mutex> guard(queues_[q]->lock);
+        queues_[q]->tasks.push_back(std::move(task));
+    }
+    work_available_.notify_one();
+}
+
+/**
+	Block until every submitted task has finished. Must not be called from inside a task
+*/
+inline void thread_pool::wait()
+{
+    std::unique_lock<std::mutex> guard(state_lock_);
+    all_done_.wait(guard, [this] { return pending_ == 0; });
+}
+
+/**
+	Take a task from the worker's own queue, or steal one from another worker
+*/
+inline bool thread_pool::take(unsigned int self, std::function<void()> &task)
+{
+    std::size_t n = queues_.size();
+    for (std::size_t k = 0; k < n; k++)
+    {
+        worker_queue &queue = *queues_[(self + k) % n];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty())
+        {
+            continue;
+        }
+        if (k == 0)
+        {
+            // own queue, newest first: it is the one most likely still in cache
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+	Run tasks until the pool stops
+*/
+inline void thread_pool::workerLoop(unsigned int self)
+{
+    current_pool_ = this;
+    current_queue_ = self;
+
+    std::function<void()> task;
+    while (true)
+    {
+        if (take(self, task))
+        {
+            {
+                std::lock_guard<std::mutex> guard(state_lock_);
+                queued_--;
+            }
+            task();
+            task = nullptr;
+
+            std::lock_guard<std::mutex> guard(state_lock_);
+            if (--pending_ == 0)
+            {
+                all_done_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(state_lock_);
+        work_available_.wait(guard, [this] { return queued_ > 0 || stopping_; });
+        if (stopping_ && queued_ == 0)
+        {
+            return;
+        }
+    }
+}
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,353 @@
+/**
+	Trajectory trace class methods: chunks, blocks and the index at the end of the file
+	@author Alex Cornelio
+*/
+
+#include <string.h>
+
+#ifdef RL_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "trace.hpp"
+
+/**
+	The columns every trace has, in file order
+*/
+static const trace_column_info TRACE_SCHEMA[TRACE_COLUMNS] = {
+    {"episode", TRACE_UINT32, 4},
+    {"step", TRACE_UINT32, 4},
+    {"state", TRACE_UINT32, 4},
+    {"action", TRACE_UINT8, 1},
+    {"reward", TRACE_FLOAT32, 4},
+    {"next_state", TRACE_UINT32, 4},
+    {"td_error", TRACE_FLOAT32, 4},
+    {"done", TRACE_UINT8, 1},
+};
+
+void trace_chunk::reserve(std::size_t rows)
+{
+    episode.reserve(rows);
+    step.reserve(rows);
+    state.reserve(rows);
+    action.reserve(rows);
+    reward.reserve(rows);
+    next_state.reserve(rows);
+    td_error.reserve(rows);
+    done.reserve(rows);
+}
+
+void trace_chunk::clear()
+{
+    episode.clear();
+    step.clear();
+    state.clear();
+    action.clear();
+    reward.clear();
+    next_state.clear();
+    td_error.clear();
+    done.clear();
+}
+
+void trace_chunk::swap(trace_chunk &other)
+{
+    episode.swap(other.episode);
+    step.swap(other.step);
+    state.swap(other.state);
+    action.swap(other.action);
+    reward.swap(other.reward);
+    next_state.swap(other.next_state);
+    td_error.swap(other.td_error);
+    done.swap(other.done);
+}
+
+trace_writer::trace_writer(std::size_t chunk_rows)
+    :file_(NULL),
+     chunk_rows_(chunk_rows > 0 ? chunk_rows : 1),
+     episode_(0),
+     rows_(0),
+     has_pending_(false),
+     stop_(false),
+     offset_(0),
+     failed_(false)
+{
+    chunk_.reserve(chunk_rows_);
+    pending_.reserve(chunk_rows_);
+    writing_.reserve(chunk_rows_);
+}
+
+/**
+	Destructor. Closes the file, so it gets its index
+*/
+trace_writer::~trace_writer()
+{
+    close();
+}
+
+/**
+	Start a new trace at path, closing the one before, and the thread that writes it. Returns false if it
+	cannot be created
+*/
+bool trace_writer::open(const std::string &path)
+{
+    close();
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_)
+    {
+        return false;
+    }
+    trace_header header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.columns = TRACE_COLUMNS;
+    header.chunk_rows = chunk_rows_;
+    failed_ = fwrite(&header, sizeof(header), 1, file_) != 1 ||
+              fwrite(TRACE_SCHEMA, sizeof(TRACE_SCHEMA), 1, file_) != 1;
+    offset_ = sizeof(header) + sizeof(TRACE_SCHEMA);
+    rows_ = 0;
+    episode_ = 0;
+    index_.clear();
+    chunk_.clear();
+    has_pending_ = false;
+    stop_ = false;
+    thread_ = std::thread(&trace_writer::run, this);
+    return !failed_;
+}
+
+/**
+	Write the rows still buffered, then the index and the footer, and close the file. Returns false if any
+	of the trace was lost
+*/
+bool trace_writer::close()
+{
+    if (!file_)
+    {
+        return !failed_;
+    }
+    if (chunk_.rows() > 0)
+    {
+        submitChunk();
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+
+    trace_footer footer;
+    footer.index_offset = offset_;
+    footer.chunks = index_.size() / TRACE_COLUMNS;
+    footer.columns = TRACE_COLUMNS;
+    memcpy(footer.magic, TRACE_MAGIC, sizeof(footer.magic));
+    bool ok = (index_.empty() || fwrite(index_.data(), sizeof(trace_block), index_.size(), file_) == index_.size()) &&
+              fwrite(&footer, sizeof(footer), 1, file_) == 1;
+    failed_ = fclose(file_) != 0 || !ok || failed_;
+    file_ = NULL;
+    return !failed_;
+}
+
+/**
+	Hand the full chunk to the writer thread, waiting only if it has not taken the one before yet
+*/
+void trace_writer::submitChunk()
+{
+    {
+        std::unique_lock<std::mutex> guard(lock_);
+        done_.wait(guard, [this] { return !has_pending_; });
+        pending_.swap(chunk_);
+        has_pending_ = true;
+    }
+    wake_.notify_one();
+    chunk_.clear();
+}
+
+/**
+	Writer thread: write every chunk handed over, until closed with nothing left
+*/
+void trace_writer::run()
+{
+    std::unique_lock<std::mutex> guard(lock_);
+    while (true)
+    {
+        wake_.wait(guard, [this] { return has_pending_ || stop_; });
+        if (!has_pending_)
+        {
+            break;
+        }
+        writing_.swap(pending_);
+        has_pending_ = false;
+        done_.notify_one();
+
+        guard.unlock();
+        writeChunk(writing_);
+        guard.lock();
+    }
+}
+
+/**
+	Write the rows of chunk as one block per column, in TRACE_SCHEMA order
+*/
+void trace_writer::writeChunk(const trace_chunk &chunk)
+{
+    uint32_t rows = chunk.rows();
+    writeBlock(chunk.episode.data(), rows * sizeof(uint32_t), rows);
+    writeBlock(chunk.step.data(), rows * sizeof(uint32_t), rows);
+    writeBlock(chunk.state.data(), rows * sizeof(uint32_t), rows);
+    writeBlock(chunk.action.data(), rows * sizeof(uint8_t), rows);
+    writeBlock(chunk.reward.data(), rows * sizeof(float), rows);
+    writeBlock(chunk.next_state.data(), rows * sizeof(uint32_t), rows);
+    writeBlock(chunk.td_error.data(), rows * sizeof(float), rows);
+    writeBlock(chunk.done.data(), rows * sizeof(uint8_t), rows);
+}
+
+/**
+	Compress one column of a chunk and append it, stored raw if it does not get smaller
+*/
+void trace_writer::writeBlock(const void *data, std::size_t bytes, uint32_t rows)
+{
+    trace_block block = {offset_, (uint32_t)bytes, (uint32_t)bytes, rows, TRACE_RAW};
+    const void *out = data;
+#ifdef RL_HAVE_ZLIB
+    uLongf packed = compressBound(bytes);
+    compressed_.resize(packed);
+    if (compress2(compressed_.data(), &packed, (const Bytef *)data, bytes, Z_BEST_SPEED) == Z_OK && packed < bytes)
+    {
+        block.bytes = packed;
+        block.codec = TRACE_ZLIB;
+        out = compressed_.data();
+    }
+#endif
+    if (fwrite(out, block.bytes, 1, file_) != 1)
+    {
+        failed_ = true;
+    }
+    offset_ += block.bytes;
+    index_.push_back(block);
+}
+
+trace_reader::trace_reader()
+    :file_(NULL),
+     chunks_(0),
+     rows_(0)
+{
+}
+
+trace_reader::~trace_reader()
+{
+    close();
+}
+
+void trace_reader::close()
+{
+    if (file_)
+    {
+        fclose(file_);
+        file_ = NULL;
+    }
+    columns_.clear();
+    index_.clear();
+    chunks_ = 0;
+    rows_ = 0;
+}
+
+/**
+	Open the trace at path and read its columns and index. Returns false if it cannot be read, is not a
+	trace or was never closed
+*/
+bool trace_reader::open(const std::string &path)
+{
+    close();
+    file_ = fopen(path.c_str(), "rb");
+    if (!file_)
+    {
+        return false;
+    }
+    fseek(file_, 0, SEEK_END);
+    uint64_t size = ftell(file_);
+    fseek(file_, 0, SEEK_SET);
+
+    trace_header header;
+    trace_footer footer;
+    bool ok = size >= sizeof(header) + sizeof(footer) && fread(&header, sizeof(header), 1, file_) == 1 &&
+              memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) == 0 && header.columns > 0 &&
+              header.columns <= 256;
+    if (ok)
+    {
+        columns_.resize(header.columns);
+        ok = fread(columns_.data(), sizeof(trace_column_info), columns_.size(), file_) == columns_.size() &&
+             fseek(file_, size - sizeof(footer), SEEK_SET) == 0 && fread(&footer, sizeof(footer), 1, file_) == 1 &&
+             memcmp(footer.magic, TRACE_MAGIC, sizeof(footer.magic)) == 0 && footer.columns == header.columns &&
+             footer.index_offset + (uint64_t)footer.chunks * footer.columns * sizeof(trace_block) + sizeof(footer)
+                 == size;
+    }
+    if (ok)
+    {
+        index_.resize((std::size_t)footer.chunks * footer.columns);
+        ok = fseek(file_, footer.index_offset, SEEK_SET) == 0 &&
+             (index_.empty() || fread(index_.data(), sizeof(trace_block), index_.size(), file_) == index_.size());
+    }
+    if (!ok)
+    {
+        close();
+        return false;
+    }
+    for (std::size_t k = 0; k < columns_.size(); k++)
+    {
+        columns_[k].name[sizeof(columns_[k].name) - 1] = 0;
+    }
+    chunks_ = footer.chunks;
+    for (unsigned int chunk = 0; chunk < chunks_; chunk++)
+    {
+        rows_ += index_[chunk * columns_.size()].rows;
+    }
+    return true;
+}
+
+/**
+	Index of the column called name, -1 if there is none
+*/
+int trace_reader::findColumn(const std::string &name) const
+{
+    for (std::size_t k = 0; k < columns_.size(); k++)
+    {
+        if (name == columns_[k].name)
+        {
+            return k;
+        }
+    }
+    return -1;
+}
+
+/**
+	Read column k of one chunk into raw, decompressed
+*/
+bool trace_reader::readBlock(unsigned int chunk, unsigned int k, std::vector<unsigned char> &raw)
+{
+    if (!file_ || chunk >= chunks_ || k >= columns_.size())
+    {
+        return false;
+    }
+    const trace_block &block = index_[chunk * columns_.size() + k];
+    if (block.raw_bytes != (uint64_t)block.rows * columns_[k].width)
+    {
+        return false;
+    }
+    raw.resize(block.raw_bytes);
+    if (block.codec == TRACE_RAW)
+    {
+        return block.bytes == block.raw_bytes && fseek(file_, block.offset, SEEK_SET) == 0 &&
+               (block.bytes == 0 || fread(raw.data(), block.bytes, 1, file_) == 1);
+    }
+#ifdef RL_HAVE_ZLIB
+    if (block.codec == TRACE_ZLIB)
+    {
+        stored_.resize(block.bytes);
+        uLongf unpacked = block.raw_bytes;
+        return fseek(file_, block.offset, SEEK_SET) == 0 && fread(stored_.data(), block.bytes, 1, file_) == 1 &&
+               uncompress(raw.data(), &unpacked, stored_.data(), block.bytes) == Z_OK &&
+               unpacked == block.raw_bytes;
+    }
+#endif
+    // written by an rl_lib with a codec this one was built without
+    return false;
+}
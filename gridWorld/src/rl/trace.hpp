@@ -0,0 +1,240 @@
+/**
+	Trajectory trace class declarations.
+	Records every transition of training, (episode, step, s, a, r, s', td_error, done), for offline analysis
+	instead of a message per step in a rosbag. Rows are kept column by column and every chunk_rows rows each
+	column is compressed on its own (zlib, when rl_lib is built with it) and appended to the file as a block.
+	close() writes an index of the blocks at the end of the file, so trace_reader can read one column, say
+	td_error, by seeking to its blocks and never touches the others. A file that was not closed has no index
+	and cannot be read.
+	Values are stored in host byte order.
+	@author Alex Cornelio
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "environment.hpp"
+
+#define TRACE_MAGIC "RLTRACE1"
+#ifndef TRACE_CHUNK_ROWS
+#define TRACE_CHUNK_ROWS 16384
+#endif
+
+// columns, in file order
+#define TRACE_EPISODE 0
+#define TRACE_STEP 1
+#define TRACE_STATE 2
+#define TRACE_ACTION 3
+#define TRACE_REWARD 4
+#define TRACE_NEXT_STATE 5
+#define TRACE_TD_ERROR 6
+#define TRACE_DONE 7
+#define TRACE_COLUMNS 8
+
+// column types
+#define TRACE_UINT8 1
+#define TRACE_UINT32 2
+#define TRACE_FLOAT32 3
+
+// block codecs
+#define TRACE_RAW 0
+#define TRACE_ZLIB 1
+
+/**
+	Name and type of a column, in the file header
+*/
+struct trace_column_info
+{
+    char name[16];
+    uint32_t type;
+    uint32_t width;     // bytes per value
+};
+
+/**
+	Header at the start of a trace file, the column infos follow
+*/
+struct trace_header
+{
+    char magic[8];
+    uint32_t columns;
+    uint32_t chunk_rows;
+};
+
+/**
+	Where one column of one chunk is in the file
+*/
+struct trace_block
+{
+    uint64_t offset;
+    uint32_t bytes;         // as stored
+    uint32_t raw_bytes;
+    uint32_t rows;
+    uint32_t codec;
+};
+
+/**
+	Last bytes of a closed trace file, the index of chunks x columns blocks is right before it
+*/
+struct trace_footer
+{
+    uint64_t index_offset;
+    uint32_t chunks;
+    uint32_t columns;
+    char magic[8];
+};
+
+/**
+	Columns of the rows of one chunk
+*/
+struct trace_chunk
+{
+    std::vector<uint32_t> episode;
+    std::vector<uint32_t> step;
+    std::vector<uint32_t> state;
+    std::vector<uint8_t> action;
+    std::vector<float> reward;
+    std::vector<uint32_t> next_state;
+    std::vector<float> td_error;
+    std::vector<uint8_t> done;
+
+    std::size_t rows() const { return episode.size(); }
+    void reserve(std::size_t rows);
+    void clear();
+    void swap(trace_chunk &other);
+};
+
+/**
+	Writes a trace. Full chunks are handed to a thread of its own, which compresses and writes them while
+	the next chunk fills, so a control loop never waits for zlib or the disk unless it fills a whole chunk
+	before the last one is written
+*/
+class trace_writer
+{
+public:
+    trace_writer(std::size_t chunk_rows = TRACE_CHUNK_ROWS);
+    ~trace_writer();
+
+    bool open(const std::string &path);
+    bool close();
+
+    // rows carry the episode set by beginEpisode and their step within it
+    void beginEpisode(uint32_t episode) { episode_ = episode; }
+    void record(uint32_t step, state_t s, char action, float reward, state_t next_state, float td_error, bool done)
+    {
+        chunk_.episode.push_back(episode_);
+        chunk_.step.push_back(step);
+        chunk_.state.push_back(s);
+        chunk_.action.push_back((uint8_t)action);
+        chunk_.reward.push_back(reward);
+        chunk_.next_state.push_back(next_state);
+        chunk_.td_error.push_back(td_error);
+        chunk_.done.push_back(done);
+        rows_++;
+        if (chunk_.rows() >= chunk_rows_)
+        {
+            submitChunk();
+        }
+    }
+
+    bool isOpen() const { return file_ != NULL; }
+    // recorded so far
+    uint64_t rows() const { return rows_; }
+    // of the last file, once it is closed
+    bool failed() const { return failed_; }
+    uint64_t bytes() const { return offset_; }
+
+private:
+    FILE *file_;
+    std::size_t chunk_rows_;
+    uint32_t episode_;
+    uint64_t rows_;
+    trace_chunk chunk_;
+
+    // shared with the writer thread
+    trace_chunk pending_;
+    bool has_pending_;
+    bool stop_;
+    std::mutex lock_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::thread thread_;
+
+    // the writer thread's own
+    trace_chunk writing_;
+    std::vector<trace_block> index_;
+    std::vector<unsigned char> compressed_;
+    uint64_t offset_;
+    bool failed_;
+
+    void submitChunk();
+    void run();
+    void writeChunk(const trace_chunk &chunk);
+    void writeBlock(const void *data, std::size_t bytes, uint32_t rows);
+};
+
+class trace_reader
+{
+public:
+    trace_reader();
+    ~trace_reader();
+
+    bool open(const std::string &path);
+    void close();
+
+    uint64_t rows() const { return rows_; }
+    unsigned int chunks() const { return chunks_; }
+    unsigned int columns() const { return columns_.size(); }
+    const trace_column_info &column(unsigned int k) const { return columns_[k]; }
+    int findColumn(const std::string &name) const;
+
+    // values of one column over every chunk, false if T is not as wide as the column
+    template <class T>
+    bool readColumn(unsigned int k, std::vector<T> &values);
+    bool readBlock(unsigned int chunk, unsigned int k, std::vector<unsigned char> &raw);
+
+private:
+    FILE *file_;
+    std::vector<trace_column_info> columns_;
+    std::vector<trace_block> index_;
+    std::vector<unsigned char> stored_;
+    unsigned int chunks_;
+    uint64_t rows_;
+};
+
+/**
+	Read every block of column k, one after the other, and nothing else
+*/
+template <class T>
+bool trace_reader::readColumn(unsigned int k, std::vector<T> &values)
+{
+    if (k >= columns_.size() || columns_[k].width != sizeof(T))
+    {
+        return false;
+    }
+    values.clear();
+    values.reserve(rows_);
+    std::vector<unsigned char> raw;
+    for (unsigned int chunk = 0; chunk < chunks_; chunk++)
+    {
+        if (!readBlock(chunk, k, raw))
+        {
+            return false;
+        }
+        std::size_t start = values.size();
+        values.resize(start + raw.size() / sizeof(T));
+        std::copy(raw.begin(), raw.end(), reinterpret_cast<unsigned char *>(values.data() + start));
+    }
+    return true;
+}
+
+#endif // TRACE_H
@@ -0,0 +1,165 @@
+/**
+	Training loops templated on the environment, the Q table and the policy.
+	With a statically dispatched environment (static_environment.hpp) and a final policy class every call in
+	the step loop is resolved at compile time.
+	@author Alex Cornelio
+*/
+
+#ifndef TRAINING_H
+#define TRAINING_H
+
+#include <limits.h>
+#include <type_traits>
+
+#include "action_selection.hpp"
+#include "convergence_detector.hpp"
+#include "static_environment.hpp"
+#include "trace.hpp"
+
+/**
+	Learning rate and discount factor of a TD update
+*/
+struct td_parameters
+{
+    float alpha;
+    float discount_factor;
+};
+
+/**
+	What happened in one episode
+*/
+struct episode_result
+{
+    unsigned int time_step;     // steps that did not end the episode, as counted by the drivers
+    unsigned int steps;         // every transition taken
+    signed short int reward;    // reward of the last transition
+    float episode_return;       // sum of rewards
+};
+
+/**
+	View of row s of Q for a policy. Rows of floats are read in place, rows of 16 bit values (q_value.hpp)
+	are widened into scratch, which needs room for Q.actions() values
+*/
+template <class Table>
+inline q_row_view rowView(Table &Q, state_t s, float *scratch)
+{
+    if constexpr (std::is_same<typename Table::value_type, float>::value)
+    {
+        return q_row_view(Q[s], Q.actions());
+    }
+    else
+    {
+        const typename Table::value_type *row = Q[s];
+        for (unsigned int a = 0; a < Q.actions(); a++)
+        {
+            scratch[a] = row[a];
+        }
+        return q_row_view(scratch, Q.actions());
+    }
+}
+
+/**
+	Run one Q-learning episode from start. Stops when the environment reports the episode is done or after
+	max_steps transitions. With a detector every update is also recorded in it; closing the episode in the
+	detector is left to the caller. With a trace every transition and its TD error is written to it
+*/
+template <class Env, class Table, class Policy>
+episode_result qLearningEpisode(Env &env, Table &Q, Policy &policy, state_t start, float epsilon,
+                                const td_parameters &params, unsigned int max_steps = UINT_MAX,
+                                convergence_detector *detector = NULL, trace_writer *trace = NULL)
+{
+    episode_result result = {0, 0, 0, 0.0f};
+    state_t current_state = start;
+    float scratch[MAX_ACTIONS];
+
+    while (result.steps < max_steps)
+    {
+        //choose action based on policy among the legal actions
+        action_mask_t available_actions = env.mask(current_state);
+        char action = policy.chooseAction(epsilon, available_actions, rowView(Q, current_state, scratch));
+
+        //take action to get next state and reward
+        step_result step = env.step(current_state, action);
+
+        //TD update
+        float td_target = step.reward + params.discount_factor * Q.max(step.next_state);
+        float td_error = td_target - Q[current_state][(int)action];
+        if (detector)
+        {
+            detector->update(Q, current_state, available_actions, action, td_error * params.alpha);
+        }
+        else
+        {
+            Q[current_state][(int)action] += td_error * params.alpha;
+        }
+
+        if (trace)
+        {
+            trace->record(result.steps, current_state, action, step.reward, step.next_state, td_error, step.done);
+        }
+
+        result.steps++;
+        result.reward = step.reward;
+        result.episode_return += step.reward;
+        if (step.done)
+        {
+            break;
+        }
+        result.time_step++;
+        current_state = step.next_state;
+    }
+    return result;
+}
+
+/**
+	Run one SARSA episode from start, recording every update in detector and every transition in trace if
+	there are
+*/
+template <class Env, class Table, class Policy>
+episode_result sarsaEpisode(Env &env, Table &Q, Policy &policy, state_t start, float epsilon,
+                            const td_parameters &params, unsigned int max_steps = UINT_MAX,
+                            convergence_detector *detector = NULL, trace_writer *trace = NULL)
+{
+    episode_result result = {0, 0, 0, 0.0f};
+    state_t current_state = start;
+    float scratch[MAX_ACTIONS];
+    char action = policy.chooseAction(epsilon, env.mask(current_state), rowView(Q, current_state, scratch));
+
+    while (result.steps < max_steps)
+    {
+        //get next state, then the next action from it
+        step_result step = env.step(current_state, action);
+        char next_action = policy.chooseAction(epsilon, env.mask(step.next_state), rowView(Q, step.next_state, scratch));
+
+        //TD update
+        float td_target = step.reward + params.discount_factor * Q[step.next_state][(int)next_action];
+        float td_error = td_target - Q[current_state][(int)action];
+        if (detector)
+        {
+            detector->update(Q, current_state, env.mask(current_state), action, td_error * params.alpha);
+        }
+        else
+        {
+            Q[current_state][(int)action] += td_error * params.alpha;
+        }
+
+        if (trace)
+        {
+            trace->record(result.steps, current_state, action, step.reward, step.next_state, td_error, step.done);
+        }
+
+        result.steps++;
+        result.reward = step.reward;
+        result.episode_return += step.reward;
+        if (step.done)
+        {
+            break;
+        }
+        result.time_step++;
+        current_state = step.next_state;
+        action = next_action;
+    }
+    return result;
+}
+
+#endif // TRAINING_H
@@ -0,0 +1,56 @@
+# Reader of the transition traces of the examples, the Gazebo plugin and the robot (src/rl/trace.hpp).
+# column(path, name) reads that one column, seeking past the blocks of every other:
+#	td_error = column("trace.bin", "td_error")
+# Values come as an array.array.
+import struct
+import sys
+import zlib
+from array import array
+
+MAGIC = b"RLTRACE1"
+HEADER = struct.Struct("=8sII")
+COLUMN = struct.Struct("=16sII")
+BLOCK = struct.Struct("=QIIII")
+FOOTER = struct.Struct("=QII8s")
+TYPES = {1: "B", 2: "I", 3: "f"}
+RAW = 0
+ZLIB = 1
+
+def columns(path):
+	f = open(path, "rb")
+	magic, count, chunk_rows = HEADER.unpack(f.read(HEADER.size))
+	if magic != MAGIC:
+		raise ValueError("%s is not a trace" % path)
+	names = []
+	for k in range(count):
+		name, kind, width = COLUMN.unpack(f.read(COLUMN.size))
+		names.append((name.split(b"\0")[0].decode(), kind))
+	f.close()
+	return names
+
+def column(path, name):
+	names = columns(path)
+	k = [n for n, kind in names].index(name)
+	f = open(path, "rb")
+	f.seek(-FOOTER.size, 2)
+	index_offset, chunks, count, magic = FOOTER.unpack(f.read(FOOTER.size))
+	if magic != MAGIC:
+		raise ValueError("%s was not closed" % path)
+	f.seek(index_offset)
+	index = [BLOCK.unpack(f.read(BLOCK.size)) for i in range(chunks * count)]
+
+	values = array(TYPES[names[k][1]])
+	for chunk in range(chunks):
+		offset, stored, raw, rows, codec = index[chunk * count + k]
+		f.seek(offset)
+		data = f.read(stored)
+		values.frombytes(zlib.decompress(data) if codec == ZLIB else data)
+	f.close()
+	return values
+
+if __name__ == "__main__":
+	if len(sys.argv) < 3:
+		print(", ".join(n for n, kind in columns(sys.argv[1])))
+	else:
+		values = column(sys.argv[1], sys.argv[2])
+		print("%d values, mean %g" % (len(values), sum(values) / max(len(values), 1)))
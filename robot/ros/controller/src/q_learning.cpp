@@ -16,6 +16,7 @@
 #include <sensor_msgs/Imu.h>
 #include <tf/LinearMath/Matrix3x3.h>
 #include <string>
+#include <fstream>
 #include <sstream>
 #include <stdlib.h>
 #include <iostream>
@@ -34,11 +35,42 @@
 #include <time.h>
 #include <cmath>
 #include <algorithm>
+#include <memory>
+
+#include <rl/q_table.hpp>
+#include <rl/q_value.hpp>
+#include <rl/sparse_q_table.hpp>
+#include <rl/random.hpp>
+#include <rl/discretize.hpp>
+#include <rl/dyna_model.hpp>
+#include <rl/counted_q_table.hpp>
+#include <rl/convergence_detector.hpp>
+#include <rl/checkpoint.hpp>
+#include <rl/trace.hpp>
 
 //params for q-learning
 #define EPSILON 0.6
 #define ALPHA 0.6
 #define GAMMA 0.6
+// Dyna-Q updates from the model of past transitions after every real one, 0 turns planning off
+#ifndef PLANNING_STEPS
+#define PLANNING_STEPS 10
+#endif
+// learning rate 1 / visits^RATE_EXPONENT of each state action pair, down to MIN_ALPHA. 0 keeps ALPHA
+// throughout, the default: with epsilon greedy exploration the decaying rate learned slower than the constant
+// one (countGridWorld), and every extra episode on the robot is a fall
+#ifndef RATE_EXPONENT
+#define RATE_EXPONENT 0
+#endif
+// well below ALPHA, or the schedule is over after a handful of visits
+#ifndef MIN_ALPHA
+#define MIN_ALPHA 0.02
+#endif
+// weight of the UCB bonus when actions are picked by visit counts, 0 explores epsilon greedy.
+// Needs the dense table, the sparse one keeps no counts
+#ifndef UCB_C
+#define UCB_C 0
+#endif
 
 #define FREQUENCY 50
 #define RL_DELTA 0.02
@@ -49,6 +81,8 @@
 #define PITCH_FIX 5.5 
 // maximum pitch angle for the robot to stop
 #define PITCH_THRESHOLD 6
+// after a fall the motors stay off until the robot is stood back up within this pitch angle
+#define RESTART_PITCH 1
 
 #define ACTIONS 7
 #define ACTIONS_HALF 3
@@ -59,6 +93,18 @@
 float actions[ACTIONS] =  {-45, -30,-15,  0, 15,  30, 45}; 
 
 #define MAX_EPISODE 150
+// stop before MAX_EPISODE once no greedy action has changed for CONVERGENCE_WINDOW episodes and no Q value
+// moved by more than CONVERGENCE_TOLERANCE in them. 0 always runs MAX_EPISODE
+#ifndef CONVERGENCE_WINDOW
+#define CONVERGENCE_WINDOW 10
+#endif
+#ifndef CONVERGENCE_TOLERANCE
+#define CONVERGENCE_TOLERANCE 1.0
+#endif
+// episodes between checkpoints, when the checkpoint_file parameter is set
+#ifndef CHECKPOINT_EVERY
+#define CHECKPOINT_EVERY 5
+#endif
 
 // 2D state space
 #define STATE_NUM_PHI 11
@@ -91,11 +137,12 @@ class Controller
 		double roll;
 		double pitch;
 		double yaw;
-		double pitch_dot;
+		double pitch_dot_imu;
+		// off after a fall, until the robot is upright again
+		bool motors;
 
 		//Other
 		int episodes;
-		int time_steps;
 };
 
 
@@ -106,8 +153,9 @@ Controller::Controller()
 	:	roll(0.0)
 	    ,	pitch(0.0)
 	    ,	yaw(0.0)
+	    ,	pitch_dot_imu(0.0)
+	    ,	motors(false)
 	    ,   episodes(0)
-	    ,   time_steps(0)
 {
 	sub_imu = n.subscribe("imu/data", 1000, &Controller::IMU_callback, this);
 }
@@ -129,8 +177,8 @@ void Controller::IMU_callback(const sensor_msgs::Imu::ConstPtr& msg)
 	tf::Quaternion q(msg->orientation.x, msg->orientation.y, msg->orientation.z, msg->orientation.w);
 	tf::Matrix3x3(q).getRPY(roll, pitch, yaw);
 	pitch = pitch*(180/M_PI) - PITCH_FIX;
-	pitch_dot_imu_rad = (msg->angular_velocity.x);
-	pitch_dot = -pitch_dot_imu_rad*(180/M_PI);
+	double pitch_dot_imu_rad = (msg->angular_velocity.x);
+	pitch_dot_imu = -pitch_dot_imu_rad*(180/M_PI);
 }		
 
 
@@ -160,13 +208,32 @@ class RL
     float reward_per_ep;
     int running_avg_cntr;
     float pitch_dot_filtered;	
-    std::vector<std::vector<float> > Q;
+#ifdef SPARSE_Q_TABLE
+    // rows only for visited states, for state spaces with more dimensions than pitch and pitch rate
+    SparseQTable<ACTIONS, q_value_t> Q;
+#else
+    // visit counts next to the Q values, for the learning rate and UCB exploration
+    CountedQTable<(STATE_NUM_PHI+1)*(STATE_NUM_PHI_D+1), ACTIONS, q_value_t> Q;
+#endif
+    // past transitions, replayed between real steps
+    dyna_model model;
+    // how much the real updates still change Q, episode by episode
+    convergence_detector convergence;
+    // actions choose_action picked from in current_state, the ones whose greedy changes count
+    action_mask_t legal_actions;
+    // the run so far, written from a thread of its own every CHECKPOINT_EVERY episodes
+    checkpoint snapshot;
+    std::unique_ptr<checkpoint_writer> checkpoints;
+    // every transition and its TD error, when the trace_file parameter is set. Far smaller than the
+    // State messages of a rosbag, and one column can be read without the others
+    trace_writer trace;
     ros::Publisher q_state_publisher;
 
     // ros variables
     ros::NodeHandle n;	
     ros::Subscriber sub_q;
     std::deque<float> pitch_dot_data;
+    random_engine rng;
 
     RL();
     ~RL();
@@ -178,6 +245,9 @@ class RL
     void read_model(void);
     void Q_callback(const q_model_install::Q_state::ConstPtr& q_model);
     float running_avg_pitch_dot(void);
+    void next_ep(float);
+    void save(checkpoint &) const;
+    bool load(const checkpoint &);
 };
 
 /**
@@ -185,12 +255,17 @@ class RL
 	Initalise everything
 */
 RL::RL()
-  :  Q((STATE_NUM_PHI+1)*(STATE_NUM_PHI_D+1), std::vector<float>(ACTIONS,0)), 
+  :  Q(0), 
      episode_num(0), time_steps(0), wins(0),
      loses(0), discount_factor(GAMMA), alpha(ALPHA),
      epsilon(EPSILON), pitch_dot(0.0), prev_pitch(0.0),
-     reward_per_ep(0.0), pitch_dot_data(RUNNING_AVG, 0.0), running_avg_cntr(0)
-
+     reward_per_ep(0.0), pitch_dot_data(RUNNING_AVG, 0.0), running_avg_cntr(0),
+     rng(time(NULL)),
+     model((STATE_NUM_PHI+1)*(STATE_NUM_PHI_D+1), ACTIONS),
+     convergence(CONVERGENCE_WINDOW, CONVERGENCE_TOLERANCE),
+     legal_actions(allActions(ACTIONS))
+{
+}
 
 /**
 	Destructor
@@ -199,6 +274,57 @@ RL::~RL()
 {
 }
 
+/**
+	Fill snapshot with everything the run needs to go on: the table, the model, the convergence window,
+	the engine and the counters
+*/
+void RL::save(checkpoint &snapshot) const
+{
+	run_state run = {(uint64_t)episode_num, 0, (uint32_t)wins, (uint32_t)loses, epsilon, alpha};
+	snapshot.clear();
+	snapshot.add(CHECKPOINT_RUN, &run, sizeof(run));
+#ifndef SPARSE_Q_TABLE
+	snapshot.addTable(CHECKPOINT_Q, Q);
+	snapshot.addVisits(CHECKPOINT_VISITS, Q);
+#endif
+	snapshot.addEngine(CHECKPOINT_AGENT_RNG, rng);
+	model.save(snapshot);
+	convergence.save(snapshot);
+}
+
+/**
+	Go on from a snapshot filled by save. Returns false if it is not of this controller, which is then left
+	as it was: every section is restored into a copy first
+*/
+bool RL::load(const checkpoint &snapshot)
+{
+	run_state run;
+	decltype(Q) table(Q);
+	random_engine engine = rng;
+	dyna_model restored_model = model;
+	convergence_detector restored_convergence = convergence;
+	if (!snapshot.get(CHECKPOINT_RUN, &run, sizeof(run)) ||
+#ifndef SPARSE_Q_TABLE
+	    !snapshot.getTable(CHECKPOINT_Q, table) || !snapshot.getVisits(CHECKPOINT_VISITS, table) ||
+#endif
+	    !snapshot.getEngine(CHECKPOINT_AGENT_RNG, engine) || !restored_model.load(snapshot) ||
+	    !restored_convergence.load(snapshot))
+	{
+		return false;
+	}
+	Q = table;
+	rng = engine;
+	model = restored_model;
+	convergence = restored_convergence;
+	episode_num = run.episode;
+	wins = run.wins;
+	loses = run.loses;
+	epsilon = run.epsilon;
+	alpha = run.alpha;
+	msg.episodes = episode_num;
+	return true;
+}
+
 /**
 	Use a running average filter on the pitch velocity
 */
@@ -243,6 +369,7 @@ float RL::get_reward(float pitch, float pitch_dot_imu)
 */
 char RL::choose_action(char)
 {
+	return 0;
 }
 
 /**
@@ -254,22 +381,39 @@ void RL::TD_update(char curr_state, int action, char next_state, float reward)
 	float td_target;
 	float td_error;
 	float Q_val;
+	float rate;
 
 	// get index value of Q next_state row with max reward value
-	max_action_idx = distance(Q[next_state].begin(), max_element(Q[next_state].begin(), Q[next_state].end()));
+	max_action_idx = Q.argmax(next_state);
 
 	// compute update and write to Q at current state
 	td_target = reward + discount_factor*Q[next_state][max_action_idx];
 	td_error = td_target - Q[curr_state][action];
-	Q[curr_state][action]+= td_error*alpha;
+#ifdef SPARSE_Q_TABLE
+	rate = alpha;
+#else
+	unsigned int visits = Q.visit(curr_state, action);
+	rate = RATE_EXPONENT > 0 ? visitRate(visits, RATE_EXPONENT, MIN_ALPHA) : alpha;
+#endif
+	convergence.update(Q, curr_state, legal_actions, action, td_error*rate);
+	if (trace.isOpen())
+	{
+		trace.record(time_steps, curr_state, action, reward, next_state, td_error, false);
+	}
 
 	// collect all data 
 	msg.max_action_idx = max_action_idx;
 	msg.td_target = td_target;
 	msg.td_error = td_error;
 	msg.td_update = Q[curr_state][action];
-	msg.alpha = alpha;
+	msg.alpha = rate;
 	msg.discount_factor = discount_factor;    
+
+	// remember the transition and replay past ones, each real step on the robot is expensive. The replayed
+	// updates take the rate of this real one so planning does not outweigh the decaying real updates
+	td_parameters params = {rate, discount_factor};
+	model.observe(curr_state, action, next_state, reward, false);
+	model.plan(Q, PLANNING_STEPS, params);
 }
 
 
@@ -278,56 +422,35 @@ void RL::TD_update(char curr_state, int action, char next_state, float reward)
 */
 char RL::get_state(float pitch_, float pitch_dot_)
 {
-  int i, j;
-  i = 0;
-  j = 0;
-
-  // find what pitch angle state its in
-  for (int phi_idx = 0; phi_idx < STATE_NUM_PHI; phi_idx++)
-  {
-    if (pitch_ <= phi_states[phi_idx])
-    {
-      i = phi_idx;
-      break;
-    }else if (pitch_ > phi_states[STATE_NUM_PHI - 1])
-    {
-      i = STATE_NUM_PHI;
-      break;
-     }
-   }
-
-  // find what pitch angular velocity state its in
-  for (int phi_d_idx = 0; phi_d_idx < STATE_NUM_PHI_D; phi_d_idx++)
-  {
-    if (pitch_dot_ <= phi_d_states[phi_d_idx])
-    {
-      j = phi_d_idx;
-      break;
-    }else if (pitch_dot_ > phi_d_states[STATE_NUM_PHI_D - 1])
-    {
-      j = STATE_NUM_PHI_D;
-      break;
-    }
- }
-
-  return( j + (STATE_NUM_PHI_D + 1) * i);
+  // find what pitch angle and pitch angular velocity state its in
+  return pitchState(pitch_, pitch_dot_, phi_states, phi_d_states);
 }
 
 
 /**
-	Increment episode count and re-initalise everything.
+	Increment episode count and re-initalise everything. pitch is the angle the robot fell at
 */
-void RL::next_ep(void)
+void RL::next_ep(float pitch)
 {
-	ROS_INFO("RESTART SIM - pitch is: %f!", controller.pitch);
+	ROS_INFO("RESTART SIM - pitch is: %f!", pitch);
 	episode_num++;
-	msg.episodes = controller.episode_num;
+	if (CONVERGENCE_WINDOW > 0 && convergence.endEpisode())
+	{
+		ROS_INFO("CONVERGED - no greedy action changed in the last %d episodes", CONVERGENCE_WINDOW);
+	}
+	msg.episodes = episode_num;
+	trace.beginEpisode(episode_num);
+	if (checkpoints && episode_num % CHECKPOINT_EVERY == 0)
+	{
+		save(snapshot);
+		checkpoints->submit(snapshot);
+	}
 
 	//initalise appropriate variables
 	time_steps = 0;
-	controller.prev_pitch = 0;
-	controller.pitch_dot = 0;
-	controller.reward_per_ep = 0;
+	prev_pitch = 0;
+	pitch_dot = 0;
+	reward_per_ep = 0;
 
 	//clear message
 	msg.pitch = 0;
@@ -390,10 +513,10 @@ char QLearning::choose_action(char curr_state)
 	char position_upper_bound;
 
 	// generate random number (0 - 1) to decide whether to explore or exploit
-	random_num = fabs((rand()/(float)(RAND_MAX)));	
+	random_num = rng.uniform();
 	msg.action_choice = random_num;
 
-	this->q_row = Q[curr_state];
+	this->q_row.assign(Q[curr_state], Q[curr_state] + ACTIONS);
 	std::vector<float> q_row_final;  
 
 	// implement 'position bias' that ensures the robot will only choose an action that will turn itself in the correct direction
@@ -408,19 +531,30 @@ char QLearning::choose_action(char curr_state)
 		position_lower_bound = 0;
 		position_upper_bound = ACTION_BIAS + 1;
 	}
+	legal_actions = allActions(position_upper_bound) & ~allActions(position_lower_bound);
+
+#ifndef SPARSE_Q_TABLE
+	if (UCB_C > 0)
+	{
+		// pick by value and how rarely each action in the biased range was tried here
+		float scratch[ACTIONS];
+		msg.random_action = 50;
+		return ucbAction(legal_actions, rowView(Q, curr_state, scratch), Q.visits(curr_state), UCB_C, rng);
+	}
+#endif
 
 	// explore or exploit
 	if (random_num < epsilon)
 	{
 		// explore
-		random_choice = rand()%(ACTIONS_HALF) + position_bias;
+		random_choice = rng.below(ACTIONS_HALF) + position_bias;
 		msg.random_action = random_choice;
 		return random_choice;
 	}
 	else
 	{
 		//exploit
-		this->q_row = Q[curr_state];
+		this->q_row.assign(Q[curr_state], Q[curr_state] + ACTIONS);
 		std::vector<float>::const_iterator first  = q_row.begin() + position_lower_bound;
 		std::vector<float>::const_iterator end  = q_row.begin() + position_upper_bound;
 		std::vector<float> q_row_final(first, end);
@@ -458,9 +592,62 @@ int main(int argc, char **argv)
 	char state;
 	float reward;
     std_msgs::Int16 pwm_msg;
-	double restart_delta_prev, restart_delta, epsilon_delta_prev, epsilon_delta;
+	double restart_delta_prev = 0, restart_delta, epsilon_delta_prev, epsilon_delta = 0;
 
 	QLearning controller;
+
+	// seed exploration, a fixed rl_seed replays the same run
+	int rl_seed;
+	n.param("rl_seed", rl_seed, (int)time(NULL));
+	controller.rng.seed(rl_seed);
+	controller.model.seed(rl_seed, 1);
+
+	// go on from the last checkpoint, and keep writing them, when a checkpoint file is given
+	std::string checkpoint_file;
+	n.param<std::string>("checkpoint_file", checkpoint_file, "");
+#ifdef SPARSE_Q_TABLE
+	if (!checkpoint_file.empty())
+	{
+		ROS_WARN("checkpoints hold dense Q tables only, not checkpointing the sparse table");
+		checkpoint_file.clear();
+	}
+#endif
+	if (!checkpoint_file.empty())
+	{
+		if (controller.snapshot.read(checkpoint_file) && controller.load(controller.snapshot))
+		{
+			ROS_INFO("resuming from %s after %d episodes", checkpoint_file.c_str(), controller.episode_num);
+		}
+		else if (std::ifstream(checkpoint_file.c_str()))
+		{
+			ROS_WARN("%s is not a checkpoint of this controller, starting a new run without checkpoints so it "
+			         "is not overwritten", checkpoint_file.c_str());
+			checkpoint_file.clear();
+		}
+		else
+		{
+			ROS_INFO("no checkpoint to resume in %s, starting a new run", checkpoint_file.c_str());
+		}
+	}
+	if (!checkpoint_file.empty())
+	{
+		controller.checkpoints.reset(new checkpoint_writer(checkpoint_file));
+	}
+
+	// trace every transition for offline analysis, a new trace every run
+	std::string trace_file;
+	n.param<std::string>("trace_file", trace_file, "");
+	if (!trace_file.empty())
+	{
+		if (controller.trace.open(trace_file))
+		{
+			controller.trace.beginEpisode(controller.episode_num);
+		}
+		else
+		{
+			ROS_WARN("cannot create trace %s", trace_file.c_str());
+		}
+	}
 	
 
 	// loop until stopped
@@ -478,7 +665,7 @@ int main(int argc, char **argv)
 		  restart_delta = ros::Time::now().toSec();
 		  if (restart_delta - restart_delta_prev > 0.5)
 			{
-				controller.next_ep()
+				controller.next_ep(controller.pitch);
 			}
 			restart_delta_prev = restart_delta;
 	   	    pwm_msg.data = STOP_RPM;
@@ -487,8 +674,26 @@ int main(int argc, char **argv)
 			controller.pitch_dot_data.clear();
 			controller.running_avg_cntr = 0;
 
+			// stop for good once the last episode is over or Q has settled, with the motors already stopped
+			if (controller.episode_num >= MAX_EPISODE || controller.convergence.converged())
+			{
+				ROS_INFO("SIMULATION COMPLETE AT %d EPISODES", controller.episode_num);
+				if (controller.checkpoints)
+				{
+					controller.save(controller.snapshot);
+					controller.checkpoints->submit(controller.snapshot);
+					controller.checkpoints->flush();
+				}
+				break;
+			}
 		}
 
+	// the motors come back on once the robot has been stood back up
+	if (!controller.motors && std::abs(controller.pitch) < RESTART_PITCH)
+	{
+		controller.motors = true;
+	}
+
 	// apply control if segway is still in pitch range
 	if (std::abs(controller.pitch) <= PITCH_THRESHOLD && controller.motors == true)
 	{
@@ -586,13 +791,6 @@ int main(int argc, char **argv)
 	  	    epsilon_delta_prev = epsilon_delta;
 			
 		}
-		
-		// check if times up
-		if (controller.episode_num == MAX_EPISODE)
-		{
-		 	ROS_INFO("SIMULATION COMPLETE AT %d EPISODES", controller.episode_num);
-			pwm_msg.data = STOP_RPM;
-		}
 
 	}	
 	loop_rate.sleep();
@@ -9,7 +9,9 @@
 
 #include "fixedpoint.hpp"
 #include "stdint.h"
+#ifdef ARDUINO
 #include "Arduino.h"
+#endif
 
 /**
   Return a fixed_point_t of two multipled fixed_point_t. Cast inputs as 64bits, multiply and then shift down 8 bits
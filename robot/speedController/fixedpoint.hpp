@@ -8,7 +8,12 @@
   #define HEADER_FIXEDPOINT
 
   
+#ifdef ARDUINO
 #include "Arduino.h"
+#else
+// host build, e.g. the rl_bench micro benchmarks
+#include <stdint.h>
+#endif
 
 typedef signed long fixed_point_t;
 